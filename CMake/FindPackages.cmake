@@ -29,6 +29,18 @@ if(UDT_name)
   include_directories(${${UDT_name}_INCLUDE_DIRS})
 endif()
 
+find_package(hwloc 1.3)
+if(hwloc_FOUND)
+  set(hwloc_name hwloc)
+endif()
+if(HWLOC_FOUND)
+  set(hwloc_name HWLOC)
+endif()
+if(hwloc_name)
+  link_directories(${${hwloc_name}_LIBRARY_DIRS})
+  include_directories(${${hwloc_name}_INCLUDE_DIRS})
+endif()
+
 find_package(Boost 1.41.0 REQUIRED system regex date_time serialization)
 if(Boost_FOUND)
   set(Boost_name Boost)
@@ -56,7 +68,7 @@ if(Lunchbox_name)
 endif()
 
 
-set(COLLAGE_DEPENDS OFED;UDT;Boost;Lunchbox)
+set(COLLAGE_DEPENDS OFED;UDT;hwloc;Boost;Lunchbox)
 
 # Write defines.h and options.cmake
 if(NOT PROJECT_INCLUDE_NAME)
@@ -145,9 +145,9 @@ void Barrier::attach( const UUID& id, const uint32_t instanceID )
     CommandQueue* queue = node->getCommandThreadQueue();
 
     registerCommand( CMD_BARRIER_ENTER,
-                     CmdFunc( this, &Barrier::_cmdEnter ), queue );
+                     CmdFunc( this, &Barrier::_cmdEnter ), queue, true );
     registerCommand( CMD_BARRIER_ENTER_REPLY,
-                     CmdFunc( this, &Barrier::_cmdEnterReply ), queue );
+                     CmdFunc( this, &Barrier::_cmdEnterReply ), queue, true );
 
     if( _impl->masterID == NodeID( ))
         _impl->masterID = node->getNodeID();
@@ -22,176 +22,317 @@
 
 #include "buffer.h"
 #include "bufferListener.h"
+#include "global.h"
 #include "iCommand.h"
 #include "node.h"
 
 #include <lunchbox/atomic.h>
 
+#ifndef _WIN32
+#  include <sys/mman.h>
+#endif
+
 //#define PROFILE
-// 31300 hits, 35 misses, 297640 lookups, 126976b allocated in 31 buffers
-// 31300 hits, 35 misses, 49228 lookups, 135168b allocated in 34 buffers
 
 namespace co
 {
 namespace
 {
-typedef std::vector< Buffer* > Data;
-typedef Data::const_iterator DataCIter;
-
 static const uint32_t _freeShift = 1; // 'size >> shift' buffers can be free
+static const uint32_t _trimInterval = 1024; // compact() calls between trims
+static const size_t _nClasses = 19; // COMMAND_ALLOCSIZE (4KB) ... 1GB
+static const uintptr_t _hugePageSize = 2 * LB_1MB;
 
 #ifdef PROFILE
 static lunchbox::a_int32_t _hits;
 static lunchbox::a_int32_t _misses;
-static lunchbox::a_int32_t _lookups;
 static lunchbox::a_int32_t _allocs;
 static lunchbox::a_int32_t _frees;
 #endif
+
+/** A buffer owned by the cache, linkable into a free list. */
+class CachedBuffer : public Buffer
+{
+public:
+    CachedBuffer( BufferListener* listener, const size_t index_ )
+        : Buffer( listener ), next( 0 ), index( index_ ) {}
+
+    CachedBuffer* next; //!< The next buffer in the free list
+    size_t index; //!< The position in the cache
+};
+
+typedef std::vector< CachedBuffer* > Buffers;
+typedef Buffers::const_iterator BuffersCIter;
+
+/** @return the size of the given class. */
+inline uint64_t _getClassSize( const size_t sizeClass )
+{
+    return uint64_t( COMMAND_ALLOCSIZE ) << sizeClass;
+}
+
+/** @return the smallest class holding size bytes, the last if none does. */
+inline size_t _getAllocClass( const uint64_t size )
+{
+    size_t sizeClass = 0;
+    while( sizeClass < _nClasses - 1 && _getClassSize( sizeClass ) < size )
+        ++sizeClass;
+    return sizeClass;
+}
+
+/** @return the largest class a buffer of the given capacity can serve. */
+inline size_t _getFreeClass( const uint64_t maxSize )
+{
+    size_t sizeClass = 0;
+    while( sizeClass < _nClasses - 1 &&
+           _getClassSize( sizeClass + 1 ) <= maxSize )
+    {
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+/** Advise the kernel to back the buffer memory using huge pages. */
+void _adviseHugePages( const Buffer& buffer )
+{
+#ifdef MADV_HUGEPAGE
+    // madvise needs aligned addresses, leave the partial pages at both ends
+    const uintptr_t data = reinterpret_cast< uintptr_t >( buffer.getData( ));
+    const uintptr_t start = ( data + _hugePageSize - 1 ) & ~(_hugePageSize-1);
+    const uintptr_t end = ( data + buffer.getMaxSize( )) & ~(_hugePageSize-1);
+    if( end <= start )
+        return;
+
+    if( ::madvise( reinterpret_cast< void* >( start ), end - start,
+                   MADV_HUGEPAGE ) != 0 )
+    {
+        LBVERB << "madvise for huge pages failed: " << lunchbox::sysError
+               << std::endl;
+    }
+#else
+    (void)buffer;
+#endif
+}
+
+/**
+ * A free list of one size class.
+ *
+ * Any thread may push released buffers onto the shared stack without locking.
+ * The owning thread takes the whole stack at once into its local list, which
+ * is safe against ABA since single buffers are never popped concurrently.
+ */
+class FreeList
+{
+public:
+    FreeList() : _shared( 0 ), _local( 0 ) {}
+
+    /** Push a released buffer, thread-safe and lock-free. */
+    void push( CachedBuffer* buffer )
+    {
+        CachedBuffer* head;
+        do
+        {
+            head = _shared;
+            buffer->next = head;
+        }
+        while( !_shared.compareAndSwap( head, buffer ));
+    }
+
+    /** @return a free buffer, or 0. Owning thread only. */
+    CachedBuffer* pop()
+    {
+        if( !_local )
+            _local = _takeShared();
+
+        CachedBuffer* buffer = _local;
+        if( buffer )
+            _local = buffer->next;
+        return buffer;
+    }
+
+    /** Forget all free buffers. Owning thread only. */
+    void clear()
+    {
+        _takeShared();
+        _local = 0;
+    }
+
+private:
+    lunchbox::Atomic< CachedBuffer* > _shared;
+    CachedBuffer* _local;
+
+    CachedBuffer* _takeShared()
+    {
+        CachedBuffer* head;
+        do
+        {
+            head = _shared;
+        }
+        while( head && !_shared.compareAndSwap( head, 0 ));
+        return head;
+    }
+};
 }
+
 namespace detail
 {
 class BufferCache : public BufferListener
 {
 public:
     BufferCache( const int32_t minFree )
-            : _minFree( minFree )
+            : _free( 0 )
+            , _minFree( minFree )
+            , _maxFree( minFree )
+            , _calls( 0 )
+            , _freeSize( 0 )
+            , _hugePageMin( uint64_t( Global::getIAttribute(
+                            Global::IATTR_HUGE_PAGE_BUFFER_SIZE )) * LB_1MB )
     {
         LBASSERT( minFree > 1);
-        flush();
     }
 
     ~BufferCache()
     {
-        LBASSERT( _cache.size() == 1 );
-        LBASSERT( _cache.front()->isFree( ));
-
-        delete _cache.front();
-        _cache.clear();
+        LBASSERT( _buffers.empty( ));
     }
 
     void flush()
     {
-        for( DataCIter i = _cache.begin(); i != _cache.end(); ++i )
+        for( BuffersCIter i = _buffers.begin(); i != _buffers.end(); ++i )
         {
-            co::Buffer* buffer = *i;
+            CachedBuffer* buffer = *i;
             //LBASSERTINFO( buffer->isFree(), *buffer );
             delete buffer;
         }
-        LBASSERTINFO( size_t( _free ) == _cache.size(),
-                      size_t( _free ) << " != " << _cache.size() );
-
-        _cache.clear();
-        _cache.push_back( new co::Buffer( this ));
-        _free = 1;
+        LBASSERTINFO( size_t( _free ) == _buffers.size(),
+                      size_t( _free ) << " != " << _buffers.size( ));
+
+        _buffers.clear();
+        for( size_t i = 0; i < _nClasses; ++i )
+            _freeLists[ i ].clear();
+        _free = 0;
+        _freeSize = 0;
         _maxFree = _minFree;
-        _position = _cache.begin();
     }
 
-    BufferPtr newBuffer()
+    BufferPtr newBuffer( const uint64_t size )
     {
-        const uint32_t cacheSize = uint32_t( _cache.size( ));
-        LBASSERTINFO( size_t( _free ) <= cacheSize,
-                      size_t( _free ) << " > " << cacheSize );
-
-        if( _free > 0 )
+        const size_t sizeClass = _getAllocClass( size );
+        CachedBuffer* buffer = _freeLists[ sizeClass ].pop();
+        if( buffer )
         {
-            LBASSERT( cacheSize > 0 );
-
-            const DataCIter end = _position;
-            DataCIter& i = _position;
-
-            for( ++i; i != end; ++i )
-            {
-                if( i == _cache.end( ))
-                    i = _cache.begin();
+            LBASSERT( buffer->isFree( ));
+            LBASSERT( _free > 0 );
+            --_free;
+            _freeSize -= buffer->getMaxSize();
 #ifdef PROFILE
-                ++_lookups;
+            ++_hits;
 #endif
-                co::Buffer* buffer = *i;
-                if( !buffer->isFree( ))
-                    continue;
-
+        }
+        else
+        {
+            buffer = new CachedBuffer( this, _buffers.size( ));
+            _buffers.push_back( buffer );
+            _maxFree = LB_MAX( _minFree,
+                               int32_t( _buffers.size() >> _freeShift ));
 #ifdef PROFILE
-                const long hits = ++_hits;
-                if( (hits%1000) == 0 )
-                {
-                    size_t size = 0;
-                    for( DataCIter j = _cache.begin(); j != _cache.end(); ++j )
-                            size += (*j)->getMaxSize();
-
-                    LBINFO << _hits << "/" << _hits + _misses << " hits, "
-                           << _lookups << " lookups, " << _free << " of "
-                           << _cache.size() << " buffers free (min " << _minFree
-                           << " max " << _maxFree << "), " << _allocs
-                           << " allocs, " << _frees << " frees, "
-                           << size / 1024 << "KB" << std::endl;
-                }
+            ++_misses;
+            ++_allocs;
 #endif
-                --_free;
-                return buffer;
-            }
         }
 
-        const uint32_t add = (cacheSize >> 3) + 1;
-        for( size_t j = 0; j < add; ++j )
-            _cache.push_back( new co::Buffer( this ));
-
-        _free += add - 1;
-        const int32_t num = int32_t( _cache.size() >> _freeShift );
-        _maxFree = LB_MAX( _minFree, num );
-        _position = _cache.begin();
-
-#ifdef PROFILE
-        ++_misses;
-        _allocs += add;
-#endif
-        return _cache.back();
+        const uint64_t capacity = buffer->getMaxSize();
+        buffer->reserve( LB_MAX( size, _getClassSize( sizeClass )));
+        if( _hugePageMin > 0 && buffer->getMaxSize() != capacity &&
+            buffer->getMaxSize() >= _hugePageMin )
+        {
+            _adviseHugePages( *buffer );
+        }
+        return buffer;
     }
 
+    uint64_t getFreeSize() const { return _freeSize; }
+
     void compact()
     {
+        if( ++_calls < _trimInterval )
+            return;
+        _calls = 0;
+
+#ifdef PROFILE
+        uint64_t size = 0;
+        for( BuffersCIter i = _buffers.begin(); i != _buffers.end(); ++i )
+            size += (*i)->getMaxSize();
+        LBINFO << _hits << "/" << _hits + _misses << " hits, " << _free
+               << " of " << _buffers.size() << " buffers free (min "
+               << _minFree << " max " << _maxFree << "), " << _allocs
+               << " allocs, " << _frees << " frees, " << size / 1024 << "KB"
+               << std::endl;
+#endif
         if( _free <= _maxFree )
             return;
 
         const int32_t target = _maxFree >> 1;
         LBASSERT( target > 0 );
-        for( Data::iterator i = _cache.begin(); i != _cache.end(); )
+        trim( target );
+    }
+
+    void trim( const int32_t target )
+    {
+        // release the biggest free buffers first, they cost the most memory
+        for( size_t i = _nClasses; i > 0 && _free > target; --i )
         {
-            const co::Buffer* cmd = *i;
-            if( cmd->isFree( ))
+            FreeList& freeList = _freeLists[ i - 1 ];
+            while( _free > target )
             {
-#  ifdef PROFILE
-                ++_frees;
-#  endif
-                i = _cache.erase( i );
-                delete cmd;
-
-                LBASSERT( _free > 0 );
-                if( --_free <= target )
+                CachedBuffer* buffer = freeList.pop();
+                if( !buffer )
                     break;
+                _remove( buffer );
             }
-            else
-                ++i;
         }
 
-        const int32_t num = int32_t( _cache.size() >> _freeShift );
-        _maxFree = LB_MAX( _minFree, num );
-        _position = _cache.begin();
+        _maxFree = LB_MAX( _minFree, int32_t( _buffers.size() >> _freeShift ));
     }
 
 private:
     friend std::ostream& co::operator << (std::ostream&,const co::BufferCache&);
 
-    Data _cache;
-    DataCIter _position; //!< Last lookup position
+    Buffers _buffers; //!< All buffers owned by the cache
+    FreeList _freeLists[ _nClasses ];
     lunchbox::a_int32_t _free; //!< The current number of free items
 
     const int32_t _minFree;
     int32_t _maxFree; //!< The maximum number of free items
+    uint32_t _calls; //!< compact() calls since the last trim
+    lunchbox::Atomic< uint64_t > _freeSize; //!< The capacity of free items
+    const uint64_t _hugePageMin; //!< Min capacity for huge pages, 0: off
+
+    void _remove( CachedBuffer* buffer )
+    {
+        LBASSERT( buffer->isFree( ));
+        LBASSERT( _buffers[ buffer->index ] == buffer );
+
+        CachedBuffer* last = _buffers.back();
+        _buffers[ buffer->index ] = last;
+        last->index = buffer->index;
+        _buffers.pop_back();
+
+        _freeSize -= buffer->getMaxSize();
+        delete buffer;
+        LBASSERT( _free > 0 );
+        --_free;
+#ifdef PROFILE
+        ++_frees;
+#endif
+    }
 
-    virtual void notifyFree( co::Buffer* )
+    virtual void notifyFree( co::Buffer* buffer )
     {
+        CachedBuffer* cached = static_cast< CachedBuffer* >( buffer );
+        // account before publishing, a concurrent alloc may pop it right away
+        _freeSize += cached->getMaxSize();
         ++_free;
+        _freeLists[ _getFreeClass( cached->getMaxSize( )) ].push( cached );
     }
 };
 }
@@ -218,10 +359,9 @@ BufferPtr BufferCache::alloc( const uint64_t size )
     LBASSERTINFO( size < LB_BIT48,
                   "Out-of-sync network stream: buffer size " << size << "?" );
 
-    BufferPtr buffer = _impl->newBuffer();
+    BufferPtr buffer = _impl->newBuffer( size );
     LBASSERT( buffer->getRefCount() == 1 );
 
-    buffer->reserve( size );
     buffer->resize( 0 );
     return buffer;
 }
@@ -231,14 +371,25 @@ void BufferCache::compact()
     _impl->compact();
 }
 
+void BufferCache::trim()
+{
+    LB_TS_SCOPED( _thread );
+    _impl->trim( 0 );
+}
+
+uint64_t BufferCache::getFreeSize() const
+{
+    return _impl->getFreeSize();
+}
+
 std::ostream& operator << ( std::ostream& os, const BufferCache& cache )
 {
-    const Data& buffers = cache._impl->_cache;
+    const Buffers& buffers = cache._impl->_buffers;
     os << lunchbox::disableFlush << "Cache has "
        << buffers.size() - cache._impl->_free << " used buffers:" << std::endl
        << lunchbox::indent << lunchbox::disableHeader;
 
-    for( DataCIter i = buffers.begin(); i != buffers.end(); ++i )
+    for( BuffersCIter i = buffers.begin(); i != buffers.end(); ++i )
     {
         Buffer* buffer = *i;
         if( !buffer->isFree( ))
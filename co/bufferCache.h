@@ -35,6 +35,9 @@ namespace detail { class BufferCache; }
      *
      * Buffers are retained and released whenever they are not directly
      * processed, e.g., when pushed to another thread using a CommandQueue.
+     * Free buffers are kept in power-of-two size classes, from
+     * COMMAND_ALLOCSIZE to 1GB, and may be released from any thread without
+     * locking. Allocation and compaction have to happen in one thread.
      */
     class BufferCache
     {
@@ -42,12 +45,18 @@ namespace detail { class BufferCache; }
         CO_API BufferCache( const int32_t minFree );
         CO_API ~BufferCache();
 
-        /** @return a new buffer. */
+        /** @return a new buffer with at least the given capacity. */
         CO_API BufferPtr alloc( const uint64_t reserve );
 
-        /** Compact buffer if too many commands are free. */
+        /** Periodically release buffers if too many are free. */
         void compact();
 
+        /** Release all free buffers now. */
+        void trim();
+
+        /** @return the capacity of the free buffers in bytes. */
+        uint64_t getFreeSize() const;
+
         /** Flush all allocated buffers. */
         void flush();
 
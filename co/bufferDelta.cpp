@@ -0,0 +1,193 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "bufferDelta.h"
+
+#include <cstring>
+
+namespace co
+{
+namespace
+{
+/**
+ * Unchanged runs shorter than this are sent as part of the changed bytes,
+ * since the run header costs about as much as the bytes saved.
+ */
+static const uint64_t _minRun = 8;
+
+void _writeVarint( lunchbox::Bufferb& buffer, uint64_t value )
+{
+    uint8_t encoded[ 10 ];
+    size_t nBytes = 0;
+    while( value >= 0x80 )
+    {
+        encoded[ nBytes++ ] = uint8_t( value ) | 0x80;
+        value >>= 7;
+    }
+    encoded[ nBytes++ ] = uint8_t( value );
+    buffer.append( encoded, nBytes );
+}
+
+bool _readVarint( const uint8_t*& data, const uint8_t* end, uint64_t& value )
+{
+    value = 0;
+    for( unsigned shift = 0; shift < 64; shift += 7 )
+    {
+        if( data == end )
+            return false;
+
+        const uint8_t byte = *data++;
+        value |= uint64_t( byte & 0x7f ) << shift;
+        if( !( byte & 0x80 ))
+            return true;
+    }
+    return false;
+}
+
+/** @return the number of equal bytes in a and b, starting at a[0], b[0]. */
+uint64_t _countEqual( const uint8_t* a, const uint8_t* b, const uint64_t size )
+{
+    uint64_t i = 0;
+    // OPT: compare eight bytes at a time
+    for( ; i + sizeof( uint64_t ) <= size; i += sizeof( uint64_t ))
+    {
+        uint64_t lhs, rhs;
+        ::memcpy( &lhs, a + i, sizeof( uint64_t ));
+        ::memcpy( &rhs, b + i, sizeof( uint64_t ));
+        if( lhs != rhs )
+            break;
+    }
+    while( i < size && a[i] == b[i] )
+        ++i;
+    return i;
+}
+}
+
+bool encodeDelta( const lunchbox::Bufferb& base, const void* data,
+                  const uint64_t size, const uint64_t maxSize,
+                  lunchbox::Bufferb& delta )
+{
+    startDelta( delta, size );
+    return appendDelta( delta, 0, base.getData(), base.getSize(), data, size,
+                        maxSize );
+}
+
+void startDelta( lunchbox::Bufferb& delta, const uint64_t size )
+{
+    delta.setSize( 0 );
+    _writeVarint( delta, size );
+}
+
+bool appendDelta( lunchbox::Bufferb& delta, uint64_t unchanged,
+                  const void* base, const uint64_t baseSize,
+                  const void* data, const uint64_t size,
+                  const uint64_t maxSize )
+{
+    const uint8_t* const newData = static_cast< const uint8_t* >( data );
+    const uint8_t* const oldData = static_cast< const uint8_t* >( base );
+    const uint64_t common = LB_MIN( size, baseSize );
+
+    if( size == 0 && unchanged > 0 )
+    {
+        _writeVarint( delta, unchanged );
+        _writeVarint( delta, 0 );
+    }
+
+    uint64_t i = 0;
+    while( i < size )
+    {
+        const uint64_t equal = i < common ?
+            _countEqual( newData + i, oldData + i, common - i ) : 0;
+        const uint64_t start = i + equal;
+
+        // changed bytes extend up to the next sufficiently long unchanged run
+        uint64_t end = start;
+        while( end < size )
+        {
+            if( end >= common )
+            {
+                end = size;
+                break;
+            }
+            if( newData[ end ] != oldData[ end ] )
+            {
+                ++end;
+                continue;
+            }
+            const uint64_t run = _countEqual( newData + end, oldData + end,
+                                              LB_MIN( _minRun, common - end ));
+            if( run >= _minRun || end + run == size )
+                break;
+            end += run;
+        }
+
+        _writeVarint( delta, unchanged + equal );
+        _writeVarint( delta, end - start );
+        if( delta.getSize() + end - start >= maxSize )
+            return false;
+        unchanged = 0;
+
+        const uint64_t offset = delta.getSize();
+        delta.resize( offset + end - start );
+        uint8_t* out = delta.getData() + offset;
+        for( uint64_t j = start; j < end; ++j )
+            *out++ = j < common ? newData[j] ^ oldData[j] : newData[j];
+        i = end;
+    }
+    return delta.getSize() < maxSize;
+}
+
+bool applyDelta( lunchbox::Bufferb& data, const void* delta,
+                 const uint64_t size )
+{
+    const uint8_t* in = static_cast< const uint8_t* >( delta );
+    const uint8_t* const end = in + size;
+
+    uint64_t newSize = 0;
+    if( !_readVarint( in, end, newSize ))
+        return false;
+
+    const uint64_t common = LB_MIN( newSize, data.getSize( ));
+    data.resize( newSize );
+    uint8_t* const out = data.getData();
+
+    uint64_t i = 0;
+    while( i < newSize )
+    {
+        uint64_t unchanged = 0;
+        uint64_t changed = 0;
+        if( !_readVarint( in, end, unchanged ) ||
+            !_readVarint( in, end, changed ) ||
+            unchanged > common - LB_MIN( i, common ) ||
+            changed > newSize - i - unchanged ||
+            changed > uint64_t( end - in ))
+        {
+            return false;
+        }
+
+        i += unchanged;
+        for( const uint64_t last = i + changed; i < last; ++i, ++in )
+            out[i] = i < common ? out[i] ^ *in : *in;
+        if( unchanged == 0 && changed == 0 )
+            return false; // no progress
+    }
+    return in == end;
+}
+
+}
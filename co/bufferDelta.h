@@ -0,0 +1,81 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_BUFFERDELTA_H
+#define CO_BUFFERDELTA_H
+
+#include <co/api.h>
+#include <co/types.h>
+#include <lunchbox/buffer.h>
+
+namespace co
+{
+    /**
+     * @internal Binary delta encoding of two versions of a buffer.
+     *
+     * The delta is the run-length encoded XOR of the new data against the
+     * base, with the base implicitly zero-extended to the new size. It
+     * consists of the varint-encoded new size, followed by (unchanged,
+     * changed) varint pairs each followed by the XOR'ed changed bytes.
+     *
+     * Deltas may also be built piecewise with startDelta() and appendDelta(),
+     * skipping parts of the data known to be unchanged without reading them.
+     */
+    //@{
+    /**
+     * Encode the difference of data against base into delta.
+     *
+     * The encoding is aborted as soon as the delta reaches maxSize.
+     *
+     * @return true if the delta is smaller than maxSize, false otherwise.
+     */
+    CO_API bool encodeDelta( const lunchbox::Bufferb& base, const void* data,
+                             const uint64_t size, const uint64_t maxSize,
+                             lunchbox::Bufferb& delta );
+
+    /** Start a piecewise delta of data of the given size. */
+    CO_API void startDelta( lunchbox::Bufferb& delta, const uint64_t size );
+
+    /**
+     * Append the difference of a part of the data against the base part at
+     * the same offset to a delta started with startDelta().
+     *
+     * The unchanged bytes preceding the part are encoded first, appending an
+     * empty part encodes only them. The base part may be shorter than the
+     * data part, and is implicitly zero-extended.
+     *
+     * @return true if the delta is smaller than maxSize, false otherwise.
+     */
+    CO_API bool appendDelta( lunchbox::Bufferb& delta, const uint64_t unchanged,
+                             const void* base, const uint64_t baseSize,
+                             const void* data, const uint64_t size,
+                             const uint64_t maxSize );
+
+    /**
+     * Apply a delta created by encodeDelta() to the base, in place.
+     *
+     * @return false if the delta is malformed, in which case the content of
+     *         data is undefined.
+     */
+    CO_API bool applyDelta( lunchbox::Bufferb& data, const void* delta,
+                            const uint64_t size );
+    //@}
+}
+
+#endif // CO_BUFFERDELTA_H
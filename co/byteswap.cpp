@@ -0,0 +1,174 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "byteswap.h"
+
+#include <lunchbox/bitOperation.h>
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#  define CO_BYTESWAP_SSE2
+#  include <emmintrin.h>
+#endif
+#ifdef CO_BYTESWAP_AVX2
+// AVX2 is selected at runtime, the library is not compiled for it. The
+// compiler support for this is checked in CMakeLists.txt.
+#  include <immintrin.h>
+#endif
+
+namespace co
+{
+namespace
+{
+template< class T > void _swapScalar( T* data, const uint64_t num )
+{
+    for( uint64_t i = 0; i < num; ++i )
+        lunchbox::byteswap( data[i] );
+}
+
+#ifdef CO_BYTESWAP_SSE2
+// SSE2 has no byte shuffle: swap 16 bit words, then the bytes within them
+inline __m128i _swapBytes( const __m128i value )
+{
+    return _mm_or_si128( _mm_slli_epi16( value, 8 ),
+                         _mm_srli_epi16( value, 8 ));
+}
+#endif
+
+// The masks are the in-lane byte shuffles for AVX2, repeated for both lanes
+struct Swap16
+{
+    static const uint8_t mask[32];
+#ifdef CO_BYTESWAP_SSE2
+    static __m128i swap( const __m128i value ) { return _swapBytes( value ); }
+#endif
+};
+const uint8_t Swap16::mask[32] = { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13,
+                                   12, 15, 14, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8,
+                                   11, 10, 13, 12, 15, 14 };
+
+struct Swap32
+{
+    static const uint8_t mask[32];
+#ifdef CO_BYTESWAP_SSE2
+    static __m128i swap( __m128i value )
+    {
+        value = _mm_shufflelo_epi16( value, _MM_SHUFFLE( 2, 3, 0, 1 ));
+        value = _mm_shufflehi_epi16( value, _MM_SHUFFLE( 2, 3, 0, 1 ));
+        return _swapBytes( value );
+    }
+#endif
+};
+const uint8_t Swap32::mask[32] = { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15,
+                                   14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10,
+                                   9, 8, 15, 14, 13, 12 };
+
+struct Swap64
+{
+    static const uint8_t mask[32];
+#ifdef CO_BYTESWAP_SSE2
+    static __m128i swap( __m128i value )
+    {
+        value = _mm_shufflelo_epi16( value, _MM_SHUFFLE( 0, 1, 2, 3 ));
+        value = _mm_shufflehi_epi16( value, _MM_SHUFFLE( 0, 1, 2, 3 ));
+        return _swapBytes( value );
+    }
+#endif
+};
+const uint8_t Swap64::mask[32] = { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11,
+                                   10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14,
+                                   13, 12, 11, 10, 9, 8 };
+
+#ifdef CO_BYTESWAP_SSE2
+/** @return the number of elements processed. */
+template< class T, class K > uint64_t _swapSSE2( T* data, const uint64_t num )
+{
+    const uint64_t step = sizeof( __m128i ) / sizeof( T );
+    uint64_t i = 0;
+    for( ; i + step <= num; i += step )
+    {
+        __m128i* ptr = reinterpret_cast< __m128i* >( data + i );
+        _mm_storeu_si128( ptr, K::swap( _mm_loadu_si128( ptr )));
+    }
+    return i;
+}
+#endif
+
+#ifdef CO_BYTESWAP_AVX2
+bool _hasAVX2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" );
+}
+const bool _useAVX2 = _hasAVX2();
+
+/** @return the number of bytes processed. */
+__attribute__(( target( "avx2" )))
+uint64_t _swapAVX2( uint8_t* data, const uint64_t nBytes, const uint8_t* mask_ )
+{
+    const __m256i mask =
+        _mm256_loadu_si256( reinterpret_cast< const __m256i* >( mask_ ));
+    uint64_t i = 0;
+    for( ; i + sizeof( __m256i ) <= nBytes; i += sizeof( __m256i ))
+    {
+        __m256i* ptr = reinterpret_cast< __m256i* >( data + i );
+        _mm256_storeu_si256( ptr,
+                             _mm256_shuffle_epi8( _mm256_loadu_si256( ptr ),
+                                                  mask ));
+    }
+    return i;
+}
+#endif
+
+template< class T, class K > void _swap( void* data_, const uint64_t num )
+{
+    T* data = reinterpret_cast< T* >( data_ );
+    uint64_t done = 0;
+#ifdef CO_BYTESWAP_AVX2
+    if( _useAVX2 )
+        done = _swapAVX2( reinterpret_cast< uint8_t* >( data ),
+                          num * sizeof( T ), K::mask ) / sizeof( T );
+#endif
+#ifdef CO_BYTESWAP_SSE2
+    done += _swapSSE2< T, K >( data + done, num - done );
+#endif
+    _swapScalar( data + done, num - done );
+}
+}
+
+void byteswap16( void* data, const uint64_t num )
+{
+    _swap< uint16_t, Swap16 >( data, num );
+}
+
+void byteswap32( void* data, const uint64_t num )
+{
+    _swap< uint32_t, Swap32 >( data, num );
+}
+
+void byteswap64( void* data, const uint64_t num )
+{
+    _swap< uint64_t, Swap64 >( data, num );
+}
+
+void byteswap128( void* data, const uint64_t num )
+{
+    byteswap64( data, num << 1 );
+}
+
+}
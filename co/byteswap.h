@@ -0,0 +1,44 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_BYTESWAP_H
+#define CO_BYTESWAP_H
+
+#include <co/api.h>
+#include <co/types.h>
+
+namespace co
+{
+    /**
+     * @internal Bulk endian conversion of arrays.
+     *
+     * The functions convert num elements in place, using SSE2 or AVX2 kernels
+     * where available and a scalar fallback otherwise. The result is identical
+     * to calling lunchbox::byteswap() on each element. 128 bit values are
+     * swapped as two 64 bit halves, as done by lunchbox::byteswap.
+     */
+    //@{
+    CO_API void byteswap16( void* data, const uint64_t num );
+    CO_API void byteswap32( void* data, const uint64_t num );
+    CO_API void byteswap64( void* data, const uint64_t num );
+    CO_API void byteswap128( void* data, const uint64_t num );
+    //@}
+}
+
+#endif // CO_BYTESWAP_H
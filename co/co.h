@@ -66,6 +66,7 @@
 
 #include <co/barrier.h>
 #include <co/buffer.h>
+#include <co/commit.h>
 #include <co/connectionDescription.h>
 #include <co/connection.h>
 #include <co/connectionSet.h>
@@ -86,6 +87,7 @@
 #include <co/objectOCommand.h>
 #include <co/oCommand.h>
 #include <co/serializable.h>
+#include <co/sync.h>
 #include <co/zeroconf.h>
 #include <lunchbox/lunchbox.h>
 
@@ -0,0 +1,152 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "commandPool.h"
+
+#include "commandFunc.h"
+#include "commandQueue.h"
+#include "iCommand.h"
+#include "log.h"
+#include "objectICommand.h"
+#include "worker.h"
+
+#include <sstream>
+
+namespace co
+{
+namespace detail
+{
+class PoolWorker : public Worker
+{
+public:
+    PoolWorker( const std::string& name ) : _name( name ), _stopped( false ) {}
+
+    bool cmdStop( ICommand& )
+    {
+        _stopped = true;
+        return true;
+    }
+
+protected:
+    virtual bool init()
+    {
+        setName( _name );
+        return true;
+    }
+
+    virtual bool stopRunning() { return _stopped; }
+
+private:
+    const std::string _name;
+    bool _stopped;
+};
+}
+
+CommandPool::CommandPool()
+    : _running( 0 )
+{}
+
+CommandPool::~CommandPool()
+{
+    LBASSERT( !_running );
+    _clear();
+}
+
+bool CommandPool::start( const uint32_t nThreads, const std::string& name )
+{
+    LBASSERT( !_running );
+    _clear();
+
+    for( uint32_t i = 0; i < nThreads; ++i )
+    {
+        std::ostringstream workerName;
+        workerName << "P" << i << " " << name;
+
+        detail::PoolWorker* worker = new detail::PoolWorker( workerName.str());
+        _workers.push_back( worker );
+        if( !worker->start( ))
+        {
+            LBWARN << "Can't start command pool worker " << i << std::endl;
+            _running = 1;
+            stop( ICommand( ));
+            return false;
+        }
+    }
+
+    _running = _workers.empty() ? 0 : 1;
+    return true;
+}
+
+void CommandPool::stop( const ICommand& command )
+{
+    if( !_running )
+        return;
+
+    // Object commands keep going to their worker until all workers are
+    // joined, the command thread would execute them out of order. Commands
+    // queued after the stop command are dropped, like on the command thread.
+    for( Workers::const_iterator i = _workers.begin(); i != _workers.end(); ++i)
+    {
+        detail::PoolWorker* worker = *i;
+        if( !worker->isRunning( ))
+            continue;
+
+        ICommand stopCommand( command );
+        stopCommand.setDispatchFunction( CommandFunc< detail::PoolWorker >(
+                                             worker,
+                                             &detail::PoolWorker::cmdStop ));
+        worker->getWorkerQueue()->push( stopCommand );
+    }
+
+    for( Workers::const_iterator i = _workers.begin(); i != _workers.end(); ++i)
+        if( (*i)->isRunning( ))
+            LBCHECK( (*i)->join( ));
+    _running = 0;
+}
+
+void CommandPool::push( const ICommand& command )
+{
+    _getQueue( command )->push( command );
+}
+
+void CommandPool::pushFront( const ICommand& command )
+{
+    _getQueue( command )->pushFront( command );
+}
+
+CommandQueue* CommandPool::_getQueue( const ICommand& command )
+{
+    LBASSERT( _running );
+    LBASSERT( command.getType() == COMMANDTYPE_OBJECT );
+
+    // All instances of an object share a worker, since commands for all
+    // instances are ordered with commands for a single instance.
+    const UUID& id = ObjectICommand( command ).getObjectID();
+    const size_t index = size_t( id.high() ^ id.low( )) % _workers.size();
+    return _workers[ index ]->getWorkerQueue();
+}
+
+void CommandPool::_clear()
+{
+    for( Workers::const_iterator i = _workers.begin(); i != _workers.end(); ++i)
+        delete *i;
+    _workers.clear();
+}
+
+}
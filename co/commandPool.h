@@ -0,0 +1,79 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_COMMANDPOOL_H
+#define CO_COMMANDPOOL_H
+
+#include <co/types.h>
+
+#include <lunchbox/atomic.h>      // member
+#include <lunchbox/nonCopyable.h> // base class
+
+#include <vector>
+
+namespace co
+{
+namespace detail { class PoolWorker; }
+
+    /**
+     * @internal A pool of worker threads executing object commands.
+     *
+     * The commands of one object are always executed by the same worker, in
+     * the order they were queued, while different objects proceed in
+     * parallel. Object command handlers may thus keep relying on running in
+     * a single thread.
+     */
+    class CommandPool : public lunchbox::NonCopyable
+    {
+    public:
+        CommandPool();
+        ~CommandPool();
+
+        /** Start the given number of workers, named after name. */
+        bool start( const uint32_t nThreads, const std::string& name );
+
+        /**
+         * Stop all workers after their queued commands.
+         *
+         * Commands are routed to the workers until all of them are joined.
+         *
+         * @param command a command to be copied as the stop command.
+         */
+        void stop( const ICommand& command );
+
+        /** @return true if the workers accept commands. */
+        bool isRunning() const { return _running; }
+
+        /** Queue an object command to the worker of its object. */
+        void push( const ICommand& command );
+
+        /** Queue an object command to the front of its worker's queue. */
+        void pushFront( const ICommand& command );
+
+    private:
+        typedef std::vector< detail::PoolWorker* > Workers;
+        Workers _workers;
+        lunchbox::a_int32_t _running;
+
+        CommandQueue* _getQueue( const ICommand& command );
+        void _clear();
+    };
+}
+
+#endif // CO_COMMANDPOOL_H
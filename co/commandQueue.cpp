@@ -23,7 +23,10 @@
 #include "exception.h"
 #include "node.h"
 
-#include <lunchbox/mtQueue.h>
+#include <lunchbox/atomic.h>
+#include <lunchbox/condition.h>
+
+#include <deque>
 
 namespace co
 {
@@ -32,8 +35,56 @@ namespace detail
 class CommandQueue
 {
 public:
-    /** Thread-safe buffer queue. */
-    lunchbox::MTQueue< co::ICommand > commands;
+    typedef std::deque< co::ICommand > Commands;
+
+    CommandQueue() : nPriority( 0 ) {}
+
+    /** Protects the queues and signals new commands. */
+    mutable lunchbox::Condition condition;
+
+    Commands commands;
+    Commands priorityCommands; //!< executed before commands
+    lunchbox::a_int32_t nPriority; //!< priority commands, read without lock
+
+    bool isEmpty() const
+        { return commands.empty() && priorityCommands.empty(); }
+
+    /** @return the lane for the command, counting priority commands. */
+    Commands& getQueue( const co::ICommand& command )
+    {
+        if( !command.isPriority( ))
+            return commands;
+        ++nPriority;
+        return priorityCommands;
+    }
+
+    /** Wait for a command, with the condition locked. */
+    bool wait( const uint32_t timeout )
+    {
+        while( isEmpty( ))
+        {
+            if( timeout == LB_TIMEOUT_INDEFINITE )
+                condition.wait();
+            else if( !condition.timedWait( timeout ))
+                return false;
+        }
+        return true;
+    }
+
+    /** Pop the next command, with the condition locked. */
+    co::ICommand pop()
+    {
+        Commands& queue = priorityCommands.empty() ? commands :
+                                                     priorityCommands;
+        if( queue.empty( ))
+            return co::ICommand();
+
+        const co::ICommand command = queue.front();
+        queue.pop_front();
+        if( &queue == &priorityCommands )
+            --nPriority;
+        return command;
+    }
 };
 }
 
@@ -53,55 +104,108 @@ void CommandQueue::flush()
     if( !isEmpty( ))
         LBWARN << "Flushing non-empty command queue" << std::endl;
 
+    _impl->condition.lock();
     _impl->commands.clear();
+    _impl->priorityCommands.clear();
+    _impl->nPriority = 0;
+    _impl->condition.unlock();
 }
 
 bool CommandQueue::isEmpty() const
 {
-    return _impl->commands.isEmpty();
+    _impl->condition.lock();
+    const bool empty = _impl->isEmpty();
+    _impl->condition.unlock();
+    return empty;
 }
 
 size_t CommandQueue::getSize() const
 {
-    return _impl->commands.getSize();
+    _impl->condition.lock();
+    const size_t size = _impl->commands.size() +
+                        _impl->priorityCommands.size();
+    _impl->condition.unlock();
+    return size;
 }
 
 void CommandQueue::push( const ICommand& command )
 {
-    _impl->commands.push( command );
+    _impl->condition.lock();
+    _impl->getQueue( command ).push_back( command );
+    _impl->condition.signal();
+    _impl->condition.unlock();
 }
 
 void CommandQueue::pushFront( const ICommand& command )
 {
     LBASSERT( command.isValid( ));
-    _impl->commands.pushFront( command );
+    _impl->condition.lock();
+    _impl->getQueue( command ).push_front( command );
+    _impl->condition.signal();
+    _impl->condition.unlock();
 }
 
 ICommand CommandQueue::pop( const uint32_t timeout )
 {
     LB_TS_THREAD( _thread );
 
-    ICommand command;
-    if( !_impl->commands.timedPop( timeout, command ))
+    _impl->condition.lock();
+    if( !_impl->wait( timeout ))
+    {
+        _impl->condition.unlock();
         throw Exception( Exception::TIMEOUT_COMMANDQUEUE );
+    }
 
+    const ICommand command = _impl->pop();
+    _impl->condition.unlock();
     return command;
 }
 
 ICommands CommandQueue::popAll( const uint32_t timeout )
 {
-    const ICommands& result = _impl->commands.timedPop( timeout );
-
-    if( result.empty( ))
+    _impl->condition.lock();
+    if( !_impl->wait( timeout ))
+    {
+        _impl->condition.unlock();
         throw Exception( Exception::TIMEOUT_COMMANDQUEUE );
+    }
+
+    // priority commands first, each lane in order
+    ICommands result( _impl->priorityCommands.begin(),
+                      _impl->priorityCommands.end( ));
+    result.insert( result.end(), _impl->commands.begin(),
+                   _impl->commands.end( ));
+    _impl->priorityCommands.clear();
+    _impl->commands.clear();
+    _impl->nPriority = 0;
+    _impl->condition.unlock();
     return result;
 }
 
 ICommand CommandQueue::tryPop()
 {
     LB_TS_THREAD( _thread );
+    _impl->condition.lock();
+    const ICommand command = _impl->pop();
+    _impl->condition.unlock();
+    return command;
+}
+
+ICommand CommandQueue::tryPopPriority()
+{
+    // called after each command, avoid locking for the usually empty lane
+    if( _impl->nPriority == 0 )
+        return ICommand();
+
+    _impl->condition.lock();
     ICommand command;
-    _impl->commands.tryPop( command );
+    if( !_impl->priorityCommands.empty( ))
+    {
+        command = _impl->priorityCommands.front();
+        _impl->priorityCommands.pop_front();
+        --_impl->nPriority;
+    }
+    _impl->condition.unlock();
     return command;
 }
 
@@ -28,7 +28,12 @@ namespace co
 {
 namespace detail { class CommandQueue; }
 
-    /** A thread-safe queue for ICommand buffers. */
+    /**
+     * A thread-safe queue for ICommand buffers.
+     *
+     * Priority commands, see Dispatcher::registerCommand(), are queued in a
+     * separate lane which is always popped first.
+     */
     class CommandQueue : public lunchbox::NonCopyable
     {
     public:
@@ -79,6 +84,15 @@ namespace detail { class CommandQueue; }
          */
         CO_API virtual ICommand tryPop();
 
+        /**
+         * Try to pop a priority command from the queue.
+         *
+         * @return the next priority command, or an invalid command if none is
+         *         queued.
+         * @version 1.0
+         */
+        CO_API virtual ICommand tryPopPriority();
+
         /**
          * @return <code>true</code> if the command queue is empty,
          *         <code>false</code> if not.
@@ -46,6 +46,9 @@ namespace co
 
     /** @internal Minimal allocation size of a packet. */
     static const size_t COMMAND_ALLOCSIZE = 4096; // Bigger than minSize!
+
+    /** @internal Chunk count flag in the data header for compact encoding */
+    static const uint32_t DATA_CHUNKS_COMPACT = 0x80000000u;
 }
 
 namespace lunchbox
@@ -0,0 +1,49 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "commit.h"
+
+#include "commitBatch.h"
+
+namespace co
+{
+ObjectVersions commit( const Objects& objects, const uint32_t incarnation,
+                       const bool batched )
+{
+    const ssize_t nObjects = ssize_t( objects.size( ));
+    ObjectVersions versions( objects.size( ));
+
+#pragma omp parallel
+    {
+        // batches are per thread, each worker coalesces its own commits
+        CommitBatch batch( batched );
+
+        // dynamic: commits may block on slave flow control
+#pragma omp for schedule( dynamic )
+        for( ssize_t i = 0; i < nObjects; ++i )
+        {
+            Object* object = objects[ i ];
+            LBASSERT( object->isMaster( ));
+            versions[ i ] = ObjectVersion( object->getID(),
+                                           object->commit( incarnation ));
+        }
+    }
+    return versions;
+}
+}
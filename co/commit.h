@@ -0,0 +1,51 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_COMMIT_H
+#define CO_COMMIT_H
+
+#include <co/object.h> // CO_COMMIT_NEXT
+#include <co/objectVersion.h>
+
+namespace co
+{
+    /**
+     * Commit a set of independent master objects in parallel.
+     *
+     * The objects are serialized, compressed and sent concurrently by a pool
+     * of worker threads, if Collage is compiled with OpenMP support, and
+     * serially by the calling thread otherwise. Each object is committed
+     * exactly once by one thread, which preserves the version order of each
+     * object. The getInstanceData() and pack() methods of the given objects
+     * have to be thread-safe with respect to each other.
+     *
+     * @param objects the master objects to commit, each at most once.
+     * @param incarnation the commit incarnation for auto obsoletion.
+     * @param batched coalesce the data sent by each worker thread into one
+     *                command per receiver, see ObjectMap::setBatchedCommit().
+     * @return the new versions of the objects, in the order of the objects.
+     * @sa Object::commit()
+     * @version 1.0
+     */
+    CO_API ObjectVersions commit( const Objects& objects,
+                                  const uint32_t incarnation = CO_COMMIT_NEXT,
+                                  const bool batched = false );
+}
+
+#endif // CO_COMMIT_H
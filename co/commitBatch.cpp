@@ -0,0 +1,129 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "commitBatch.h"
+
+#include "nodeCommand.h"
+#include "oCommand.h"
+#include "packingConnection.h"
+
+#include <lunchbox/perThread.h>
+
+namespace co
+{
+namespace
+{
+/** Sends the packed commands as one CMD_NODE_COMMIT_BATCH when flushed. */
+class BatchConnection : public PackingConnection
+{
+public:
+    explicit BatchConnection( ConnectionPtr connection )
+        : PackingConnection( connection ) {}
+
+    void flush()
+    {
+        LBASSERT( isComplete( ));
+        lunchbox::Bufferb& buffer = getBuffer();
+        if( buffer.isEmpty( ))
+            return;
+
+        ConnectionPtr connection = getConnection();
+        const uint64_t size = buffer.getSize();
+        OCommand command( Connections( 1, connection ), CMD_NODE_COMMIT_BATCH );
+        command << size;
+        command.sendHeader( size );
+        connection->send( buffer.getData(), size, true );
+        clear();
+    }
+};
+
+typedef lunchbox::RefPtr< BatchConnection > BatchConnectionPtr;
+typedef std::vector< BatchConnectionPtr > BatchConnections;
+typedef BatchConnections::const_iterator BatchConnectionsCIter;
+
+lunchbox::PerThread< detail::CommitBatch,
+                     lunchbox::perThreadNoDelete< detail::CommitBatch > >
+    _current;
+}
+
+namespace detail
+{
+class CommitBatch
+{
+public:
+    ConnectionPtr substitute( ConnectionPtr connection )
+    {
+        for( BatchConnectionsCIter i = connections.begin();
+             i != connections.end(); ++i )
+        {
+            if( (*i)->getConnection() == connection )
+                return *i;
+        }
+
+        connections.push_back( new BatchConnection( connection ));
+        return connections.back();
+    }
+
+    void flush()
+    {
+        for( BatchConnectionsCIter i = connections.begin();
+             i != connections.end(); ++i )
+        {
+            (*i)->flush();
+        }
+    }
+
+    BatchConnections connections;
+};
+}
+
+CommitBatch::CommitBatch( const bool enable )
+    : _impl( enable && !_current.get() ? new detail::CommitBatch : 0 )
+{
+    if( _impl )
+        _current = _impl;
+}
+
+CommitBatch::~CommitBatch()
+{
+    if( !_impl )
+        return;
+
+    flush();
+    _current = 0;
+    delete _impl;
+}
+
+void CommitBatch::flush()
+{
+    if( _impl )
+        _impl->flush();
+}
+
+void CommitBatch::substitute( Connections& connections )
+{
+    detail::CommitBatch* batch = _current.get();
+    if( !batch )
+        return;
+
+    for( ConnectionsIter i = connections.begin(); i != connections.end(); ++i )
+        *i = batch->substitute( *i );
+}
+
+}
@@ -0,0 +1,72 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_COMMITBATCH_H
+#define CO_COMMITBATCH_H
+
+#include <co/api.h>
+#include <co/types.h>
+#include <lunchbox/nonCopyable.h>
+
+namespace co
+{
+namespace detail { class CommitBatch; }
+
+    /**
+     * @internal Coalesces the object data sent by many commits into one
+     * command per receiver connection.
+     *
+     * While a commit batch is active, all object data streams created by the
+     * same thread write into per-connection buffers instead of sending
+     * directly. The buffered commands are stripped of their padding and sent
+     * as a single CMD_NODE_COMMIT_BATCH to each connection when the batch is
+     * flushed or destroyed. The receiving node dispatches the embedded
+     * commands in their original order.
+     *
+     * Batches do not nest; a batch constructed while another one is active in
+     * the same thread is inactive.
+     */
+    class CommitBatch : public lunchbox::NonCopyable
+    {
+    public:
+        /**
+         * Activate a new batch for the calling thread.
+         *
+         * @param enable false to construct an inactive batch.
+         */
+        CO_API explicit CommitBatch( const bool enable = true );
+
+        /** Flush and deactivate the batch. */
+        CO_API ~CommitBatch();
+
+        /** Send all buffered commands to their connections. */
+        CO_API void flush();
+
+        /**
+         * Replace the given connections by the buffering connections of the
+         * batch active in the calling thread, if any.
+         */
+        static void substitute( Connections& connections );
+
+    private:
+        detail::CommitBatch* const _impl;
+    };
+}
+
+#endif // CO_COMMITBATCH_H
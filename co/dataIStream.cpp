@@ -43,8 +43,12 @@ public:
             , inputSize( 0 )
             , position( 0 )
             , swap( swap_ )
+            , compact( false )
+            , pooled( 0 )
         {}
 
+    lunchbox::Bufferb& getBuffer() { return pooled ? *pooled : data; }
+
     /** The current input buffer */
     const uint8_t* input;
 
@@ -57,6 +61,8 @@ public:
     lunchbox::Decompressor decompressor; //!< current decompressor
     lunchbox::Bufferb data; //!< decompressed buffer
     bool swap; //!< Invoke endian conversion
+    bool compact; //!< Decode varint integers
+    lunchbox::Bufferb* pooled; //!< external decompression buffer
 };
 }
 
@@ -91,38 +97,102 @@ bool DataIStream::isSwapping() const
     return _impl->swap;
 }
 
+void DataIStream::setCompact( const bool onOff )
+{
+    _impl->compact = onOff;
+}
+
+bool DataIStream::isCompact() const
+{
+    return _impl->compact;
+}
+
+void DataIStream::setDecompressionBuffer( lunchbox::Bufferb* buffer )
+{
+    _impl->pooled = buffer;
+}
+
+lunchbox::Bufferb* DataIStream::getDecompressionBuffer()
+{
+    return _impl->pooled;
+}
+
 void DataIStream::_reset()
 {
     _impl->input     = 0;
     _impl->inputSize = 0;
     _impl->position  = 0;
     _impl->swap      = false;
+    _impl->compact   = false;
 }
 
 void DataIStream::_read( void* data, uint64_t size )
 {
+    // Big writes may be split over multiple buffers, see DataOStream::_write
+    uint8_t* ptr = static_cast< uint8_t* >( data );
+    while( size > 0 )
+    {
+        if( _impl->position >= _impl->inputSize )
+        {
+            // OPT: a read filling complete compressed buffers decompresses
+            // them directly
+            if( !_nextBuffer( ptr, size ))
+            {
+                LBUNREACHABLE;
+                LBERROR << "No more input data, need " << size << " bytes"
+                        << std::endl;
+                return;
+            }
+            if( !_impl->input )
+            {
+                ptr += _impl->inputSize;
+                size -= _impl->inputSize;
+                _impl->position = 0;
+                _impl->inputSize = 0;
+            }
+            continue;
+        }
+
+        const uint64_t nBytes = LB_MIN( size,
+                                        _impl->inputSize - _impl->position );
+        memcpy( ptr, _impl->input + _impl->position, nBytes );
+        _impl->position += nBytes;
+        ptr += nBytes;
+        size -= nBytes;
+    }
+}
+
+bool DataIStream::_readInteger( void* data, const uint64_t size,
+                                uint64_t& value )
+{
+    // the first buffer sets the compact flag, see getNextBuffer()
+    value = 0;
     if( !_checkBuffer( ))
     {
         LBUNREACHABLE;
         LBERROR << "No more input data" << std::endl;
-        return;
+        return true;
     }
 
-    LBASSERT( _impl->input );
+    if( !_impl->compact )
+    {
+        _read( data, size );
+        return false;
+    }
 
-    if( _impl->position + size > _impl->inputSize )
+    // a varint is never segmented, see DataOStream::_writeInteger
+    for( unsigned shift = 0; _impl->position < _impl->inputSize; shift += 7 )
     {
-        LBERROR << "Not enough data in input buffer: need " << size
-                << " bytes, " << _impl->inputSize - _impl->position << " left "
-                << std::endl;
-        LBUNREACHABLE;
-        // TODO: Allow reads which are asymmetric to writes by reading from
-        // multiple blocks here?
-        return;
+        const uint8_t byte = _impl->input[ _impl->position++ ];
+        if( shift < 64 )
+            value |= uint64_t( byte & 0x7f ) << shift;
+        if( !( byte & 0x80 ))
+            return true;
     }
 
-    memcpy( data, _impl->input + _impl->position, size );
-    _impl->position += size;
+    LBERROR << "Truncated varint in input buffer" << std::endl;
+    LBUNREACHABLE;
+    return true;
 }
 
 const void* DataIStream::getRemainingBuffer( const uint64_t size )
@@ -149,34 +219,55 @@ uint64_t DataIStream::getRemainingBufferSize()
 bool DataIStream::_checkBuffer()
 {
     while( _impl->position >= _impl->inputSize )
-    {
-        uint32_t compressor = EQ_COMPRESSOR_NONE;
-        uint32_t nChunks = 0;
-        const void* data = 0;
-
-        if( !getNextBuffer( compressor, nChunks, &data, _impl->inputSize ))
+        if( !_nextBuffer( ))
             return false;
+    return true;
+}
+
+bool DataIStream::_nextBuffer( void* direct, const uint64_t directSize )
+{
+    uint32_t compressor = EQ_COMPRESSOR_NONE;
+    uint32_t nChunks = 0;
+    const void* data = 0;
+
+    if( !getNextBuffer( compressor, nChunks, &data, _impl->inputSize ))
+        return false;
 
-        _impl->input = _decompress( data, compressor, nChunks,
-                                    _impl->inputSize );
-        _impl->position = 0;
+    _impl->position = 0;
+    if( direct && compressor != EQ_COMPRESSOR_NONE &&
+        _impl->inputSize <= directSize )
+    {
+        // consumed by the caller, which resets inputSize
+        _decompress( data, compressor, nChunks, _impl->inputSize,
+                     static_cast< uint8_t* >( direct ));
+        _impl->input = 0;
+        return true;
     }
+
+    _impl->input = _decompress( data, compressor, nChunks, _impl->inputSize );
     return true;
 }
 
 const uint8_t* DataIStream::_decompress( const void* data, const uint32_t name,
                                          const uint32_t nChunks,
-                                         const uint64_t dataSize )
+                                         const uint64_t dataSize,
+                                         uint8_t* destination )
 {
     const uint8_t* src = reinterpret_cast< const uint8_t* >( data );
     if( name == EQ_COMPRESSOR_NONE )
         return src;
 
     LBASSERT( name > EQ_COMPRESSOR_NONE );
+    if( !destination )
+    {
+        lunchbox::Bufferb& buffer = _impl->getBuffer();
 #ifndef CO_AGGRESSIVE_CACHING
-    _impl->data.clear();
+        if( !_impl->pooled )
+            buffer.clear();
 #endif
-    _impl->data.reset( dataSize );
+        buffer.reset( dataSize );
+        destination = buffer.getData();
+    }
 
     _impl->decompressor.setup( Global::getPluginRegistry(), name );
     LBASSERT( _impl->decompressor.uses( name ));
@@ -199,8 +290,8 @@ const uint8_t* DataIStream::_decompress( const void* data, const uint32_t name,
     }
 
     _impl->decompressor.decompress( chunks, chunkSizes, nChunks,
-                                    _impl->data.getData(), outDim );
-    return _impl->data.getData();
+                                    destination, outDim );
+    return destination;
 }
 
 }
@@ -49,6 +49,15 @@ public:
     virtual void reset() { _reset(); } //!< @internal
     void setSwapping( const bool onOff ); //!< @internal enable endian swap
     CO_API bool isSwapping() const; //!< @internal
+    /** @internal enable compact integer decoding, see DataOStream */
+    CO_API void setCompact( const bool onOff );
+    CO_API bool isCompact() const; //!< @internal
+
+    /** @internal Decompress into the given buffer instead of an own one. */
+    void setDecompressionBuffer( lunchbox::Bufferb* buffer );
+
+    /** @internal @return the external decompression buffer, or 0. */
+    lunchbox::Bufferb* getDecompressionBuffer();
     DataIStream& operator = ( const DataIStream& rhs ); //!< @internal
     //@}
 
@@ -160,6 +169,37 @@ private:
     /** Read a number of bytes from the stream into a buffer. */
     CO_API void _read( void* data, uint64_t size );
 
+    /**
+     * Read an integer, either size raw bytes into data or a varint into value
+     * in compact mode.
+     *
+     * @return true if value was decoded, false if data was read.
+     */
+    CO_API bool _readInteger( void* data, const uint64_t size,
+                              uint64_t& value );
+
+    /** Read an unsigned integer. */
+    template< class T > DataIStream& _readUnsigned( T& value )
+        {
+            uint64_t compact = 0;
+            if( _readInteger( &value, sizeof( value ), compact ))
+                value = T( compact );
+            else
+                _swap( value );
+            return *this;
+        }
+
+    /** Read a signed integer, zigzag-decoded in compact mode. */
+    template< class T > DataIStream& _readSigned( T& value )
+        {
+            uint64_t compact = 0;
+            if( _readInteger( &value, sizeof( value ), compact ))
+                value = T( int64_t( compact >> 1 ) ^ -int64_t( compact & 1 ));
+            else
+                _swap( value );
+            return *this;
+        }
+
     /**
      * Check that the current buffer has data left, get the next buffer is
      * necessary, return false if no data is left.
@@ -167,16 +207,27 @@ private:
     CO_API bool _checkBuffer();
     CO_API void _reset();
 
+    /**
+     * Fetch the next input buffer.
+     *
+     * If the buffer is compressed and has exactly directSize bytes, it is
+     * decompressed into direct and consumed completely.
+     *
+     * @return false if no data is left.
+     */
+    bool _nextBuffer( void* direct = 0, const uint64_t directSize = 0 );
+
     const uint8_t* _decompress( const void* data, const uint32_t name,
                                 const uint32_t nChunks,
-                                const uint64_t dataSize );
+                                const uint64_t dataSize,
+                                uint8_t* destination = 0 );
 
     /** Read a vector of trivial data. */
     template< class T >
     DataIStream& _readFlatVector ( std::vector< T >& value )
         {
             uint64_t nElems = 0;
-            *this >> nElems;
+            _readUnsigned( nElems );
             LBASSERTINFO( nElems < LB_BIT48,
                           "Out-of-sync co::DataIStream: " << nElems << " elements?" );
             value.resize( size_t( nElems ));
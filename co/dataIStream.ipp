@@ -16,6 +16,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <co/byteswap.h>
 #include <co/object.h>
 #include <co/objectVersion.h>
 
@@ -23,19 +24,69 @@ namespace co
 {
     /** @name Specialized input operators */
     //@{
+    /** Read a uint32_t, varint-decoded in compact mode. */
+    template<> inline DataIStream& DataIStream::operator >> ( uint32_t& value )
+    { return _readUnsigned( value ); }
+
+    /** Read an int32_t, zigzag-decoded in compact mode. */
+    template<> inline DataIStream& DataIStream::operator >> ( int32_t& value )
+    { return _readSigned( value ); }
+
+    /** Read a uint64_t, varint-decoded in compact mode. */
+    template<> inline DataIStream& DataIStream::operator >> ( uint64_t& value )
+    { return _readUnsigned( value ); }
+
+    /** Read an int64_t, zigzag-decoded in compact mode. */
+    template<> inline DataIStream& DataIStream::operator >> ( int64_t& value )
+    { return _readSigned( value ); }
+
+    /** Read a uint128_t, as two varints in compact mode. */
+    template<> inline DataIStream& DataIStream::operator >> ( uint128_t& value )
+    {
+        if( !_checkBuffer() || !isCompact( )) // load the first buffer's flag
+        {
+            _read( &value, sizeof( value ));
+            _swap( value );
+            return *this;
+        }
+        uint64_t high = 0;
+        uint64_t low = 0;
+        *this >> high >> low;
+        value = uint128_t( high, low );
+        return *this;
+    }
+
+    /** Read an object version, with a varint version in compact mode. */
+    template<> inline DataIStream&
+    DataIStream::operator >> ( ObjectVersion& value )
+    {
+        if( !_checkBuffer() || !isCompact( )) // load the first buffer's flag
+        {
+            _read( &value, sizeof( value ));
+            _swap( value );
+            return *this;
+        }
+        _read( &value.identifier, sizeof( value.identifier ));
+        _swap( value.identifier );
+        return *this >> value.version;
+    }
+
     /** Read a std::string. */
     template<>
     inline DataIStream& DataIStream::operator >> ( std::string& str )
     {
         uint64_t nElems = 0;
-        *this >> nElems;
-        LBASSERTINFO( nElems <= getRemainingBufferSize(),
-                      nElems << " > " << getRemainingBufferSize( ));
+        _readUnsigned( nElems );
         if( nElems == 0 )
             str.clear();
-        else
+        else if( nElems <= getRemainingBufferSize( ))
             str.assign( static_cast< const char* >( getRemainingBuffer(nElems)),
                         size_t( nElems ));
+        else // split over multiple buffers
+        {
+            str.resize( size_t( nElems ));
+            _read( &str[0], nElems );
+        }
         return *this;
     }
 
@@ -159,6 +210,49 @@ namespace co
 
     template<> inline void DataIStream::_swap( Array< void > ) const { /*NOP*/ }
 
+#ifndef CO_IGNORE_BYTESWAP
+    /** Vectorized byte-swap of 16 bit arrays. */
+    template<> inline void DataIStream::_swap( Array< uint16_t > array ) const
+        { if( isSwapping( )) byteswap16( array.data, array.num ); }
+
+    /** Vectorized byte-swap of 16 bit arrays. */
+    template<> inline void DataIStream::_swap( Array< int16_t > array ) const
+        { if( isSwapping( )) byteswap16( array.data, array.num ); }
+
+    /** Vectorized byte-swap of 32 bit arrays. */
+    template<> inline void DataIStream::_swap( Array< uint32_t > array ) const
+        { if( isSwapping( )) byteswap32( array.data, array.num ); }
+
+    /** Vectorized byte-swap of 32 bit arrays. */
+    template<> inline void DataIStream::_swap( Array< int32_t > array ) const
+        { if( isSwapping( )) byteswap32( array.data, array.num ); }
+
+    /** Vectorized byte-swap of 32 bit arrays. */
+    template<> inline void DataIStream::_swap( Array< float > array ) const
+        { if( isSwapping( )) byteswap32( array.data, array.num ); }
+
+    /** Vectorized byte-swap of 64 bit arrays. */
+    template<> inline void DataIStream::_swap( Array< uint64_t > array ) const
+        { if( isSwapping( )) byteswap64( array.data, array.num ); }
+
+    /** Vectorized byte-swap of 64 bit arrays. */
+    template<> inline void DataIStream::_swap( Array< int64_t > array ) const
+        { if( isSwapping( )) byteswap64( array.data, array.num ); }
+
+    /** Vectorized byte-swap of 64 bit arrays. */
+    template<> inline void DataIStream::_swap( Array< double > array ) const
+        { if( isSwapping( )) byteswap64( array.data, array.num ); }
+
+    /** Vectorized byte-swap of 128 bit arrays. */
+    template<> inline void DataIStream::_swap( Array< uint128_t > array ) const
+        { if( isSwapping( )) byteswap128( array.data, array.num ); }
+
+    /** Vectorized byte-swap of object version arrays. */
+    template<> inline void
+    DataIStream::_swap( Array< ObjectVersion > array ) const
+        { if( isSwapping( )) byteswap128( array.data, array.num << 1 ); }
+#endif
+
     template< typename O, typename C > inline void
     DataIStream::deserializeChildren( O* object, const std::vector< C* >& old_,
                                       std::vector< C* >& result )
@@ -20,8 +20,10 @@
 #include "dataIStreamArchive.h"
 
 #include "array.h"
+#include "byteswap.h"
 #include "dataIStream.h"
 #include "dataStreamArchive.h"
+#include "log.h"
 
 #include <boost/archive/detail/archive_serializer_map.hpp>
 #include <boost/archive/impl/archive_serializer_map.ipp>
@@ -66,6 +68,34 @@ void DataIStreamArchive::load_binary( void* data, std::size_t size )
     _stream >> Array< void >( data, size );
 }
 
+void DataIStreamArchive::_swapArray( void* data, const std::size_t size,
+                                     const std::size_t elementSize )
+{
+    if( !_stream.isSwapping( ))
+        return;
+
+    switch( elementSize )
+    {
+    case 1:
+        return;
+    case 2:
+        byteswap16( data, size / 2 );
+        return;
+    case 4:
+        byteswap32( data, size / 4 );
+        return;
+    case 8:
+        byteswap64( data, size / 8 );
+        return;
+    default:
+        LBERROR << "Can't byte-swap array with elements of size "
+                << elementSize << ", specialize co::ArchiveSwapSize"
+                << std::endl;
+        throw boost::archive::archive_exception(
+            boost::archive::archive_exception::other_exception );
+    }
+}
+
 void DataIStreamArchive::load( bool& b )
 {
     switch( signed char c = _loadSignedChar( ))
@@ -32,17 +32,26 @@
 #include <co/api.h>
 #include <co/types.h>
 
+#include <boost/version.hpp>
+
 #pragma warning( push )
 #pragma warning( disable: 4800 )
 #include <boost/archive/basic_binary_iarchive.hpp>
 #pragma warning( pop )
 #include <boost/archive/detail/register_archive.hpp>
 #include <boost/archive/shared_ptr_helper.hpp>
+#if BOOST_VERSION >= 106400 // BOOST_SERIALIZATION_USE_ARRAY_OPTIMIZATION
+#  include <boost/serialization/array_optimization.hpp>
+#else
+#  include <boost/serialization/array.hpp>
+#endif
 #include <boost/serialization/is_bitwise_serializable.hpp>
 
 #include <boost/spirit/home/support/detail/endian.hpp>
 #include <boost/spirit/home/support/detail/math/fpclassify.hpp>
 
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_arithmetic.hpp>
 #include <boost/type_traits/is_integral.hpp>
 #include <boost/type_traits/is_unsigned.hpp>
 #include <boost/type_traits/is_floating_point.hpp>
@@ -51,6 +60,19 @@
 
 namespace co
 {
+/**
+ * The size of the elements to byte-swap in an array of T, received from a
+ * peer with a different endianness.
+ *
+ * Arrays of bitwise serializable types are transmitted as one binary block
+ * and converted in bulk. Specialize this trait for bitwise serializable
+ * structs consisting of one element type, e.g., to sizeof( float ) for a
+ * vertex of floats. Zero means T can't be converted.
+ */
+template< class T > struct ArchiveSwapSize
+    : public boost::integral_constant< std::size_t,
+                      boost::is_arithmetic< T >::value ? sizeof( T ) : 0 > {};
+
 /** A boost.serialization input archive reading from a co::DataIStream. */
 class DataIStreamArchive
     : public boost::archive::basic_binary_iarchive< DataIStreamArchive >
@@ -65,9 +87,12 @@ public:
     /** @internal archives are expected to support this function */
     CO_API void load_binary( void* data, std::size_t size );
 
-    /** @internal use optimized load for arrays. */
-    template< typename T >
-    void load_array( boost::serialization::array< T >& a, unsigned int );
+    /**
+     * @internal Use optimized load for arrays of bitwise serializable types.
+     *
+     * @sa ArchiveSwapSize, DataOStreamArchive::save_array()
+     */
+    template< class A > void load_array( A& array, unsigned int );
 
     /** @internal enable serialization optimization for arrays. */
     struct use_array_optimization
@@ -146,6 +171,12 @@ private:
 
     CO_API signed char _loadSignedChar();
 
+    template< class T > void _loadArray( T* data, const std::size_t count );
+
+    /** Byte-swap size bytes of elements of the given size, if needed. */
+    CO_API void _swapArray( void* data, const std::size_t size,
+                            const std::size_t elementSize );
+
     DataIStream& _stream;
 };
 
@@ -22,11 +22,20 @@
 namespace co
 {
 
-template< typename T >
-void DataIStreamArchive::load_array( boost::serialization::array< T >& a,
-                                     unsigned int )
+template< class A >
+void DataIStreamArchive::load_array( A& array, unsigned int )
 {
-    _stream >> Array< T >( a.address(), a.count( ));
+    _loadArray( array.address(), array.count( ));
+}
+
+template< class T >
+void DataIStreamArchive::_loadArray( T* data, const std::size_t count )
+{
+    const std::size_t size = count * sizeof( T );
+    load_binary( data, size );
+#ifndef CO_IGNORE_BYTESWAP
+    _swapArray( data, size, ArchiveSwapSize< T >::value );
+#endif
 }
 
 template< class C, class T, class A >
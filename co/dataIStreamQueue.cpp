@@ -34,12 +34,18 @@ DataIStreamQueue::~DataIStreamQueue()
     LBASSERTINFO( _queued.isEmpty(), _queued.getSize() << " unapplied commits" )
 
     for( PendingStreamsCIter i = _pending.begin(); i != _pending.end(); ++i )
+    {
+        _releaseBuffer( i->second );
         delete i->second;
+    }
     _pending.clear();
 
     QueuedStream stream;
     while( _queued.tryPop( stream ))
+    {
+        _releaseBuffer( stream.second );
         delete stream.second;
+    }
 }
 
 ObjectDataIStream* DataIStreamQueue::tryPop()
@@ -68,6 +74,7 @@ ObjectDataIStream* DataIStreamQueue::pull( const uint128_t& key )
 
 void DataIStreamQueue::recycle( ObjectDataIStream* stream )
 {
+    _releaseBuffer( stream );
 #ifdef CO_AGGRESSIVE_CACHING
     stream->reset();
     _iStreamCache.release( stream );
@@ -76,6 +83,16 @@ void DataIStreamQueue::recycle( ObjectDataIStream* stream )
 #endif
 }
 
+void DataIStreamQueue::_releaseBuffer( ObjectDataIStream* stream )
+{
+    lunchbox::Bufferb* buffer = stream->getDecompressionBuffer();
+    if( !buffer )
+        return;
+
+    stream->setDecompressionBuffer( 0 );
+    _bufferCache.release( buffer );
+}
+
 bool DataIStreamQueue::addDataCommand( const uint128_t& key, ICommand& command )
 {
     LB_TS_THREAD( _thread );
@@ -84,7 +101,10 @@ bool DataIStreamQueue::addDataCommand( const uint128_t& key, ICommand& command )
     ObjectDataIStream* istream = 0;
     PendingStreams::iterator i = _pending.find( key );
     if( i == _pending.end( ))
+    {
         istream = _iStreamCache.alloc();
+        istream->setDecompressionBuffer( _bufferCache.alloc( ));
+    }
     else
         istream = i->second;
 
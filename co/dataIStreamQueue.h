@@ -22,6 +22,7 @@
 
 #include <co/types.h>
 
+#include <lunchbox/buffer.h>  // member
 #include <lunchbox/mtQueue.h> // member
 #include <lunchbox/pool.h>    // member
 #include <lunchbox/stdExt.h>  // member
@@ -64,6 +65,11 @@ namespace co
         /** Cached input streams (+decompressor) */
         lunchbox::Pool< ObjectDataIStream, true > _iStreamCache;
 
+        /** Decompression buffers, shared by all streams of this queue */
+        lunchbox::Pool< lunchbox::Bufferb, true > _bufferCache;
+
+        void _releaseBuffer( ObjectDataIStream* stream );
+
         LB_TS_VAR( _thread );
     };
 }
@@ -24,6 +24,7 @@
 #include "buffer.h"
 #include "connectionDescription.h"
 #include "commands.h"
+#include "commitBatch.h"
 #include "connections.h"
 #include "global.h"
 #include "log.h"
@@ -31,8 +32,11 @@
 #include "types.h"
 
 #include <lunchbox/compressor.h>
+#include <lunchbox/decompressor.h>
 #include <lunchbox/plugins/compressor.h>
 
+#include <cstring>
+
 namespace co
 {
 namespace
@@ -90,6 +94,9 @@ public:
     /** Save all sent data */
     bool save;
 
+    /** Use varint encoding for integers */
+    bool compact;
+
     DataOStream()
             : state( STATE_UNCOMPRESSED )
             , bufferStart( 0 )
@@ -97,6 +104,7 @@ public:
             , enabled( false )
             , dataSent( false )
             , save( false )
+            , compact( false )
         {}
 
     DataOStream( const DataOStream& rhs )
@@ -106,6 +114,7 @@ public:
         , enabled( rhs.enabled )
         , dataSent( rhs.dataSent )
         , save( rhs.save )
+        , compact( rhs.compact )
     {}
 
     uint32_t getCompressor() const
@@ -122,6 +131,14 @@ public:
         return compressor.getNumResults();
     }
 
+    /** @return the chunk count as streamed in the data header. */
+    uint32_t getChunksHeader() const
+    {
+        const uint32_t nChunks = getNumChunks();
+        LBASSERT( !( nChunks & DATA_CHUNKS_COMPACT ));
+        return compact ? nChunks | DATA_CHUNKS_COMPACT : nChunks;
+    }
+
 
     /** Compress data and update the compressor state. */
     void compress( void* src, const uint64_t size, const CompressorState result)
@@ -187,16 +204,28 @@ public:
         }
 #endif
     }
+
+    /** Set up the state for the restored, uncompressed buffer. */
+    void setSaved()
+    {
+        state = STATE_UNCOMPRESSED;
+        bufferStart = 0;
+        dataSize = buffer.getSize();
+        dataSent = dataSize > 0;
+        save = true;
+    }
 };
 }
 
 DataOStream::DataOStream()
         : _impl( new detail::DataOStream )
+        , _compact( false )
 {}
 
 DataOStream::DataOStream( DataOStream& rhs )
     : lunchbox::NonCopyable()
     , _impl( new detail::DataOStream( *rhs._impl ))
+    , _compact( rhs._compact )
 {
     _setupConnections( rhs.getConnections( ));
     getBuffer().swap( rhs.getBuffer( ));
@@ -239,6 +268,7 @@ void DataOStream::_enable()
 void DataOStream::_setupConnections( const Nodes& receivers )
 {
     gatherConnections( receivers, _impl->connections );
+    CommitBatch::substitute( _impl->connections );
 }
 
 void DataOStream::_setupConnections( const Connections& connections )
@@ -333,6 +363,15 @@ bool DataOStream::hasSentData() const
     return _impl->dataSent;
 }
 
+void DataOStream::setCompact( const bool onOff )
+{
+    LBASSERTINFO( !_impl->enabled ||
+                  ( !_impl->dataSent && _impl->buffer.getSize() == 0 ),
+                  "Can't change encoding after data has been written" );
+    _impl->compact = onOff;
+    _compact = onOff;
+}
+
 void DataOStream::_write( const void* data, uint64_t size )
 {
     LBASSERT( _impl->enabled );
@@ -342,12 +381,51 @@ void DataOStream::_write( const void* data, uint64_t size )
         LBWARN << *this << std::endl;
 #endif
 
-    if( _impl->buffer.getSize() - _impl->bufferStart >
-        Global::getObjectBufferSize( ))
+    const uint64_t threshold = Global::getObjectBufferSize();
+    const uint64_t pending = _impl->buffer.getSize() - _impl->bufferStart;
+    // OPT: Big writes are sent in their own buffer, which allows the receiver
+    // to decompress them directly into the destination
+    const bool isolate = size > threshold;
+
+    if( pending > threshold || ( isolate && pending > 0 ))
+        flush( false );
+
+    const uint8_t* ptr = static_cast< const uint8_t* >( data );
+    if( isolate )
     {
+        // Very big writes are split into multiple commands, which releases
+        // the connections in between for other, latency-critical commands
+        const int32_t maxKB =
+            Global::getIAttribute( Global::IATTR_OBJECT_COMMAND_SIZE );
+        const uint64_t maxSize = uint64_t( maxKB ) * LB_1KB;
+        while( maxSize > 0 && size > maxSize )
+        {
+            _impl->buffer.append( ptr, maxSize );
+            flush( false );
+            ptr += maxSize;
+            size -= maxSize;
+        }
+    }
+
+    _impl->buffer.append( ptr, size );
+    if( isolate )
         flush( false );
+}
+
+void DataOStream::_writeVarint( uint64_t value )
+{
+    LBASSERT( _compact );
+
+    // LEB128: 7 bits per byte, high bit set on all but the last byte
+    uint8_t encoded[ 10 ];
+    size_t nBytes = 0;
+    while( value >= 0x80 )
+    {
+        encoded[ nBytes++ ] = uint8_t( value ) | 0x80;
+        value >>= 7;
     }
-    _impl->buffer.append( static_cast< const uint8_t* >( data ), size );
+    encoded[ nBytes++ ] = uint8_t( value );
+    _write( encoded, nBytes );
 }
 
 void DataOStream::flush( const bool last )
@@ -417,7 +495,7 @@ lunchbox::Bufferb& DataOStream::getBuffer()
 
 DataOStream& DataOStream::streamDataHeader( DataOStream& os )
 {
-    os << _impl->getCompressor() << _impl->getNumChunks();
+    os << _impl->getCompressor() << _impl->getChunksHeader();
     return os;
 }
 
@@ -463,6 +541,129 @@ uint64_t DataOStream::getCompressedDataSize() const
             + _impl->getNumChunks() * sizeof( uint64_t );
 }
 
+uint64_t DataOStream::getSavedSize() const
+{
+    const bool compressed = _impl->getCompressor() != EQ_COMPRESSOR_NONE;
+    return _impl->buffer.getMaxSize() +
+           ( compressed ? _impl->compressedDataSize : 0 );
+}
+
+void DataOStream::encodeSaved( lunchbox::Bufferb& data )
+{
+    LBASSERT( !_impl->enabled );
+    LBASSERT( _impl->save );
+
+    _impl->compress( _impl->buffer.getData(), _impl->dataSize, STATE_COMPLETE );
+    const uint32_t compressor = _impl->getCompressor();
+    const uint32_t nChunks = _impl->getNumChunks();
+
+    data.append( reinterpret_cast< const uint8_t* >( &compressor ),
+                 sizeof( compressor ));
+    data.append( reinterpret_cast< const uint8_t* >( &nChunks ),
+                 sizeof( nChunks ));
+    data.append( reinterpret_cast< const uint8_t* >( &_impl->dataSize ),
+                 sizeof( uint64_t ));
+
+    if( compressor == EQ_COMPRESSOR_NONE )
+    {
+        data.append( reinterpret_cast< const uint8_t* >( &_impl->dataSize ),
+                     sizeof( uint64_t ));
+        data.append( _impl->buffer.getData(), _impl->dataSize );
+        return;
+    }
+
+    uint64_t* chunkSizes = static_cast< uint64_t* >
+                               ( alloca( nChunks * sizeof( uint64_t )));
+    void** chunks = static_cast< void ** >
+                                  ( alloca( nChunks * sizeof( void* )));
+    _getCompressedData( chunks, chunkSizes );
+
+    for( uint32_t i = 0; i < nChunks; ++i )
+    {
+        data.append( reinterpret_cast< const uint8_t* >( &chunkSizes[i] ),
+                     sizeof( uint64_t ));
+        data.append( static_cast< const uint8_t* >( chunks[i] ),
+                     chunkSizes[i] );
+    }
+}
+
+bool DataOStream::decodeSaved( const void* data, const uint64_t size )
+{
+    LBASSERT( !_impl->enabled );
+    const uint8_t* src = static_cast< const uint8_t* >( data );
+    const uint8_t* const end = src + size;
+
+    uint32_t compressor = 0;
+    uint32_t nChunks = 0;
+    uint64_t dataSize = 0;
+    if( size < 2 * sizeof( uint32_t ) + sizeof( uint64_t ))
+        return false;
+
+    ::memcpy( &compressor, src, sizeof( compressor ));
+    src += sizeof( compressor );
+    ::memcpy( &nChunks, src, sizeof( nChunks ));
+    src += sizeof( nChunks );
+    ::memcpy( &dataSize, src, sizeof( dataSize ));
+    src += sizeof( dataSize );
+    if( nChunks == 0 || nChunks > size / sizeof( uint64_t ))
+        return false;
+
+    uint64_t* chunkSizes = static_cast< uint64_t* >
+                               ( alloca( nChunks * sizeof( uint64_t )));
+    void** chunks = static_cast< void ** >
+                                  ( alloca( nChunks * sizeof( void* )));
+    for( uint32_t i = 0; i < nChunks; ++i )
+    {
+        if( uint64_t( end - src ) < sizeof( uint64_t ))
+            return false;
+        ::memcpy( &chunkSizes[i], src, sizeof( uint64_t ));
+        src += sizeof( uint64_t );
+        if( chunkSizes[i] > uint64_t( end - src ))
+            return false;
+
+        // The plugin API uses non-const source buffers for in-place operations
+        chunks[i] = const_cast< uint8_t* >( src );
+        src += chunkSizes[i];
+    }
+
+    if( compressor == EQ_COMPRESSOR_NONE )
+    {
+        if( nChunks != 1 || chunkSizes[0] != dataSize )
+            return false;
+        _impl->buffer.replace( chunks[0], dataSize );
+        _impl->setSaved();
+        return true;
+    }
+
+    lunchbox::Decompressor decompressor;
+    if( !decompressor.setup( Global::getPluginRegistry(), compressor ))
+        return false;
+
+    uint64_t outDim[2] = { 0, dataSize };
+    _impl->buffer.reset( dataSize );
+    decompressor.decompress( chunks, chunkSizes, nChunks,
+                             _impl->buffer.getData(), outDim );
+    _impl->setSaved();
+    return true;
+}
+
+void DataOStream::restoreSaved( lunchbox::Bufferb& data )
+{
+    LBASSERT( !_impl->enabled );
+    _impl->buffer.swap( data );
+    _impl->setSaved();
+}
+
+void DataOStream::clearSaved()
+{
+    LBASSERT( !_impl->enabled );
+    _impl->buffer.clear();
+    if( _impl->getCompressor() != EQ_COMPRESSOR_NONE )
+        _impl->compressor.realloc();
+    _impl->state = STATE_UNCOMPRESSED;
+    _impl->dataSize = 0;
+}
+
 std::ostream& operator << ( std::ostream& os, const DataOStream& dataOStream )
 {
     os << "DataOStream "
@@ -71,6 +71,40 @@ namespace DataStreamTest { class Sender; }
 
         /** @internal @return the compressed data size, 0 if uncompressed.*/
         uint64_t getCompressedDataSize() const;
+
+        /** @internal @return the memory used by the saved data. */
+        uint64_t getSavedSize() const;
+
+        /**
+         * @internal Append the saved data, compressed if possible, to data.
+         *
+         * The encoding consists of the compressor name, the number of chunks
+         * and the uncompressed size, followed by the size and content of each
+         * chunk.
+         */
+        void encodeSaved( lunchbox::Bufferb& data );
+
+        /** @internal Restore the saved data from an encodeSaved() result. */
+        bool decodeSaved( const void* data, const uint64_t size );
+
+        /** @internal Restore the saved data, swapping in the given buffer. */
+        void restoreSaved( lunchbox::Bufferb& data );
+
+        /** @internal Release the memory used by the saved data. */
+        void clearSaved();
+
+        /**
+         * @internal Enable or disable compact integer encoding.
+         *
+         * In compact mode, 32 and 64 bit integers are written as LEB128
+         * varints, signed values zigzag-encoded, and 128 bit integers as two
+         * varints. The receiver is notified using the data header. Writer and
+         * reader have to use the same integer types.
+         */
+        CO_API void setCompact( const bool onOff );
+
+        /** @internal @return true if compact integer encoding is enabled. */
+        bool isCompact() const { return _compact; }
         //@}
 
         /** @name Data output */
@@ -166,6 +200,7 @@ namespace DataStreamTest { class Sender; }
 
     private:
         detail::DataOStream* const _impl;
+        bool _compact; //!< inline copy of the encoding for integer writes
 
         /** Collect compressed data. */
         CO_API uint64_t _getCompressedData( void** chunks,
@@ -174,6 +209,33 @@ namespace DataStreamTest { class Sender; }
         /** Write a number of bytes from data into the stream. */
         CO_API void _write( const void* data, uint64_t size );
 
+        /** Write a LEB128 varint, used in compact mode. */
+        CO_API void _writeVarint( uint64_t value );
+
+        /** Write an unsigned integer, varint-encoded in compact mode. */
+        template< class T > DataOStream& _writeUnsigned( const T& value )
+        {
+            if( _compact )
+                _writeVarint( uint64_t( value ));
+            else
+                _write( &value, sizeof( value ));
+            return *this;
+        }
+
+        /** Write a signed integer, zigzag-encoded in compact mode. */
+        template< class T > DataOStream& _writeSigned( const T& value )
+        {
+            if( !_compact )
+            {
+                _write( &value, sizeof( value ));
+                return *this;
+            }
+            const int64_t signedValue = value;
+            _writeVarint( ( uint64_t( signedValue ) << 1 ) ^
+                          uint64_t( signedValue >> 63 ));
+            return *this;
+        }
+
         /** Helper function preparing data for sendData() as needed. */
         void _sendData( const void* data, const uint64_t size );
 
@@ -185,7 +247,7 @@ namespace DataStreamTest { class Sender; }
         DataOStream& _writeFlatVector( const std::vector< T >& value )
         {
             const uint64_t nElems = value.size();
-            _write( &nElems, sizeof( nElems ));
+            _writeUnsigned( nElems );
             if( nElems > 0 )
                 _write( &value.front(), nElems * sizeof( T ));
             return *this;
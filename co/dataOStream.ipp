@@ -22,12 +22,56 @@ namespace co
 {
     /** @name Specialized output operators */
     //@{
+    /** Write a uint32_t, varint-encoded in compact mode. */
+    template<> inline DataOStream&
+    DataOStream::operator << ( const uint32_t& value )
+    { return _writeUnsigned( value ); }
+
+    /** Write an int32_t, zigzag-encoded in compact mode. */
+    template<> inline DataOStream&
+    DataOStream::operator << ( const int32_t& value )
+    { return _writeSigned( value ); }
+
+    /** Write a uint64_t, varint-encoded in compact mode. */
+    template<> inline DataOStream&
+    DataOStream::operator << ( const uint64_t& value )
+    { return _writeUnsigned( value ); }
+
+    /** Write an int64_t, zigzag-encoded in compact mode. */
+    template<> inline DataOStream&
+    DataOStream::operator << ( const int64_t& value )
+    { return _writeSigned( value ); }
+
+    /** Write a uint128_t, as two varints in compact mode. */
+    template<> inline DataOStream&
+    DataOStream::operator << ( const uint128_t& value )
+    {
+        if( isCompact( ))
+            return (*this) << value.high() << value.low();
+        _write( &value, sizeof( value ));
+        return *this;
+    }
+
+    /** Write an object version, with a varint version in compact mode. */
+    template<> inline DataOStream&
+    DataOStream::operator << ( const ObjectVersion& value )
+    {
+        if( !isCompact( ))
+        {
+            _write( &value, sizeof( value ));
+            return *this;
+        }
+        // identifiers are random and do not benefit from varint encoding
+        _write( &value.identifier, sizeof( value.identifier ));
+        return (*this) << value.version;
+    }
+
     /** Write a std::string. */
     template<>
     inline DataOStream& DataOStream::operator << ( const std::string& str )
     {
         const uint64_t nElems = str.length();
-        _write( &nElems, sizeof( nElems ));
+        _writeUnsigned( nElems );
         if ( nElems > 0 )
             _write( str.c_str(), nElems );
 
@@ -116,17 +160,19 @@ namespace co
     template< typename C > inline void
     DataOStream::serializeChildren( const std::vector<C*>& children )
     {
-        const uint64_t nElems = children.size();
-        (*this) << nElems;
+        // written as one flat vector, matching DataIStream::deserializeChildren
+        ObjectVersions versions;
+        versions.reserve( children.size( ));
 
         for( typename std::vector< C* >::const_iterator i = children.begin();
              i != children.end(); ++i )
         {
             C* child = *i;
-            (*this) << ObjectVersion( child );
+            versions.push_back( ObjectVersion( child ));
             LBASSERTINFO( !child || child->isAttached(),
                           "Found unmapped object during serialization" );
         }
+        _writeFlatVector( versions );
     }
 /** @endcond */
 
@@ -37,6 +37,11 @@
 
 #include <boost/archive/basic_binary_oarchive.hpp>
 #include <boost/archive/detail/register_archive.hpp>
+#if BOOST_VERSION >= 106400 // BOOST_SERIALIZATION_USE_ARRAY_OPTIMIZATION
+#  include <boost/serialization/array_optimization.hpp>
+#else
+#  include <boost/serialization/array.hpp>
+#endif
 #include <boost/serialization/is_bitwise_serializable.hpp>
 #if BOOST_VERSION >= 104400
 #  include <boost/serialization/item_version_type.hpp>
@@ -66,9 +71,14 @@ public:
     /** @internal archives are expected to support this function. */
     CO_API void save_binary( const void* data, std::size_t size );
 
-    /** @internal use optimized save for arrays. */
-    template< typename T >
-    void save_array( const boost::serialization::array< T >& a, unsigned int );
+    /**
+     * @internal Use optimized save for arrays of bitwise serializable types.
+     *
+     * The array is written as one binary block in the native byte order,
+     * the receiving archive converts it if needed. A is the boost array
+     * wrapper, which has been renamed in different boost versions.
+     */
+    template< class A > void save_array( const A& array, unsigned int );
 
     /** @internal enable serialization optimization for arrays. */
     struct use_array_optimization
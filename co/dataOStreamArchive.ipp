@@ -16,11 +16,10 @@
  */
 
 
-template< typename T >
-void DataOStreamArchive::save_array( const boost::serialization::array< T >& a,
-                                     unsigned int )
+template< class A >
+void DataOStreamArchive::save_array( const A& array, unsigned int )
 {
-    _stream << Array< const T >( a.address(), a.count( ));
+    save_binary( array.address(), array.count() * sizeof( *array.address( )));
 }
 
 template< class C, class T, class A >
@@ -64,6 +64,7 @@ void DeltaMasterCM::_commit()
             LBASSERT( _version != VERSION_NONE );
 
             _addInstanceData( instanceData );
+            _unloadInstanceData( instanceData ); // the chunks hold the data
         }
         else
             _releaseInstanceData( instanceData );
@@ -38,6 +38,9 @@ public:
 
     /** Defines a queue to which commands are dispatched from the recv. */
     std::vector< co::CommandQueue* > qTable;
+
+    /** Commands executed before the normal commands of their queue. */
+    std::vector< bool > pTable;
 };
 }
 
@@ -58,7 +61,8 @@ Dispatcher::~Dispatcher()
 // command handling
 //===========================================================================
 void Dispatcher::_registerCommand( const uint32_t command, const Func& func,
-                                   CommandQueue* destinationQueue )
+                                   CommandQueue* destinationQueue,
+                                   const bool priority )
 {
     LBASSERT( _impl->fTable.size() == _impl->qTable.size( ));
 
@@ -68,10 +72,12 @@ void Dispatcher::_registerCommand( const uint32_t command, const Func& func,
         {
             _impl->fTable.push_back( Func( this, &Dispatcher::_cmdUnknown ));
             _impl->qTable.push_back( 0 );
+            _impl->pTable.push_back( false );
         }
 
         _impl->fTable.push_back( func );
         _impl->qTable.push_back( destinationQueue );
+        _impl->pTable.push_back( priority );
 
         LBASSERT( _impl->fTable.size() == command + 1 );
     }
@@ -79,6 +85,7 @@ void Dispatcher::_registerCommand( const uint32_t command, const Func& func,
     {
         _impl->fTable[command] = func;
         _impl->qTable[command] = destinationQueue;
+        _impl->pTable[command] = priority;
     }
 }
 
@@ -106,6 +113,7 @@ bool Dispatcher::dispatchCommand( ICommand& command )
     if( queue )
     {
         command.setDispatchFunction( _impl->fTable[ which ] );
+        command.setPriority( _impl->pTable[ which ] );
         queue->push( command );
         return true;
     }
@@ -49,16 +49,19 @@ namespace detail { class Dispatcher; }
          *
          * If the destination queue is 0, the command function is invoked
          * directly upon dispatch, otherwise it is pushed to the given queue and
-         * invoked during the processing of the command queue.
+         * invoked during the processing of the command queue. Priority
+         * commands are executed before the normal commands of their queue,
+         * which is meant for small, latency-critical commands.
          *
          * @param command the command.
          * @param func the functor to handle the command.
          * @param queue the queue to which the the command is dispatched
+         * @param priority true to overtake the normal queued commands.
          * @version 1.0
          */
         template< typename T > void
         registerCommand( const uint32_t command, const CommandFunc< T >& func,
-                         CommandQueue* queue );
+                         CommandQueue* queue, const bool priority = false );
 
         /**
          * Dispatch a command from the receiver thread to the registered queue.
@@ -87,15 +90,16 @@ namespace detail { class Dispatcher; }
         detail::Dispatcher* const _impl;
 
         CO_API void _registerCommand( const uint32_t command,
-                                      const Func& func, CommandQueue* queue );
+                                      const Func& func, CommandQueue* queue,
+                                      const bool priority );
     };
 
     template< typename T >
     void Dispatcher::registerCommand( const uint32_t command,
                                       const CommandFunc< T >& func,
-                                      CommandQueue* queue )
+                                      CommandQueue* queue, const bool priority )
     {
-        _registerCommand( command, Dispatcher::Func( func ), queue );
+        _registerCommand( command, Dispatcher::Func( func ), queue, priority );
     }
 }
 #endif // CO_DISPATCHER_H
@@ -10,10 +10,12 @@ set(CO_PUBLIC_HEADERS
   buffer.h
   bufferConnection.h
   bufferListener.h
+  byteswap.h
   co.h
   commandFunc.h
   commandQueue.h
   commands.h
+  commit.h
   connection.h
   connectionDescription.h
   connectionSet.h
@@ -37,6 +39,7 @@ set(CO_PUBLIC_HEADERS
   init.h
   localNode.h
   log.h
+  memoryBudget.h
   node.h
   nodeType.h
   oCommand.h
@@ -51,6 +54,7 @@ set(CO_PUBLIC_HEADERS
   queueMaster.h
   queueSlave.h
   serializable.h
+  sync.h
   types.h
   worker.h
   worker.ipp
@@ -60,6 +64,9 @@ set(CO_PUBLIC_HEADERS
 set(CO_HEADERS
   barrierCommand.h
   bufferCache.h
+  bufferDelta.h
+  commandPool.h
+  commitBatch.h
   connectionListener.h
   dataStreamArchive.h
   dataIStreamQueue.h
@@ -67,8 +74,11 @@ set(CO_HEADERS
   eventConnection.h
   fullMasterCM.h
   instanceCache.h
+  instanceCacheFile.h
   masterCMCommand.h
+  masterHistory.h
   nodeCommand.h
+  numa.h
   nullCM.h
   objectCM.h
   objectDataICommand.h
@@ -79,12 +89,15 @@ set(CO_HEADERS
   objectInstanceDataOStream.h
   objectSlaveDataOStream.h
   objectStore.h
+  packingConnection.h
   pipeConnection.h
   queueCommand.h
+  relayConnection.h
   rspConnection.h
   socketConnection.h
   staticMasterCM.h
   staticSlaveCM.h
+  syncBatch.h
   unbufferedMasterCM.h
   versionedMasterCM.h
   versionedSlaveCM.h
@@ -95,7 +108,12 @@ set(CO_SOURCES
   buffer.cpp
   bufferCache.cpp
   bufferConnection.cpp
+  bufferDelta.cpp
+  byteswap.cpp
+  commandPool.cpp
   commandQueue.cpp
+  commit.cpp
+  commitBatch.cpp
   connection.cpp
   connectionDescription.cpp
   connectionSet.cpp
@@ -112,9 +130,13 @@ set(CO_SOURCES
   iCommand.cpp
   init.cpp
   instanceCache.cpp
+  instanceCacheFile.cpp
   localNode.cpp
   masterCMCommand.cpp
+  masterHistory.cpp
+  memoryBudget.cpp
   node.cpp
+  numa.cpp
   oCommand.cpp
   object.cpp
   objectCM.cpp
@@ -131,13 +153,17 @@ set(CO_SOURCES
   objectSlaveDataOStream.cpp
   objectStore.cpp
   objectVersion.cpp
+  packingConnection.cpp
   pipeConnection.cpp
   queueItem.cpp
   queueMaster.cpp
   queueSlave.cpp
+  relayConnection.cpp
   serializable.cpp
   socketConnection.cpp
   staticSlaveCM.cpp
+  sync.cpp
+  syncBatch.cpp
   unbufferedMasterCM.cpp
   version.cpp
   versionedMasterCM.cpp
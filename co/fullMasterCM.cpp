@@ -20,11 +20,16 @@
 
 #include "fullMasterCM.h"
 
+#include "bufferDelta.h"
+#include "localNode.h"
 #include "log.h"
+#include "masterHistory.h"
 #include "node.h"
 #include "object.h"
 #include "objectDataIStream.h"
 
+#include <cstring>
+
 //#define EQ_INSTRUMENT
 
 namespace co
@@ -34,22 +39,59 @@ namespace
 #ifdef EQ_INSTRUMENT
 lunchbox::a_int32_t _bytesBuffered;
 #endif
+
+/**
+ * The size of the chunks shared between retained versions. Fixed-size chunks
+ * share unchanged data at the same position, like the binary deltas.
+ */
+static const uint64_t _chunkSize = 16384;
+
+/** @return the FNV-1a hash of the data, computed eight bytes at a time. */
+uint64_t _hash( const uint8_t* data, const uint64_t size )
+{
+    uint64_t hash = 14695981039346656037ull;
+    uint64_t i = 0;
+    for( ; i + sizeof( uint64_t ) <= size; i += sizeof( uint64_t ))
+    {
+        uint64_t word;
+        ::memcpy( &word, data + i, sizeof( uint64_t ));
+        hash = ( hash ^ word ) * 1099511628211ull;
+    }
+    for( ; i < size; ++i )
+        hash = ( hash ^ data[i] ) * 1099511628211ull;
+    return hash;
+}
 }
 
 FullMasterCM::FullMasterCM( Object* object )
         : VersionedMasterCM( object )
+        , _localNode( object->getLocalNode( ))
         , _commitCount( 0 )
         , _nVersions( 0 )
+        , _deltaBase( 0 )
+        , _deltaSize( 0 )
+#pragma warning(push)
+#pragma warning(disable : 4355)
+        , _deltaOStream( this, CMD_OBJECT_INSTANCE_DELTA )
+#pragma warning(pop)
 {}
 
 FullMasterCM::~FullMasterCM()
 {
+    MasterHistory& history = _localNode->getMasterHistory();
     for( InstanceDataDeque::const_iterator i = _instanceDatas.begin();
          i != _instanceDatas.end(); ++i )
     {
-        delete *i;
+        InstanceData* data = *i;
+        history.remove( data->size );
+        if( data->spillSize > 0 )
+            history.release( data->spillSize );
+        _releaseChunks( data );
+        delete data;
     }
     _instanceDatas.clear();
+    LBASSERT( _chunks.empty( ));
+    history.remove( _deltaSize );
 
     for( InstanceDatas::const_iterator i = _instanceDataCache.begin();
          i != _instanceDataCache.end(); ++i )
@@ -67,7 +109,10 @@ void FullMasterCM::sendInstanceData( Nodes& nodes )
         return;
 
     InstanceData* data = _instanceDatas.back();
+    if( !_loadInstanceData( data ))
+        return;
     data->os.sendInstanceData( nodes );
+    _unloadInstanceData( data );
 }
 
 void FullMasterCM::init()
@@ -81,7 +126,7 @@ void FullMasterCM::init()
     _object->getInstanceData( data->os );
     data->os.disable();
 
-    _instanceDatas.push_back( data );
+    _addInstanceData( data );
     ++_version;
     ++_commitCount;
 }
@@ -133,6 +178,7 @@ void FullMasterCM::_updateCommitCount( const uint32_t incarnation )
         // tweak commitCount of minimum retained version for correct obsoletion
         data->commitCount = 0;
         _version = data->os.getVersion();
+        _setDeltaBase( 0 );
     }
 }
 
@@ -162,18 +208,149 @@ void FullMasterCM::_obsolete()
     _checkConsistency();
 }
 
+void FullMasterCM::_spillInstanceDatas()
+{
+    MasterHistory& history = _localNode->getMasterHistory();
+    if( !history.isFull( ))
+        return;
+
+    // spill the oldest versions first, the head version stays in memory
+    for( InstanceDataDeque::const_iterator i = _instanceDatas.begin();
+         history.isFull() && *i != _instanceDatas.back(); ++i )
+    {
+        InstanceData* data = *i;
+        if( data->spillSize > 0 || !_ownsChunk( data ) ||
+            !_loadInstanceData( data ))
+        {
+            continue;
+        }
+
+        lunchbox::Bufferb buffer;
+        data->os.encodeSaved( buffer );
+        if( !history.spill( buffer, data->spillOffset ))
+        {
+            _unloadInstanceData( data );
+            return;
+        }
+        data->spillSize = buffer.getSize();
+        _releaseChunks( data );
+        _unloadInstanceData( data );
+    }
+}
+
+bool FullMasterCM::_ownsChunk( const InstanceData* data ) const
+{
+    if( data->chunks.empty( )) // unshared data
+        return true;
+
+    for( ChunksCIter i = data->chunks.begin(); i != data->chunks.end(); ++i )
+        if( (*i)->refCount == 1 )
+            return true;
+    return false;
+}
+
+bool FullMasterCM::_loadInstanceData( InstanceData* data )
+{
+    if( data->loaded )
+        return true;
+
+    if( !data->chunks.empty( ))
+    {
+        lunchbox::Bufferb buffer;
+        buffer.reserve( data->chunks.size() * _chunkSize );
+        for( ChunksCIter i = data->chunks.begin(); i != data->chunks.end(); ++i)
+            buffer.append( (*i)->data.getData(), (*i)->data.getSize( ));
+
+        data->os.restoreSaved( buffer );
+        data->loaded = true;
+        return true;
+    }
+
+    MasterHistory& history = _localNode->getMasterHistory();
+    lunchbox::Bufferb buffer;
+    if( !history.load( data->spillOffset, data->spillSize, buffer ) ||
+        !data->os.decodeSaved( buffer.getData(), buffer.getSize( )))
+    {
+        LBERROR << "Can't reload v" << data->os.getVersion() << " of "
+                << lunchbox::className( _object ) << " "
+                << ObjectVersion( _object ) << std::endl;
+        return false;
+    }
+
+    data->loaded = true;
+    data->size = data->os.getSavedSize();
+    history.add( data->size );
+    return true;
+}
+
+void FullMasterCM::_unloadInstanceData( InstanceData* data )
+{
+    // keep versions which can't be loaded again
+    if( !data->loaded || ( data->chunks.empty() && data->spillSize == 0 ))
+    {
+        return;
+    }
+
+    data->os.clearSaved();
+    _localNode->getMasterHistory().remove( data->size );
+    data->size = 0;
+    data->loaded = false;
+}
+
 void FullMasterCM::_initSlave( MasterCMCommand command,
-                               const uint128_t& /*replyVersion*/,
-                               bool replyUseCache )
+                               const uint128_t& replyVersion, bool )
+{
+    _initSlaves( ICommands( 1, command ), replyVersion );
+}
+
+void FullMasterCM::_initSlaves( const ICommands& commands,
+                                const uint128_t& /*replyVersion*/ )
 {
     _checkConsistency();
 
+    // group the requests by the range of versions to send
+    MapRanges ranges;
+    for( ICommandsCIter i = commands.begin(); i != commands.end(); ++i )
+    {
+        MasterCMCommand command( *i );
+        const bool replyUseCache = _useCache( command );
+        uint128_t start;
+        uint128_t end;
+        uint128_t tail;
+        const uint128_t replyVersion = _getMapRange( command, replyUseCache,
+                                                     start, end, tail );
+        ranges[ std::make_pair( start, end ) ].push_back(
+            MapRequest( *i, replyVersion, replyUseCache, tail ));
+    }
+
+    for( MapRangesCIter i = ranges.begin(); i != ranges.end(); ++i )
+        _sendMapData( i->first.first, i->first.second, i->second );
+
+    // release the old versions loaded for late mappers
+    for( InstanceDataDeque::const_iterator i = _instanceDatas.begin();
+         i != _instanceDatas.end(); ++i )
+    {
+        _unloadInstanceData( *i );
+    }
+
+#ifdef EQ_INSTRUMENT_MULTICAST
+    if( _miss % 100 == 0 )
+        LBINFO << "Cached " << _hit << "/" << _hit + _miss
+               << " instance data transmissions" << std::endl;
+#endif
+}
+
+uint128_t FullMasterCM::_getMapRange( const MasterCMCommand& command,
+                                      const bool replyUseCache,
+                                      uint128_t& start, uint128_t& end,
+                                      uint128_t& tail ) const
+{
     const uint128_t& version = command.getRequestedVersion();
 
     const uint128_t oldest = _instanceDatas.front()->os.getVersion();
-    uint128_t start = (version == VERSION_OLDEST || version < oldest ) ?
-                          oldest : version;
-    uint128_t end = _version;
+    start = (version == VERSION_OLDEST || version < oldest ) ? oldest : version;
+    end = _version;
+    tail = VERSION_NONE;
 
 #ifndef NDEBUG
     if( version != VERSION_OLDEST && version < start )
@@ -203,7 +380,17 @@ void FullMasterCM::_initSlave( MasterCMCommand command,
             _hit += _version - end;
 #endif
         }
-        // TODO else cached block in the middle, send head and tail elements
+        else if( minCachedVersion > start && maxCachedVersion < end &&
+                 minCachedVersion <= maxCachedVersion )
+        {
+            // cached block in the middle: send the head elements now and the
+            // tail elements after the reply, which queues the cached block
+            tail = maxCachedVersion + 1;
+            end = minCachedVersion - 1;
+#ifdef EQ_INSTRUMENT_MULTICAST
+            _hit += maxCachedVersion + 1 - minCachedVersion;
+#endif
+        }
     }
 
 #if 0
@@ -215,44 +402,80 @@ void FullMasterCM::_initSlave( MasterCMCommand command,
         << _instanceDatas.size() << std::endl;
 #endif
     LBASSERT( start >= oldest );
+    return replyVersion;
+}
 
-    bool dataSent = false;
-
-    // send all instance datas from start..end
-    InstanceDataDeque::iterator i = _instanceDatas.begin();
-    while( i != _instanceDatas.end() && (*i)->os.getVersion() < start )
-        ++i;
-
-    for( ; i != _instanceDatas.end() && (*i)->os.getVersion() <= end; ++i )
+void FullMasterCM::_sendMapData( const uint128_t& start, const uint128_t& end,
+                                 const MapRequests& requests )
+{
+    // find instance datas from start..end
+    InstanceDataDeque::const_iterator first = _instanceDatas.begin();
+    while( first != _instanceDatas.end() && (*first)->os.getVersion() < start )
+        ++first;
+    const bool dataSent = first != _instanceDatas.end() &&
+                          (*first)->os.getVersion() <= end;
+
+    for( MapRequestsCIter i = requests.begin(); i != requests.end(); ++i )
     {
+        const MasterCMCommand command( i->command );
+        _sendMapSuccess( command, dataSent, start, end );
         if( !dataSent )
-        {
-            _sendMapSuccess( command, true );
-            dataSent = true;
-        }
+            _sendMapReply( command, i->replyVersion, true, i->useCache, false );
+    }
+    if( !dataSent )
+        return;
+
+    // send the data once to all requesters of this range
+    ICommands commands;
+    for( MapRequestsCIter i = requests.begin(); i != requests.end(); ++i )
+        commands.push_back( i->command );
+    const Connections connections = _getMapConnections( commands );
+    const MasterCMCommand command( commands.front( ));
 
+    for( InstanceDataDeque::const_iterator i = first;
+         i != _instanceDatas.end() && (*i)->os.getVersion() <= end; ++i )
+    {
         InstanceData* data = *i;
         LBASSERT( data );
-        data->os.sendMapData( command.getNode(), command.getInstanceID( ));
+        if( !_loadInstanceData( data ))
+            continue;
+
+        if( requests.size() == 1 )
+            data->os.sendMapData( command.getNode(), command.getInstanceID( ));
+        else
+            data->os.sendMapData( connections );
 
 #ifdef EQ_INSTRUMENT_MULTICAST
         ++_miss;
 #endif
     }
 
-    if( !dataSent )
+    for( MapRequestsCIter i = requests.begin(); i != requests.end(); ++i )
+        _sendMapReply( MasterCMCommand( i->command ), i->replyVersion, true,
+                       i->useCache, true );
+
+    // Send the versions after a cached block to each slave, which has
+    // queued the cached versions upon the reply. Using the same connection
+    // as the reply guarantees the ordering.
+    for( MapRequestsCIter i = requests.begin(); i != requests.end(); ++i )
     {
-        _sendMapSuccess( command, false );
-        _sendMapReply( command, replyVersion, true, replyUseCache, false );
-    }
-    else
-        _sendMapReply( command, replyVersion, true, replyUseCache, true );
+        if( i->tail == VERSION_NONE )
+            continue;
 
-#ifdef EQ_INSTRUMENT_MULTICAST
-    if( _miss % 100 == 0 )
-        LBINFO << "Cached " << _hit << "/" << _hit + _miss
-               << " instance data transmissions" << std::endl;
-#endif
+        const MasterCMCommand tailCommand( i->command );
+        for( InstanceDataDeque::const_iterator j = first;
+             j != _instanceDatas.end(); ++j )
+        {
+            InstanceData* data = *j;
+            if( data->os.getVersion() < i->tail ||
+                !_loadInstanceData( data ))
+            {
+                continue;
+            }
+            data->os.sendMapData( tailCommand.getNode(),
+                                  tailCommand.getInstanceID( ));
+        }
+    }
 }
 
 void FullMasterCM::_checkConsistency() const
@@ -299,6 +522,7 @@ FullMasterCM::InstanceData* FullMasterCM::_newInstanceData()
     }
 
     instanceData->commitCount = _commitCount;
+    instanceData->loaded = true;
     instanceData->os.reset();
     instanceData->os.enableSave();
     return instanceData;
@@ -309,7 +533,18 @@ void FullMasterCM::_addInstanceData( InstanceData* data )
     LBASSERT( data->os.getVersion() != VERSION_NONE );
     LBASSERT( data->os.getVersion() != VERSION_INVALID );
 
+    _chunkInstanceData( data );
+    if( data->chunks.empty( )) // account the unshared data
+    {
+        data->size = data->os.getSavedSize();
+        _localNode->getMasterHistory().add( data->size );
+    }
+
+    InstanceData* previous = _instanceDatas.empty() ? 0 :
+                                                      _instanceDatas.back();
     _instanceDatas.push_back( data );
+    if( previous )
+        _unloadInstanceData( previous );
 #ifdef EQ_INSTRUMENT
     _bytesBuffered += data->os.getSaveBuffer().getSize();
     LBINFO << _bytesBuffered << " bytes used" << std::endl;
@@ -318,6 +553,16 @@ void FullMasterCM::_addInstanceData( InstanceData* data )
 
 void FullMasterCM::_releaseInstanceData( InstanceData* data )
 {
+    MasterHistory& history = _localNode->getMasterHistory();
+    history.remove( data->size );
+    if( data->spillSize > 0 )
+        history.release( data->spillSize );
+    data->size = 0;
+    data->spillSize = 0;
+    _releaseChunks( data );
+    if( data == _deltaBase )
+        _setDeltaBase( 0 );
+
 #ifdef CO_AGGRESSIVE_CACHING
     _instanceDataCache.push_back( data );
 #else
@@ -334,6 +579,7 @@ uint128_t FullMasterCM::commit( const uint32_t incarnation )
         Mutex mutex( _slaves );
         _updateCommitCount( incarnation );
         _obsolete();
+        _spillInstanceDatas();
         return _version;
     }
 
@@ -346,13 +592,22 @@ uint128_t FullMasterCM::commit( const uint32_t incarnation )
     _updateCommitCount( incarnation );
     _commit();
     _obsolete();
+    _spillInstanceDatas();
     return _version;
 }
 
 void FullMasterCM::_commit()
 {
+    // Without slaves, new slaves map the full data and need no delta base.
+    // Otherwise the data is saved first, to send it or a delta against the
+    // last commit, whichever is smaller.
+    const bool useDelta = !_slaves->empty();
+    if( !useDelta )
+        _setDeltaBase( 0 );
+
     InstanceData* instanceData = _newInstanceData();
-    instanceData->os.enableCommit( _version + 1, *_slaves );
+    instanceData->os.enableCommit( _version + 1,
+                                   useDelta ? Nodes() : *_slaves );
     _object->getInstanceData( instanceData->os );
     instanceData->os.disable();
 
@@ -364,18 +619,150 @@ void FullMasterCM::_commit()
         LBINFO << "Committed v" << _version << "@" << _commitCount << ", id "
                << _object->getID() << std::endl;
 #endif
+        // chunk the uncompressed data before it is sent
         _addInstanceData( instanceData );
+        if( useDelta )
+            _commitInstanceData( instanceData );
+        _unloadInstanceData( instanceData ); // the chunks hold the data
     }
     else
         _instanceDataCache.push_back( instanceData );
 }
 
+void FullMasterCM::_commitInstanceData( InstanceData* data )
+{
+    const bool sendDelta = _encodeDelta( data );
+    _setDeltaBase( data );
+
+    if( !sendDelta )
+    {
+        data->os.commit( *_slaves );
+        return;
+    }
+
+    _deltaOStream.reset();
+    _deltaOStream.enableCommit( _version, *_slaves );
+    _deltaOStream << _deltaBuffer;
+    _deltaOStream.disable();
+}
+
+bool FullMasterCM::_encodeDelta( const InstanceData* data )
+{
+    if( !_deltaBase || data->chunks.empty() || _deltaBase->chunks.empty( ))
+        return false;
+
+    const uint64_t size = data->os.getSaveBuffer().getSize();
+    const Chunks& chunks = data->chunks;
+    const Chunks& baseChunks = _deltaBase->chunks;
+    startDelta( _deltaBuffer, size );
+
+    uint64_t unchanged = 0;
+    for( size_t i = 0; i < chunks.size(); ++i )
+    {
+        const Chunk* base = i < baseChunks.size() ? baseChunks[i] : 0;
+        const lunchbox::Bufferb& chunk = chunks[i]->data;
+        if( chunks[i] == base ) // same hash and content
+        {
+            unchanged += chunk.getSize();
+            continue;
+        }
+
+        if( !appendDelta( _deltaBuffer, unchanged,
+                          base ? base->data.getData() : 0,
+                          base ? base->data.getSize() : 0,
+                          chunk.getData(), chunk.getSize(), size ))
+        {
+            return false;
+        }
+        unchanged = 0;
+    }
+    return appendDelta( _deltaBuffer, unchanged, 0, 0, 0, 0, size );
+}
+
+void FullMasterCM::_setDeltaBase( const InstanceData* data )
+{
+    _deltaBase = data;
+    if( !data )
+        _deltaBuffer.clear();
+
+    const uint64_t deltaSize = _deltaBuffer.getMaxSize();
+    MasterHistory& history = _localNode->getMasterHistory();
+    history.add( deltaSize );
+    history.remove( _deltaSize );
+    _deltaSize = deltaSize;
+}
+
+void FullMasterCM::_chunkInstanceData( InstanceData* data )
+{
+    LBASSERT( data->chunks.empty( ));
+    const lunchbox::Bufferb& buffer = data->os.getSaveBuffer();
+    if( buffer.isEmpty( )) // no data, or compressed in place when sent
+        return;
+
+    const uint8_t* ptr = buffer.getData();
+    const uint64_t size = buffer.getSize();
+    for( uint64_t offset = 0; offset < size; offset += _chunkSize )
+    {
+        const uint64_t chunkSize = LB_MIN( _chunkSize, size - offset );
+        data->chunks.push_back( _getChunk( ptr + offset, chunkSize ));
+    }
+}
+
+FullMasterCM::Chunk* FullMasterCM::_getChunk( const uint8_t* data,
+                                              const uint64_t size )
+{
+    const uint64_t hash = _hash( data, size );
+    ChunkHash::const_iterator i = _chunks.find( hash );
+    if( i != _chunks.end( ))
+    {
+        Chunk* chunk = i->second;
+        if( chunk->data.getSize() == size &&
+            ::memcmp( chunk->data.getData(), data, size ) == 0 )
+        {
+            ++chunk->refCount;
+            return chunk;
+        }
+    }
+
+    Chunk* chunk = new Chunk;
+    chunk->data.replace( data, size );
+    chunk->hash = hash;
+    chunk->refCount = 1;
+    if( i == _chunks.end( )) // hash collisions are not shared
+        _chunks[ hash ] = chunk;
+
+    _localNode->getMasterHistory().add( chunk->data.getMaxSize( ));
+    return chunk;
+}
+
+void FullMasterCM::_releaseChunks( InstanceData* data )
+{
+    MasterHistory& history = _localNode->getMasterHistory();
+    for( ChunksCIter i = data->chunks.begin(); i != data->chunks.end(); ++i )
+    {
+        Chunk* chunk = *i;
+        if( --chunk->refCount > 0 )
+            continue;
+
+        ChunkHash::iterator j = _chunks.find( chunk->hash );
+        if( j != _chunks.end() && j->second == chunk )
+            _chunks.erase( j );
+
+        history.remove( chunk->data.getMaxSize( ));
+        delete chunk;
+    }
+    data->chunks.clear();
+}
+
 void FullMasterCM::push( const uint128_t& groupID, const uint128_t& typeID,
                          const Nodes& nodes )
 {
     Mutex mutex( _slaves );
     InstanceData* instanceData = _instanceDatas.back();
+    if( !_loadInstanceData( instanceData ))
+        return;
     instanceData->os.push( nodes, _object->getID(), groupID, typeID );
+    _unloadInstanceData( instanceData );
 }
 
 }
@@ -22,9 +22,14 @@
 #define CO_FULLMASTERCM_H
 
 #include "versionedMasterCM.h"        // base class
+#include "objectDeltaDataOStream.h"    // member
 #include "objectInstanceDataOStream.h" // member
 
+#include <lunchbox/buffer.h>           // member
+#include <lunchbox/stdExt.h>           // member
+
 #include <deque>
+#include <map>
 
 namespace co
 {
@@ -56,18 +61,40 @@ namespace co
         virtual void sendInstanceData( Nodes& nodes );
 
     protected:
+        /** A piece of retained instance data, shared by equal versions. */
+        struct Chunk
+        {
+            lunchbox::Bufferb data;
+            uint64_t hash;
+            uint32_t refCount;
+        };
+        typedef std::vector< Chunk* > Chunks;
+        typedef Chunks::const_iterator ChunksCIter;
+
+        /**
+         * A retained version, kept as chunks unless spilled to the history
+         * file. Versions are only loaded into the stream to be sent.
+         */
         struct InstanceData
         {
             InstanceData( const VersionedMasterCM* cm )
-                    : os( cm ), commitCount( 0 ) {}
+                    : os( cm ), commitCount( 0 ), loaded( true ), size( 0 )
+                    , spillOffset( 0 ), spillSize( 0 ) {}
 
             ObjectInstanceDataOStream os;
             uint32_t commitCount;
+            Chunks chunks; //!< the content, empty if spilled
+            bool loaded; //!< the content is saved in os
+            uint64_t size; //!< memory of os accounted in history
+            uint64_t spillOffset; //!< position in the history file
+            uint64_t spillSize; //!< size in the history file, 0 if none
         };
 
         virtual void _initSlave( MasterCMCommand command,
                                  const uint128_t& replyVersion,
                                  bool replyUseCache );
+        virtual void _initSlaves( const ICommands& commands,
+                                  const uint128_t& replyVersion );
 
         InstanceData* _newInstanceData();
         void _addInstanceData( InstanceData* data );
@@ -75,12 +102,32 @@ namespace co
 
         void _updateCommitCount( const uint32_t incarnation );
         void _obsolete();
+
+        /**
+         * Spill old versions while the master history is over budget. Versions
+         * only made of chunks shared with other versions are kept, since
+         * spilling them would not free any memory.
+         */
+        void _spillInstanceDatas();
+
+        /** @return true if spilling the version frees memory. */
+        bool _ownsChunk( const InstanceData* data ) const;
+
+        /** Load an old version into its stream. @return false on error. */
+        bool _loadInstanceData( InstanceData* data );
+
+        /** Release the stream memory of a loaded old version. */
+        void _unloadInstanceData( InstanceData* data );
+
         void _checkConsistency() const;
 
         virtual bool isBuffered() const{ return true; }
         virtual void _commit();
 
     private:
+        /** Keeps the master history alive until all data is released. */
+        const LocalNodePtr _localNode;
+
         /** The number of commits, needed for auto-obsoletion. */
         uint32_t _commitCount;
 
@@ -94,6 +141,77 @@ namespace co
         InstanceDataDeque _instanceDatas;
         InstanceDatas _instanceDataCache;
 
+        /** The shared chunks of all retained versions, by content hash. */
+        typedef stde::hash_map< uint64_t, Chunk* > ChunkHash;
+        ChunkHash _chunks;
+
+        /**
+         * The head version as last committed to the slaves, whose chunks are
+         * the base for binary deltas. 0 if the slaves may not have it.
+         */
+        const InstanceData* _deltaBase;
+        lunchbox::Bufferb _deltaBuffer; //!< The encoded binary delta
+        uint64_t _deltaSize; //!< The delta memory, as accounted in history
+        ObjectDeltaDataOStream _deltaOStream; //!< Sends the binary delta
+
+        /** A map request of a slave. */
+        struct MapRequest
+        {
+            MapRequest( const ICommand& command_,
+                        const uint128_t& replyVersion_, const bool useCache_,
+                        const uint128_t& tail_ )
+                : command( command_ ), replyVersion( replyVersion_ )
+                , useCache( useCache_ ), tail( tail_ ) {}
+
+            ICommand command;
+            uint128_t replyVersion;
+            bool useCache;
+            uint128_t tail; //!< first version sent after the reply, or NONE
+        };
+        typedef std::vector< MapRequest > MapRequests;
+        typedef MapRequests::const_iterator MapRequestsCIter;
+
+        /** The map requests by the range of instance datas to send. */
+        typedef std::map< std::pair< uint128_t, uint128_t >, MapRequests >
+            MapRanges;
+        typedef MapRanges::const_iterator MapRangesCIter;
+
+        void _commitInstanceData( InstanceData* data );
+
+        /**
+         * Encode the delta of the data against the delta base. Chunks shared
+         * with the base are unchanged and skipped without being read.
+         *
+         * @return true if the delta is smaller than the data.
+         */
+        bool _encodeDelta( const InstanceData* data );
+
+        /** Set or, with no data, clear the delta base. */
+        void _setDeltaBase( const InstanceData* data );
+
+        /** Split the saved data into chunks, sharing existing equal ones. */
+        void _chunkInstanceData( InstanceData* data );
+        Chunk* _getChunk( const uint8_t* data, const uint64_t size );
+        void _releaseChunks( InstanceData* data );
+
+        /**
+         * Compute the versions [start, end] to send for a map request.
+         *
+         * If the slave has a block in the middle cached, the versions after
+         * it, [tail, head], are sent separately after the map reply.
+         * Otherwise tail is set to VERSION_NONE.
+         *
+         * @return the version to map.
+         */
+        uint128_t _getMapRange( const MasterCMCommand& command,
+                                const bool replyUseCache,
+                                uint128_t& start, uint128_t& end,
+                                uint128_t& tail ) const;
+
+        /** Send the versions [start, end] once to all requesters. */
+        void _sendMapData( const uint128_t& start, const uint128_t& end,
+                           const MapRequests& requests );
+
         /* The command handlers. */
         bool _cmdCommit( ICommand& command );
         bool _cmdObsolete( ICommand& command );
@@ -64,8 +64,15 @@ static int32_t _getTimeout()
     return size;
 }
 
+static std::string _getInstanceCacheFile()
+{
+    const char* env = getenv( "CO_INSTANCE_CACHE_FILE" );
+    return env ? env : std::string();
+}
+
 uint16_t    _defaultPort = 0;
 uint32_t    _objectBufferSize = _getObjectBufferSize();
+std::string _instanceCacheFile = _getInstanceCacheFile();
 int32_t     _iAttributes[Global::IATTR_ALL] =
 {
     100,   // INSTANCE_CACHE_SIZE
@@ -93,7 +100,15 @@ int32_t     _iAttributes[Global::IATTR_ALL] =
     5000,   // RDMA_RESOLVE_TIMEOUT_MS
     1,      // IATTR_ROBUSTNESS
     _getTimeout(), // IATTR_TIMEOUT_DEFAULT
-    1023    // IATTR_OBJECT_COMPRESSION
+    1023,   // IATTR_OBJECT_COMPRESSION
+    0,      // IATTR_OBJECT_RELAY_FANOUT
+    4096,   // IATTR_INSTANCE_CACHE_FILE_SIZE
+    0,      // IATTR_OBJECT_HISTORY_SIZE
+    0,      // IATTR_HUGE_PAGE_BUFFER_SIZE
+    0,      // IATTR_MEMORY_BUDGET
+    1,      // IATTR_NUMA_AFFINITY
+    0,      // IATTR_COMMAND_POOL_THREADS
+    0       // IATTR_OBJECT_COMMAND_SIZE
 };
 }
 
@@ -168,6 +183,16 @@ uint32_t Global::getObjectBufferSize()
     return  _objectBufferSize;
 }
 
+void Global::setInstanceCacheFile( const std::string& filename )
+{
+    _instanceCacheFile = filename;
+}
+
+const std::string& Global::getInstanceCacheFile()
+{
+    return _instanceCacheFile;
+}
+
 lunchbox::PluginRegistry& Global::getPluginRegistry()
 {
     static lunchbox::PluginRegistry pluginRegistry;
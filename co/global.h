@@ -54,6 +54,24 @@ namespace co
          */
         CO_API static uint32_t getObjectBufferSize();
 
+        /**
+         * Set the file persisting the instance cache across restarts.
+         *
+         * When set, all object data cached by the instance cache of local
+         * nodes created afterwards is also written to this file. Slave objects
+         * mapped after a restart load their data from the file, and only
+         * receive the versions missing in the file from their master. Each
+         * local node needs its own file. The default is the value of the
+         * environment variable CO_INSTANCE_CACHE_FILE, or empty for no file.
+         *
+         * @param filename the cache file, or empty to disable it.
+         * @version 1.0
+         */
+        CO_API static void setInstanceCacheFile( const std::string& filename );
+
+        /** @return the instance cache file, or empty. @version 1.0 */
+        CO_API static const std::string& getInstanceCacheFile();
+
         /** @internal
          * Set the global variables.
          *
@@ -101,6 +119,14 @@ namespace co
             IATTR_ROBUSTNESS,            //!< @internal use robustness
             IATTR_TIMEOUT_DEFAULT,       //!< @internal default timeout
             IATTR_OBJECT_COMPRESSION,    //!< @internal threshold to compress
+            IATTR_OBJECT_RELAY_FANOUT,   //!< @internal commit relays, 0: off
+            IATTR_INSTANCE_CACHE_FILE_SIZE, //!< @internal max file size in MB
+            IATTR_OBJECT_HISTORY_SIZE,   //!< @internal master RAM in MB, 0: all
+            IATTR_HUGE_PAGE_BUFFER_SIZE, //!< @internal min MB to use, 0: off
+            IATTR_MEMORY_BUDGET,         //!< @internal node RAM in MB, 0: off
+            IATTR_NUMA_AFFINITY,         //!< @internal bind threads near NIC
+            IATTR_COMMAND_POOL_THREADS,  //!< @internal object command workers
+            IATTR_OBJECT_COMMAND_SIZE,   //!< @internal max KB per send, 0: off
             IATTR_ALL
         };
 
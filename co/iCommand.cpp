@@ -39,6 +39,7 @@ public:
         , type( COMMANDTYPE_INVALID )
         , cmd( CMD_INVALID )
         , consumed( false )
+        , priority( false )
     {}
 
     ICommand( LocalNodePtr local_, NodePtr remote_, ConstBufferPtr buffer_ )
@@ -50,6 +51,7 @@ public:
         , type( COMMANDTYPE_INVALID )
         , cmd( CMD_INVALID )
         , consumed( false )
+        , priority( false )
     {}
 
     void clear()
@@ -65,6 +67,7 @@ public:
     uint32_t type;
     uint32_t cmd;
     bool consumed;
+    bool priority;
 };
 } // detail namespace
 
@@ -151,6 +154,16 @@ void ICommand::setDispatchFunction( const Dispatcher::Func& func )
     _impl->func = func;
 }
 
+void ICommand::setPriority( const bool priority )
+{
+    _impl->priority = priority;
+}
+
+bool ICommand::isPriority() const
+{
+    return _impl->priority;
+}
+
 ConstBufferPtr ICommand::getBuffer() const
 {
     LBASSERT( _impl->buffer );
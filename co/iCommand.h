@@ -97,6 +97,12 @@ namespace detail { class ICommand; }
         /** @internal Set the function to which the command is dispatched. */
         void setDispatchFunction( const Dispatcher::Func& func );
 
+        /** @internal Execute the command before the normal queued commands. */
+        void setPriority( const bool priority );
+
+        /** @internal @return true if the command is latency-critical. */
+        CO_API bool isPriority() const;
+
         /** @internal Invoke and clear the command function. */
         CO_API bool operator()();
         //@}
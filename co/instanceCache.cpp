@@ -20,6 +20,8 @@
 
 #include "instanceCache.h"
 
+#include "instanceCacheFile.h"
+#include "log.h"
 #include "objectDataICommand.h"
 #include "objectDataIStream.h"
 #include "objectVersion.h"
@@ -33,8 +35,6 @@ namespace co
 #ifdef EQ_INSTRUMENT_CACHE
 namespace
 {
-lunchbox::a_int32_t nRead;
-lunchbox::a_int32_t nReadHit;
 lunchbox::a_int32_t nWrite;
 lunchbox::a_int32_t nWriteHit;
 lunchbox::a_int32_t nWriteMiss;
@@ -47,21 +47,40 @@ lunchbox::a_int32_t nUnusedRelease;
 
 const InstanceCache::Data InstanceCache::Data::NONE;
 
-InstanceCache::InstanceCache( const uint64_t maxSize )
+InstanceCache::InstanceCache( const uint64_t maxSize,
+                              const std::string& filename,
+                              const uint64_t maxFileSize )
         : _maxSize( maxSize )
         , _size( 0 )
+        , _hits( 0 )
+        , _misses( 0 )
+        , _evictions( 0 )
+        , _file( filename.empty() ? 0 :
+                 new InstanceCacheFile( filename, maxFileSize ))
 {}
 
 InstanceCache::~InstanceCache()
 {
-    for( ItemHash::iterator i = _items->begin(); i != _items->end(); ++i )
+    for( size_t i = 0; i < NUM_SHARDS; ++i )
     {
-        Item& item = i->second;
-        _releaseStreams( item );
-    }
+        Shard& shard = _shards[ i ];
+        for( ItemHashIter j = shard.items.begin(); j != shard.items.end(); ++j )
+        {
+            Item& item = j->second;
+            _releaseStreams( item );
+        }
 
-    _items->clear();
+        shard.items.clear();
+        shard.usedLRU.clear();
+        shard.unusedLRU.clear();
+    }
     _size = 0;
+    delete _file;
+}
+
+uint64_t InstanceCache::getFileQueueSize() const
+{
+    return _file ? _file->getQueuedSize() : 0;
 }
 
 InstanceCache::Data::Data()
@@ -83,8 +102,34 @@ bool InstanceCache::Data::operator == ( const InstanceCache::Data& rhs ) const
 InstanceCache::Item::Item()
         : used( 0 )
         , access( 0 )
+        , lruList( 0 )
 {}
 
+InstanceCache::Shard& InstanceCache::_getShard( const UUID& id )
+{
+    return _shards[ ( id.high() ^ id.low( )) % NUM_SHARDS ];
+}
+
+void InstanceCache::_unlink( Item& item )
+{
+    if( !item.lruList )
+        return;
+
+    item.lruList->erase( item.lru );
+    item.lruList = 0;
+}
+
+void InstanceCache::_touch( Shard& shard, const UUID& id, Item& item )
+{
+    _unlink( item );
+    if( item.access != 0 || item.data.versions.empty( ))
+        return; // pinned items are not evicted
+
+    item.lruList = item.used ? &shard.usedLRU : &shard.unusedLRU;
+    item.lruList->push_front( id );
+    item.lru = item.lruList->begin();
+}
+
 bool InstanceCache::add( const ObjectVersion& rev, const uint32_t instanceID,
                          ICommand& command, const uint32_t usage )
 {
@@ -95,90 +140,97 @@ bool InstanceCache::add( const ObjectVersion& rev, const uint32_t instanceID,
 #endif
 
     const NodeID nodeID = command.getNode()->getNodeID();
-
-    lunchbox::ScopedMutex<> mutex( _items );
-    ItemHash::const_iterator i = _items->find( rev.identifier );
-    if( i == _items->end( ))
+    Shard& shard = _getShard( rev.identifier );
     {
-        Item& item = _items.data[ rev.identifier ];
-        item.data.masterInstanceID = instanceID;
-        item.from = nodeID;
-    }
-
-    Item& item = _items.data[ rev.identifier ] ;
-    if( item.data.masterInstanceID != instanceID || item.from != nodeID )
-    {
-        LBASSERT( !item.access ); // same master with different instance ID?!
-        if( item.access != 0 ) // are accessed - don't add
-            return false;
-        // trash data from different master mapping
-        _releaseStreams( item );
-        item.data.masterInstanceID = instanceID;
-        item.from = nodeID;
-        item.used = usage;
-    }
-    else
-        item.used = LB_MAX( item.used, usage );
+        lunchbox::ScopedMutex<> mutex( shard.lock );
+        ItemHash::const_iterator i = shard.items.find( rev.identifier );
+        if( i == shard.items.end( ))
+        {
+            Item& item = shard.items[ rev.identifier ];
+            item.data.masterInstanceID = instanceID;
+            item.from = nodeID;
+        }
 
-    if( item.data.versions.empty( ))
-    {
-        item.data.versions.push_back( new ObjectDataIStream );
-        item.times.push_back( _clock.getTime64( ));
-    }
-    else if( item.data.versions.back()->getPendingVersion() == rev.version )
-    {
-        if( item.data.versions.back()->isReady( ))
+        Item& item = shard.items[ rev.identifier ] ;
+        if( item.data.masterInstanceID != instanceID || item.from != nodeID )
         {
-#ifdef EQ_INSTRUMENT_CACHE
-            ++nWriteReady;
-#endif
-            return false; // Already have stream
+            // same master with different instance ID?!
+            LBASSERT( !item.access );
+            if( item.access != 0 ) // are accessed - don't add
+                return false;
+            // trash data from different master mapping
+            _releaseStreams( item );
+            item.data.masterInstanceID = instanceID;
+            item.from = nodeID;
+            item.used = usage;
         }
-        // else append data to stream
-    }
-    else
-    {
-        const ObjectDataIStream* previous = item.data.versions.back();
-        LBASSERT( previous->isReady( ));
+        else
+            item.used = LB_MAX( item.used, usage );
 
-        const uint128_t previousVersion = previous->getPendingVersion();
-        if( previousVersion > rev.version )
+        if( item.data.versions.empty( ))
         {
+            item.data.versions.push_back( new ObjectDataIStream );
+            item.times.push_back( _clock.getTime64( ));
+        }
+        else if( item.data.versions.back()->getPendingVersion() == rev.version )
+        {
+            if( item.data.versions.back()->isReady( ))
+            {
 #ifdef EQ_INSTRUMENT_CACHE
-            ++nWriteOld;
+                ++nWriteReady;
 #endif
-            return false;
+                return false; // Already have stream
+            }
+            // else append data to stream
         }
-        if( ( previousVersion + 1 ) != rev.version ) // hole
+        else
         {
-            LBASSERT( previousVersion < rev.version );
+            const ObjectDataIStream* previous = item.data.versions.back();
+            LBASSERT( previous->isReady( ));
 
-            if( item.access != 0 ) // are accessed - don't add
+            const uint128_t previousVersion = previous->getPendingVersion();
+            if( previousVersion > rev.version )
+            {
+#ifdef EQ_INSTRUMENT_CACHE
+                ++nWriteOld;
+#endif
                 return false;
+            }
+            if( ( previousVersion + 1 ) != rev.version ) // hole
+            {
+                LBASSERT( previousVersion < rev.version );
 
-            _releaseStreams( item );
-        }
-        else
-        {
-            LBASSERT( previous->isReady( ));
+                if( item.access != 0 ) // are accessed - don't add
+                    return false;
+
+                _releaseStreams( item );
+            }
+            else
+            {
+                LBASSERT( previous->isReady( ));
+            }
+            item.data.versions.push_back( new ObjectDataIStream );
+            item.times.push_back( _clock.getTime64( ));
         }
-        item.data.versions.push_back( new ObjectDataIStream );
-        item.times.push_back( _clock.getTime64( ));
-    }
 
-    LBASSERT( !item.data.versions.empty( ));
-    ObjectDataIStream* stream = item.data.versions.back();
+        LBASSERT( !item.data.versions.empty( ));
+        ObjectDataIStream* stream = item.data.versions.back();
 
-    stream->addDataCommand( command );
+        stream->addDataCommand( command );
+        if( stream->isReady( ))
+            _size += stream->getDataSize();
+        _touch( shard, rev.identifier, item );
+    }
 
-    if( stream->isReady( ))
-        _size += stream->getDataSize();
+    if( _file ) // queued for the writer thread, outside of the shard lock
+        _file->write( rev.identifier, nodeID, instanceID, command );
 
     _releaseItems( 1 );
     _releaseItems( 0 );
 
 #ifdef EQ_INSTRUMENT_CACHE
-    if( _items->find( rev.identifier ) != _items->end( ))
+    lunchbox::ScopedMutex<> mutex( shard.lock );
+    if( shard.items.find( rev.identifier ) != shard.items.end( ))
         ++nWriteHit;
     else
         ++nWriteMiss;
@@ -188,81 +240,144 @@ bool InstanceCache::add( const ObjectVersion& rev, const uint32_t instanceID,
 
 void InstanceCache::remove( const NodeID& nodeID )
 {
-    std::vector< lunchbox::uint128_t > keys;
-
-    lunchbox::ScopedMutex<> mutex( _items );
-    for( ItemHash::iterator i = _items->begin(); i != _items->end(); ++i )
+    for( size_t i = 0; i < NUM_SHARDS; ++i )
     {
-        Item& item = i->second;
-        if( item.from != nodeID )
-            continue;
+        Shard& shard = _shards[ i ];
+        std::vector< lunchbox::uint128_t > keys;
+
+        lunchbox::ScopedMutex<> mutex( shard.lock );
+        for( ItemHashIter j = shard.items.begin(); j != shard.items.end(); ++j )
+        {
+            Item& item = j->second;
+            if( item.from != nodeID )
+                continue;
+
+            LBASSERT( !item.access );
+            if( item.access != 0 )
+                continue;
+
+            _unlink( item );
+            _releaseStreams( item );
+            keys.push_back( j->first );
+        }
+
+        for( std::vector< lunchbox::uint128_t >::const_iterator j =
+                 keys.begin(); j != keys.end(); ++j )
+        {
+            shard.items.erase( *j );
+        }
+    }
+}
 
-        LBASSERT( !item.access );
-        if( item.access != 0 )
-            continue;
+bool InstanceCache::load( const UUID& id, LocalNodePtr localNode,
+                          NodePtr master )
+{
+    Shard& shard = _getShard( id );
+    {
+        lunchbox::ScopedMutex<> mutex( shard.lock );
+        if( shard.items.find( id ) != shard.items.end( ))
+            return true;
+    }
 
-        _releaseStreams( item );
-        keys.push_back( i->first );
+    uint32_t masterInstanceID = EQ_INSTANCE_INVALID;
+    ObjectDataIStreamDeque versions;
+    if( !_file || !_file->read( id, localNode, master, masterInstanceID,
+                                versions ))
+    {
+        return false;
     }
 
-    for( std::vector< lunchbox::uint128_t >::const_iterator i = keys.begin();
-         i != keys.end(); ++i )
     {
-        _items->erase( *i );
+        lunchbox::ScopedMutex<> mutex( shard.lock );
+        if( shard.items.find( id ) != shard.items.end( ))
+        {
+            // data received meanwhile
+            for( ObjectDataIStreamDeque::const_iterator i = versions.begin();
+                 i != versions.end(); ++i )
+            {
+                delete *i;
+            }
+            return true;
+        }
+
+        Item& item = shard.items[ id ];
+        item.data.masterInstanceID = masterInstanceID;
+        item.data.versions = versions;
+        item.from = master->getNodeID();
+
+        const int64_t time = _clock.getTime64();
+        for( ObjectDataIStreamDeque::const_iterator i = versions.begin();
+             i != versions.end(); ++i )
+        {
+            item.times.push_back( time );
+            _size += (*i)->getDataSize();
+        }
+        _touch( shard, id, item );
     }
+
+    LBLOG( LOG_OBJECTS ) << "Loaded " << versions.size() << " versions of "
+                         << id << " from cache file" << std::endl;
+    _releaseItems( 1 );
+    _releaseItems( 0 );
+    return true;
 }
 
 const InstanceCache::Data& InstanceCache::operator[]( const UUID& id )
 {
-#ifdef EQ_INSTRUMENT_CACHE
-    ++nRead;
-#endif
-
-    lunchbox::ScopedMutex<> mutex( _items );
-    ItemHash::iterator i = _items->find( id );
-    if( i == _items->end( ))
+    Shard& shard = _getShard( id );
+    lunchbox::ScopedMutex<> mutex( shard.lock );
+    ItemHashIter i = shard.items.find( id );
+    if( i == shard.items.end( ))
+    {
+        ++_misses;
         return Data::NONE;
+    }
 
     Item& item = i->second;
     LBASSERT( !item.data.versions.empty( ));
     ++item.access;
     ++item.used;
+    _touch( shard, id, item );
 
-#ifdef EQ_INSTRUMENT_CACHE
-    ++nReadHit;
-#endif
+    ++_hits;
     return item.data;
 }
 
 bool InstanceCache::release( const UUID& id, const uint32_t count )
 {
-    lunchbox::ScopedMutex<> mutex( _items );
-    ItemHash::iterator i = _items->find( id );
-    if( i == _items->end( ))
-        return false;
+    {
+        Shard& shard = _getShard( id );
+        lunchbox::ScopedMutex<> mutex( shard.lock );
+        ItemHashIter i = shard.items.find( id );
+        if( i == shard.items.end( ))
+            return false;
 
-    Item& item = i->second;
-    LBASSERT( !item.data.versions.empty( ));
-    LBASSERT( item.access >= count );
+        Item& item = i->second;
+        LBASSERT( !item.data.versions.empty( ));
+        LBASSERT( item.access >= count );
 
-    item.access -= count;
+        item.access -= count;
+        _touch( shard, id, item );
+    }
     _releaseItems( 1 );
     return true;
 }
 
 bool InstanceCache::erase( const UUID& id )
 {
-    lunchbox::ScopedMutex<> mutex( _items );
-    ItemHash::iterator i = _items->find( id );
-    if( i == _items->end( ))
+    Shard& shard = _getShard( id );
+    lunchbox::ScopedMutex<> mutex( shard.lock );
+    ItemHashIter i = shard.items.find( id );
+    if( i == shard.items.end( ))
         return false;
 
     Item& item = i->second;
     if( item.access != 0 )
         return false;
 
+    _unlink( item );
     _releaseStreams( item );
-    _items->erase( i );
+    shard.items.erase( i );
     return true;
 }
 
@@ -272,25 +387,52 @@ void InstanceCache::expire( const int64_t timeout )
     if( time <= 0 )
         return;
 
-    std::vector< lunchbox::uint128_t > keys;
-
-    lunchbox::ScopedMutex<> mutex( _items );
-    for( ItemHash::iterator i = _items->begin(); i != _items->end(); ++i )
+    for( size_t i = 0; i < NUM_SHARDS; ++i )
     {
-        Item& item = i->second;
-        if( item.access != 0 )
-            continue;
+        Shard& shard = _shards[ i ];
+        std::vector< lunchbox::uint128_t > keys;
 
-        _releaseStreams( item, time );
-        if( item.data.versions.empty( ))
-            keys.push_back( i->first );
+        lunchbox::ScopedMutex<> mutex( shard.lock );
+        for( ItemHashIter j = shard.items.begin(); j != shard.items.end(); ++j )
+        {
+            Item& item = j->second;
+            if( item.access != 0 )
+                continue;
+
+            _releaseStreams( item, time );
+            if( item.data.versions.empty( ))
+            {
+                _unlink( item );
+                keys.push_back( j->first );
+            }
+        }
+
+        for( std::vector< lunchbox::uint128_t >::const_iterator j =
+                 keys.begin(); j != keys.end(); ++j )
+        {
+            shard.items.erase( *j );
+        }
     }
+}
 
-    for( std::vector< lunchbox::uint128_t >::const_iterator i = keys.begin();
-         i != keys.end(); ++i )
+void InstanceCache::shrink( const uint64_t size )
+{
+    while( _size > size && _releaseLRU( true, size ))
+        /* nop */ ;
+    while( _size > size && _releaseLRU( false, size ))
+        /* nop */ ;
+}
+
+bool InstanceCache::isEmpty()
+{
+    for( size_t i = 0; i < NUM_SHARDS; ++i )
     {
-        _items->erase( *i );
+        Shard& shard = _shards[ i ];
+        lunchbox::ScopedMutex<> mutex( shard.lock );
+        if( !shard.items.empty( ))
+            return false;
     }
+    return true;
 }
 
 void InstanceCache::_releaseStreams( InstanceCache::Item& item,
@@ -345,83 +487,88 @@ void InstanceCache::_releaseItems( const uint32_t minUsage )
     if( _size <= _maxSize )
         return;
 
-    LB_TS_SCOPED( _thread );
-
-    std::vector< lunchbox::uint128_t > keys;
     const uint64_t target = uint64_t( float( _maxSize ) * 0.8f );
 
-    // Release used items (first stream)
-    bool streamsLeft = false;
-    for( ItemHashIter i = _items->begin();
-         i != _items->end() && _size > target; ++i )
-    {
-        Item& item = i->second;
-        LBASSERT( !item.data.versions.empty( ));
+    // Release used items, then unused items, least recently used first
+    while( _size > target && _releaseLRU( true, target ))
+        /* nop */ ;
+    if( minUsage > 0 )
+        return;
 
-        if( item.access == 0 && item.used >= minUsage )
-        {
-            _releaseFirstStream( item );
-            if( !item.data.versions.empty( ))
-                streamsLeft = true;
+    while( _size > target && _releaseLRU( false, target ))
+        /* nop */ ;
 
-            keys.push_back( i->first );
-#ifdef EQ_INSTRUMENT_CACHE
-            ++nUsedRelease;
-#endif
-        }
-    }
+    if( _size > target )
+        LBWARN << "Overfull instance cache, too many pinned items, size "
+               << uint64_t( _size ) << " target " << target << " max "
+               << _maxSize << ": " << *this << std::endl;
+}
+
+bool InstanceCache::_releaseLRU( const bool used, const uint64_t target )
+{
+    // Each shard releases its share of the excess per round, which
+    // approximates a global LRU order without holding more than one lock.
+    const uint64_t size = _size;
+    if( size <= target )
+        return false;
+
+    const uint64_t quota = ( size - target ) / NUM_SHARDS + 1;
+    bool released = false;
 
-    // release used items (second..n streams)
-    while( streamsLeft && _size > target )
+    for( size_t i = 0; i < NUM_SHARDS && _size > target; ++i )
     {
-        streamsLeft = false;
+        Shard& shard = _shards[ i ];
+        lunchbox::ScopedMutex<> mutex( shard.lock );
+        LRUList& lru = used ? shard.usedLRU : shard.unusedLRU;
 
-        for( std::vector< lunchbox::uint128_t >::const_iterator i = keys.begin();
-             i != keys.end() && _size > target; ++i )
+        uint64_t freed = 0;
+        while( !lru.empty() && freed < quota && _size > target )
         {
-            Item& item = _items.data[ *i ];
-
-            if( !item.data.versions.empty() && item.access == 0 &&
-                item.used >= minUsage )
+            const lunchbox::uint128_t id = lru.back();
+            ItemHashIter j = shard.items.find( id );
+            LBASSERT( j != shard.items.end( ));
+            Item& item = j->second;
+            LBASSERT( item.access == 0 );
+            released = true;
+
+            const ObjectDataIStream* stream = item.data.versions.front();
+            if( !stream->isReady( ))
             {
-                _releaseFirstStream( item );
-                if( !item.data.versions.empty( ))
-                    streamsLeft = true;
+                // still receiving, relisted by the next add()
+                _unlink( item );
+                continue;
+            }
+
+            freed += stream->getDataSize();
+            _releaseFirstStream( item );
+            ++_evictions;
 #ifdef EQ_INSTRUMENT_CACHE
+            if( used )
                 ++nUsedRelease;
+            else
+                ++nUnusedRelease;
 #endif
+            if( item.data.versions.empty( ))
+            {
+                _unlink( item );
+                shard.items.erase( j );
             }
         }
     }
-
-    for( std::vector< lunchbox::uint128_t >::const_iterator i = keys.begin();
-         i != keys.end(); ++i )
-    {
-        Item& item = _items.data[ *i ];
-        if( item.data.versions.empty( ))
-            _items->erase( *i );
-    }
-
-    if( _size > target && minUsage == 0 )
-        LBWARN << "Overfull instance cache, too many pinned items, size "
-               << _size << " target " << target << " max " << _maxSize
-               << " " << _items->size() << " entries"
-#ifdef EQ_INSTRUMENT_CACHE
-               << ": " << *this
-#endif
-               << std::endl;
+    return released;
 }
 
 std::ostream& operator << ( std::ostream& os,
                             const InstanceCache& instanceCache )
 {
     os << "InstanceCache " << instanceCache.getSize() / 1048576 << "/"
-       << instanceCache.getMaxSize() / 1048576 << " MB"
+       << instanceCache.getMaxSize() / 1048576 << " MB, "
+       << instanceCache.getHits() << " hits, " << instanceCache.getMisses()
+       << " misses, " << instanceCache.getEvictions() << " evictions"
 #ifdef EQ_INSTRUMENT_CACHE
-       << ", " << nReadHit << "/" << nRead << " reads, " << nWriteHit
-       << "/" << nWrite << " writes (" << nWriteMiss << " misses, " << nWriteOld
-       << " old, " << nWriteReady << " dups) " << nUsedRelease << " used, "
-       << nUnusedRelease << " unused releases"
+       << ", " << nWriteHit << "/" << nWrite << " writes (" << nWriteMiss
+       << " misses, " << nWriteOld << " old, " << nWriteReady << " dups) "
+       << nUsedRelease << " used, " << nUnusedRelease << " unused releases"
 #endif
         ;
     return os;
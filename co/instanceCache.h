@@ -24,23 +24,43 @@
 #include <co/api.h>
 #include <co/types.h>
 
+#include <lunchbox/atomic.h>    // member
 #include <lunchbox/clock.h>     // member
 #include <lunchbox/lock.h>      // member
-#include <lunchbox/lockable.h>  // member
 #include <lunchbox/stdExt.h>    // member
-#include <lunchbox/thread.h>    // member
 #include <lunchbox/uuid.h>      // member
 
 #include <iostream>
+#include <list>
 
 namespace co
 {
-    /** @internal A thread-safe cache for object instance data. */
+    class InstanceCacheFile;
+
+    /**
+     * @internal A thread-safe cache for object instance data.
+     *
+     * The cache is split into shards by object identifier, each with its own
+     * lock. Unpinned items are kept in least-recently-used order, separately
+     * for items which have been used for a mapping and items which have not,
+     * so that eviction does not need to search the cache.
+     *
+     * Optionally, all added data is also written to an InstanceCacheFile,
+     * from which the data of an object can be loaded back after a restart.
+     */
     class InstanceCache
     {
     public:
-        /** Construct a new instance cache. */
-        CO_API InstanceCache( const uint64_t maxSize = LB_100MB );
+        /**
+         * Construct a new instance cache.
+         *
+         * @param maxSize the maximum size of the data kept in memory.
+         * @param filename the persistent cache file, or empty for none.
+         * @param maxFileSize the maximum size of the cache file.
+         */
+        CO_API InstanceCache( const uint64_t maxSize = LB_100MB,
+                              const std::string& filename = std::string(),
+                              const uint64_t maxFileSize = 0 );
 
         /** Destruct this instance cache. */
         CO_API ~InstanceCache();
@@ -60,6 +80,17 @@ namespace co
         /** Remove all items from the given node. */
         void remove( const NodeID& node );
 
+        /**
+         * Load the data of an object from the cache file into memory.
+         *
+         * Only data received from the given master node is loaded. Nothing
+         * is loaded if data for the object is already in memory.
+         *
+         * @return true if data for the object is in memory.
+         */
+        CO_API bool load( const UUID& id, LocalNodePtr localNode,
+                          NodePtr master );
+
         /** One cache entry */
         struct Data
         {
@@ -109,15 +140,32 @@ namespace co
         /** @return the number of bytes used by the instance cache. */
         uint64_t getSize() const { return _size; }
 
+        /** @return the bytes queued for writing to the cache file. */
+        uint64_t getFileQueueSize() const;
+
         /** @return the maximum number of bytes used by the instance cache. */
         uint64_t getMaxSize() const { return _maxSize; }
 
         /** Remove all items which are older than the given time. */
         void expire( const int64_t age );
 
-        bool isEmpty() { return _items->empty(); }
+        /** Release unpinned items, least recently used first, to size. */
+        void shrink( const uint64_t size );
+
+        bool isEmpty();
+
+        /** @return the number of lookups which found cached data. */
+        uint64_t getHits() const { return _hits; }
+
+        /** @return the number of lookups which found no cached data. */
+        uint64_t getMisses() const { return _misses; }
+
+        /** @return the number of versions evicted due to the size limit. */
+        uint64_t getEvictions() const { return _evictions; }
 
     private:
+        typedef std::list< lunchbox::uint128_t > LRUList;
+
         struct Item
         {
             Item();
@@ -128,25 +176,46 @@ namespace co
 
             typedef std::deque< int64_t > TimeDeque;
             TimeDeque times;
+
+            LRUList* lruList;    //!< the LRU list containing this, or 0
+            LRUList::iterator lru; //!< the position in lruList
         };
 
         typedef stde::hash_map< lunchbox::uint128_t, Item > ItemHash;
         typedef ItemHash::iterator ItemHashIter;
-        lunchbox::Lockable< ItemHash > _items;
+
+        struct Shard
+        {
+            lunchbox::Lock lock;
+            ItemHash items;
+            LRUList usedLRU;   //!< unpinned used items, most recent first
+            LRUList unusedLRU; //!< unpinned unused items, most recent first
+        };
+
+        enum { NUM_SHARDS = 16 };
+        Shard _shards[ NUM_SHARDS ];
 
         const uint64_t _maxSize; //!<high-water mark to start releasing commands
-        uint64_t _size;          //!< Current number of bytes stored
+        lunchbox::Atomic< uint64_t > _size; //!< Current number of bytes stored
+
+        lunchbox::Atomic< uint64_t > _hits;
+        lunchbox::Atomic< uint64_t > _misses;
+        lunchbox::Atomic< uint64_t > _evictions;
 
         const lunchbox::Clock _clock;  //!< Clock for item expiration
+        InstanceCacheFile* const _file; //!< The persistent second tier
+
+        Shard& _getShard( const UUID& id );
+        void _touch( Shard& shard, const UUID& id, Item& item );
+        void _unlink( Item& item );
 
         void _releaseItems( const uint32_t minUsage );
+        bool _releaseLRU( const bool used, const uint64_t target );
         void _releaseStreams( InstanceCache::Item& item );
         void _releaseStreams( InstanceCache::Item& item,
                               const int64_t minTime );
         void _releaseFirstStream( InstanceCache::Item& item );
         void _deleteStream( ObjectDataIStream* iStream );
-
-        LB_TS_VAR( _thread );
     };
 
     CO_API std::ostream& operator << ( std::ostream&, const InstanceCache& );
@@ -0,0 +1,457 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "instanceCacheFile.h"
+
+#include "buffer.h"
+#include "bufferListener.h"
+#include "commands.h"
+#include "log.h"
+#include "objectDataICommand.h"
+#include "objectDataIStream.h"
+
+#include <lunchbox/scopedMutex.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace co
+{
+namespace
+{
+static const uint64_t _magic = 0x434f494341434845ull; // "COICACHE"
+
+/** The maximum amount of command data queued for the writer thread. */
+static const uint64_t _maxQueuedSize = 64 * LB_1MB;
+
+/** The fixed-size header preceding the command data of each record. */
+struct Header
+{
+    uint64_t magic;
+    uint64_t id[2];
+    uint64_t master[2];
+    uint64_t masterInstanceID;
+    uint64_t type;
+    uint64_t command;
+    uint64_t swap;
+    uint64_t size;
+};
+
+/** Deletes the buffers of the commands read from the file once unused. */
+class DeleteListener : public BufferListener
+{
+public:
+    virtual void notifyFree( Buffer* buffer ) { delete buffer; }
+};
+static DeleteListener _deleteListener;
+
+void _clear( ObjectDataIStreamDeque& versions )
+{
+    while( !versions.empty( ))
+    {
+        delete versions.back();
+        versions.pop_back();
+    }
+}
+}
+
+InstanceCacheFile::InstanceCacheFile( const std::string& filename,
+                                      const uint64_t maxSize )
+    : _filename( filename )
+    , _maxSize( maxSize )
+    , _end( 0 )
+    , _size( 0 )
+    , _used( 0 )
+    , _writer( 0 )
+    , _queued( 0 )
+    , _queuedSize( 0 )
+    , _written( 0 )
+{
+    _index();
+
+    // create the file if needed, without truncating existing records
+    { std::ofstream create( _filename.c_str(), std::ios::app ); }
+
+    _file.open( _filename.c_str(),
+                std::ios::in | std::ios::out | std::ios::binary );
+    if( !_file.is_open( ))
+    {
+        LBWARN << "Can't open instance cache file " << _filename << std::endl;
+        return;
+    }
+
+    // overwrite a partially written record at the end
+    _file.seekp( _end );
+
+    _writer = new Writer( *this );
+    if( !_writer->start( ))
+    {
+        LBWARN << "Can't start instance cache file writer" << std::endl;
+        delete _writer;
+        _writer = 0;
+        _file.close();
+        return;
+    }
+    LBINFO << "Opened instance cache file " << _filename << " with "
+           << _records.size() << " objects, " << _end / LB_1MB << " MB"
+           << std::endl;
+}
+
+InstanceCacheFile::~InstanceCacheFile()
+{
+    if( _writer )
+    {
+        _queue.push( Record( ));
+        _writer->join();
+        delete _writer;
+        _writer = 0;
+    }
+    _map.unmap();
+    if( _file.is_open( ))
+        _file.close();
+}
+
+void InstanceCacheFile::_index()
+{
+    if( !std::ifstream( _filename.c_str( )) || !_map.map( _filename ))
+        return;
+
+    const uint8_t* data = static_cast< const uint8_t* >( _map.getAddress( ));
+    const uint64_t size = _map.getSize();
+
+    while( _end + sizeof( Header ) <= size )
+    {
+        Header header;
+        ::memcpy( &header, data + _end, sizeof( Header ));
+        if( header.magic != _magic ||
+            header.size > size - _end - sizeof( Header ))
+        {
+            LBINFO << "Ignoring " << size - _end << " bytes at the end of "
+                   << _filename << std::endl;
+            break;
+        }
+
+        const UUID id( header.id[0], header.id[1] );
+        const uint64_t recordSize = sizeof( Header ) + header.size;
+        Entry& entry = _records[ id ];
+        entry.offsets.push_back( _end );
+        entry.size += recordSize;
+        entry.used = ++_used;
+        _size += recordSize;
+        _end += recordSize;
+    }
+    _map.unmap();
+}
+
+void InstanceCacheFile::_reset()
+{
+    LBINFO << "Restarting full instance cache file " << _filename
+           << std::endl;
+    _map.unmap();
+    _file.close();
+    _file.open( _filename.c_str(), std::ios::in | std::ios::out |
+                                   std::ios::binary | std::ios::trunc );
+    _records.clear();
+    _size = 0;
+    _end = 0;
+}
+
+void InstanceCacheFile::_evict( const uint64_t size )
+{
+    // drop the least recently used objects, leaving room for more records
+    const uint64_t target = _maxSize / 4 * 3;
+    std::vector< std::pair< uint64_t, lunchbox::uint128_t > > lru;
+    lru.reserve( _records.size( ));
+    for( EntryHash::const_iterator i = _records.begin(); i != _records.end();
+         ++i )
+    {
+        lru.push_back( std::make_pair( i->second.used, i->first ));
+    }
+    std::sort( lru.begin(), lru.end( ));
+
+    size_t nEvicted = 0;
+    for( ; nEvicted < lru.size() && _size + size > target; ++nEvicted )
+    {
+        EntryHash::iterator i = _records.find( lru[ nEvicted ].second );
+        _size -= i->second.size;
+        _records.erase( i );
+    }
+
+    LBINFO << "Evicted " << nEvicted << " objects from instance cache file "
+           << _filename << std::endl;
+    if( !_compact( ))
+        _reset();
+}
+
+bool InstanceCacheFile::_compact()
+{
+    // copy the remaining records to a new file replacing the old one
+    const std::string filename = _filename + ".tmp";
+    std::ofstream out( filename.c_str(), std::ios::out | std::ios::binary |
+                                         std::ios::trunc );
+    if( !out.is_open() || !_remap( _end ))
+        return false;
+
+    const uint8_t* data = static_cast< const uint8_t* >( _map.getAddress( ));
+    uint64_t end = 0;
+    for( EntryHash::iterator i = _records.begin(); i != _records.end(); ++i )
+    {
+        Offsets& offsets = i->second.offsets;
+        for( Offsets::iterator j = offsets.begin(); j != offsets.end(); ++j )
+        {
+            Header header;
+            ::memcpy( &header, data + *j, sizeof( Header ));
+            const uint64_t size = sizeof( Header ) + header.size;
+            out.write( reinterpret_cast< const char* >( data + *j ), size );
+            *j = end;
+            end += size;
+        }
+    }
+
+    const bool good = out.good();
+    out.close();
+    _map.unmap();
+    _file.close();
+#ifdef _WIN32 // rename does not replace existing files
+    ::remove( _filename.c_str( ));
+#endif
+    if( !good || ::rename( filename.c_str(), _filename.c_str( )) != 0 )
+    {
+        LBWARN << "Can't compact instance cache file " << _filename
+               << std::endl;
+        ::remove( filename.c_str( ));
+        return false;
+    }
+
+    _file.open( _filename.c_str(),
+                std::ios::in | std::ios::out | std::ios::binary );
+    _file.seekp( end );
+    _end = end;
+    _size = end;
+    return _file.is_open();
+}
+
+bool InstanceCacheFile::_remap( const uint64_t size )
+{
+    if( _map.getAddress() && _map.getSize() >= size )
+        return true;
+
+    _file.flush();
+    _map.unmap();
+    return _map.map( _filename ) && _map.getSize() >= size;
+}
+
+void InstanceCacheFile::write( const UUID& id, const NodeID& master,
+                               const uint32_t masterInstanceID,
+                               const ICommand& command )
+{
+    if( !_writer )
+        return;
+
+    // Drop the record rather than blocking the caller. The versions missing
+    // data are dropped when read back.
+    const uint64_t size = command.getSize();
+    if( _queuedSize + size > _maxQueuedSize )
+        return;
+
+    Record record;
+    record.id = id;
+    record.master = master;
+    record.masterInstanceID = masterInstanceID;
+    record.command = command;
+
+    lunchbox::ScopedMutex<> mutex( _queueLock );
+    record.sequence = ++_queued;
+    _lastQueued[ id ] = record.sequence;
+    _queuedSize += size;
+    _queue.push( record );
+}
+
+void InstanceCacheFile::_runWriter()
+{
+    while( true )
+    {
+        const Record record = _queue.pop();
+        if( !record.command.isValid( ))
+            break;
+
+        _write( record );
+        {
+            lunchbox::ScopedMutex<> mutex( _queueLock );
+            _queuedSize -= record.command.getSize();
+            SequenceHash::iterator i = _lastQueued.find( record.id );
+            if( i != _lastQueued.end() && i->second == record.sequence )
+                _lastQueued.erase( i );
+        }
+        ++_written;
+    }
+}
+
+void InstanceCacheFile::_write( const Record& record )
+{
+    const ICommand& command = record.command;
+    ConstBufferPtr buffer = command.getBuffer();
+    const uint64_t size = LB_MIN( command.getSize(), buffer->getSize( ));
+
+    lunchbox::ScopedMutex<> mutex( _lock );
+    if( !_file.is_open( ))
+        return;
+
+    const uint64_t recordSize = sizeof( Header ) + size;
+    if( _end + recordSize > _maxSize )
+    {
+        _evict( recordSize );
+        if( !_file.is_open() || _end + recordSize > _maxSize )
+            return;
+    }
+
+    Header header;
+    header.magic = _magic;
+    header.id[0] = record.id.high();
+    header.id[1] = record.id.low();
+    header.master[0] = record.master.high();
+    header.master[1] = record.master.low();
+    header.masterInstanceID = record.masterInstanceID;
+    header.type = command.getType();
+    header.command = command.getCommand();
+    header.swap = command.isSwapping();
+    header.size = size;
+
+    _file.write( reinterpret_cast< const char* >( &header ), sizeof( Header ));
+    _file.write( reinterpret_cast< const char* >( buffer->getData( )), size );
+
+    if( _queue.isEmpty( ))
+        _file.flush(); // idle, make the written versions survive a crash
+
+    if( !_file.good( ))
+    {
+        LBWARN << "Write to instance cache file " << _filename << " failed"
+               << std::endl;
+        _file.close();
+        return;
+    }
+
+    Entry& entry = _records[ record.id ];
+    entry.offsets.push_back( _end );
+    entry.size += recordSize;
+    entry.used = ++_used;
+    _size += recordSize;
+    _end += recordSize;
+}
+
+bool InstanceCacheFile::read( const UUID& id, LocalNodePtr localNode,
+                              NodePtr master, uint32_t& masterInstanceID,
+                              ObjectDataIStreamDeque& versions )
+{
+    uint64_t queued = 0;
+    {
+        lunchbox::ScopedMutex<> mutex( _queueLock );
+        SequenceHash::const_iterator i = _lastQueued.find( id );
+        if( i != _lastQueued.end( ))
+            queued = i->second;
+    }
+    _written.waitGE( queued ); // the records are written in queue order
+
+    lunchbox::ScopedMutex<> mutex( _lock );
+    EntryHash::iterator i = _records.find( id );
+    if( i == _records.end() || !_remap( _end ))
+        return false;
+
+    i->second.used = ++_used;
+    const uint8_t* data = static_cast< const uint8_t* >( _map.getAddress( ));
+    const Offsets& offsets = i->second.offsets;
+    const NodeID& masterID = master->getNodeID();
+
+    // use the most recent mapping from this master
+    Header header;
+    bool found = false;
+    for( Offsets::const_reverse_iterator j = offsets.rbegin();
+         j != offsets.rend() && !found; ++j )
+    {
+        ::memcpy( &header, data + *j, sizeof( Header ));
+        found = ( NodeID( header.master[0], header.master[1] ) == masterID );
+    }
+    if( !found )
+        return false;
+    masterInstanceID = uint32_t( header.masterInstanceID );
+
+    for( Offsets::const_iterator j = offsets.begin(); j != offsets.end(); ++j )
+    {
+        ::memcpy( &header, data + *j, sizeof( Header ));
+        if( NodeID( header.master[0], header.master[1] ) != masterID ||
+            header.masterInstanceID != masterInstanceID )
+        {
+            continue;
+        }
+
+        BufferPtr buffer = new Buffer( &_deleteListener );
+        buffer->replace( data + *j + sizeof( Header ), header.size );
+
+        ObjectDataICommand command( localNode, master, buffer,
+                                    header.swap != 0 );
+        command.setType( CommandType( header.type ));
+        command.setCommand( uint32_t( header.command ));
+        const uint128_t& version = command.getVersion();
+
+        if( !versions.empty( ))
+        {
+            ObjectDataIStream* last = versions.back();
+            if( last->getPendingVersion() == version )
+            {
+                if( last->isReady( ))
+                    continue; // stored again after a restart
+
+                if( command.getSequence() != 0 )
+                {
+                    last->addDataCommand( command );
+                    continue;
+                }
+            }
+
+            if( !last->isReady( )) // incomplete or restarted version
+            {
+                delete last;
+                versions.pop_back();
+            }
+        }
+
+        if( command.getSequence() != 0 ) // tail of a dropped version
+            continue;
+
+        if( !versions.empty() &&
+            versions.back()->getPendingVersion() + 1 != version )
+        {
+            _clear( versions ); // not consecutive, keep the newer versions
+        }
+
+        ObjectDataIStream* stream = new ObjectDataIStream;
+        stream->addDataCommand( command );
+        versions.push_back( stream );
+    }
+
+    if( !versions.empty() && !versions.back()->isReady( ))
+    {
+        delete versions.back();
+        versions.pop_back();
+    }
+    return !versions.empty();
+}
+
+}
@@ -0,0 +1,170 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_INSTANCECACHEFILE_H
+#define CO_INSTANCECACHEFILE_H
+
+#include <co/iCommand.h>      // member
+#include <co/types.h>
+
+#include <lunchbox/atomic.h>     // member
+#include <lunchbox/lock.h>       // member
+#include <lunchbox/memoryMap.h>  // member
+#include <lunchbox/monitor.h>    // member
+#include <lunchbox/mtQueue.h>    // member
+#include <lunchbox/nonCopyable.h> // base class
+#include <lunchbox/stdExt.h>     // member
+#include <lunchbox/thread.h>     // base class
+
+#include <fstream>
+
+namespace co
+{
+    /**
+     * @internal A persistent, append-only store for object instance data.
+     *
+     * Used as the second tier of the InstanceCache. Each data command of a
+     * cached object version is appended as one record keyed by the object
+     * identifier, the version and the master node. The records are indexed
+     * by object when the file is opened, and read back through a memory
+     * mapping. Since node identifiers are unique per process, records of a
+     * restarted master are never used. Once the file exceeds its maximum
+     * size, the records of the least recently used objects are evicted and
+     * the remaining ones are compacted into a new file.
+     *
+     * The records are written by a writer thread, which flushes the file
+     * whenever it runs out of queued records. The queue holds a bounded
+     * amount of data, records exceeding it are dropped.
+     */
+    class InstanceCacheFile : public lunchbox::NonCopyable
+    {
+    public:
+        /**
+         * Open or create the file, index all complete records and start the
+         * writer thread.
+         */
+        InstanceCacheFile( const std::string& filename,
+                           const uint64_t maxSize );
+
+        /** Write all queued records and close the file. */
+        ~InstanceCacheFile();
+
+        /** @return true if the file can be used. */
+        bool isOpen() const { return _file.is_open(); }
+
+        /** @return the number of bytes queued for the writer thread. */
+        uint64_t getQueuedSize() const { return _queuedSize; }
+
+        /**
+         * Queue one data command of a cached object version for appending.
+         *
+         * @param id the object identifier.
+         * @param master the master node identifier.
+         * @param masterInstanceID the instance identifier of the master.
+         * @param command the data command.
+         */
+        void write( const UUID& id, const NodeID& master,
+                    const uint32_t masterInstanceID, const ICommand& command );
+
+        /**
+         * Read the cached versions of an object from the given master.
+         *
+         * Waits for the queued records of the object to be written. Only the
+         * most recent mapping from the master is read. Incomplete
+         * versions are dropped, and only the consecutive versions up to the
+         * newest one are returned.
+         *
+         * @param id the object identifier.
+         * @param localNode the local node receiving the data.
+         * @param master the master node.
+         * @param masterInstanceID output: the instance ID of the master.
+         * @param versions output: the complete versions read.
+         * @return true if at least one version was read.
+         */
+        bool read( const UUID& id, LocalNodePtr localNode, NodePtr master,
+                   uint32_t& masterInstanceID,
+                   ObjectDataIStreamDeque& versions );
+
+    private:
+        typedef std::vector< uint64_t > Offsets;
+
+        /** The records of one object. */
+        struct Entry
+        {
+            Entry() : size( 0 ), used( 0 ) {}
+
+            Offsets offsets;
+            uint64_t size; //!< The bytes used by the records
+            uint64_t used; //!< The time of the last use, for LRU eviction
+        };
+        typedef stde::hash_map< lunchbox::uint128_t, Entry > EntryHash;
+        typedef stde::hash_map< lunchbox::uint128_t, uint64_t > SequenceHash;
+
+        /** One data command queued for the writer thread. */
+        struct Record
+        {
+            UUID id;
+            NodeID master;
+            uint32_t masterInstanceID;
+            uint64_t sequence; //!< The position in the queue
+            ICommand command; //!< invalid to stop the writer
+        };
+
+        /** Appends the queued records to the file. */
+        class Writer : public lunchbox::Thread
+        {
+        public:
+            Writer( InstanceCacheFile& file ) : _file( file ) {}
+        protected:
+            virtual bool init() { setName( "InstanceCacheFile" ); return true; }
+            virtual void run() { _file._runWriter(); }
+        private:
+            InstanceCacheFile& _file;
+        };
+
+        const std::string _filename;
+        const uint64_t _maxSize;
+
+        lunchbox::Lock _lock;
+        std::fstream _file;
+        uint64_t _end;           //!< The end of the valid records
+        uint64_t _size;          //!< The bytes used by indexed records
+        uint64_t _used;          //!< The clock of the entries' last use
+        EntryHash _records;      //!< Records by object
+        lunchbox::MemoryMap _map; //!< Read-only mapping of the file
+
+        Writer* _writer;
+        lunchbox::MTQueue< Record > _queue;
+        lunchbox::Lock _queueLock; //!< protects the members below
+        uint64_t _queued;          //!< The number of records queued
+        SequenceHash _lastQueued;  //!< The last queued record by object
+        lunchbox::Atomic< uint64_t > _queuedSize; //!< The bytes queued
+        lunchbox::Monitor< uint64_t > _written; //!< The number processed
+
+        void _runWriter();
+        void _write( const Record& record );
+        void _index();
+        void _reset();
+        void _evict( const uint64_t size );
+        bool _compact();
+        bool _remap( const uint64_t size );
+    };
+}
+
+#endif // CO_INSTANCECACHEFILE_H
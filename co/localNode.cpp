@@ -23,7 +23,9 @@
 
 #include "buffer.h"
 #include "bufferCache.h"
+#include "commandPool.h"
 #include "commandQueue.h"
+#include "commitBatch.h"
 #include "connectionDescription.h"
 #include "connectionSet.h"
 #include "customICommand.h"
@@ -31,13 +33,18 @@
 #include "exception.h"
 #include "global.h"
 #include "iCommand.h"
+#include "masterHistory.h"
+#include "memoryBudget.h"
 #include "nodeCommand.h"
+#include "numa.h"
 #include "oCommand.h"
 #include "object.h"
 #include "objectICommand.h"
+#include "objectOCommand.h"
 #include "objectStore.h"
 #include "pipeConnection.h"
-#include "worker.h"
+#include "relayConnection.h"
+#include "worker.ipp"
 #include "zeroconf.h"
 
 #include <lunchbox/clock.h>
@@ -52,12 +59,16 @@
 #include <lunchbox/types.h>
 #include <lunchbox/servus.h>
 
+#include <map>
+#include <string.h>
+
 namespace co
 {
 namespace
 {
 typedef CommandFunc< LocalNode > CmdFunc;
 typedef std::list< ICommand > CommandList;
+typedef stde::hash_map< uint128_t, CommandList > CommandListHash;
 typedef lunchbox::RefPtrHash< Connection, NodePtr > ConnectionNodeHash;
 typedef ConnectionNodeHash::const_iterator ConnectionNodeHashCIter;
 typedef ConnectionNodeHash::iterator ConnectionNodeHashIter;
@@ -68,6 +79,36 @@ typedef HandlerHash::const_iterator HandlerHashCIter;
 typedef std::pair< LocalNode::CommandHandler, CommandQueue* > CommandPair;
 typedef stde::hash_map< uint128_t, CommandPair > CommandHash;
 typedef CommandHash::const_iterator CommandHashCIter;
+
+/** The relay an object receives its commits from. */
+struct RelayParent
+{
+    RelayParent() : depth( 0 ) {}
+    RelayParent( const NodeID& id, const uint32_t d ) : nodeID( id ), depth(d){}
+
+    NodeID nodeID;
+    uint32_t depth; //!< the depth of the local node in the relay tree
+};
+typedef stde::hash_map< uint128_t, RelayParent > RelayParentHash;
+typedef RelayParentHash::const_iterator RelayParentHashCIter;
+
+/** The acks coalesced by a relay, by object, slave node and instance. */
+typedef std::pair< std::pair< uint128_t, uint128_t >, uint32_t > RelayAckKey;
+typedef std::map< RelayAckKey, RelayAck > RelayAckMap;
+typedef RelayAckMap::const_iterator RelayAckMapCIter;
+typedef std::map< NodeID, std::vector< RelayAck > > RelayAcksByNode;
+typedef RelayAcksByNode::const_iterator RelayAcksByNodeCIter;
+
+void _writeRelayAcks( OCommand& command, const std::vector< RelayAck >& acks )
+{
+    command << uint64_t( acks.size( ));
+    for( std::vector< RelayAck >::const_iterator i = acks.begin();
+         i != acks.end(); ++i )
+    {
+        command << i->objectID << i->masterID << i->masterInstanceID
+                << i->slaveID << i->instanceID << i->maxVersion << i->depth;
+    }
+}
 }
 
 namespace detail
@@ -79,6 +120,7 @@ public:
     virtual bool init()
         {
             setName( std::string("R ") + lunchbox::className(_localNode));
+            _localNode->_bindNUMANode();
             return _localNode->_startCommandThread();
         }
     virtual void run() { _localNode->_runReceiverThread(); }
@@ -87,7 +129,43 @@ private:
     co::LocalNode* const _localNode;
 };
 
-class CommandThread : public Worker
+/**
+ * The command thread queue, which hands object commands to the command pool
+ * while it is running. Node commands are always executed by the command
+ * thread.
+ */
+class CommandThreadQueue : public co::CommandQueue
+{
+public:
+    CommandThreadQueue() : pool( 0 ) {}
+
+    virtual void push( const ICommand& command )
+    {
+        if( _usePool( command ))
+            pool->push( command );
+        else
+            co::CommandQueue::push( command );
+    }
+
+    virtual void pushFront( const ICommand& command )
+    {
+        if( _usePool( command ))
+            pool->pushFront( command );
+        else
+            co::CommandQueue::pushFront( command );
+    }
+
+    CommandPool* pool;
+
+private:
+    bool _usePool( const ICommand& command ) const
+    {
+        return pool && pool->isRunning() &&
+               command.getType() == COMMANDTYPE_OBJECT;
+    }
+};
+
+class CommandThread : public WorkerThread< CommandThreadQueue >
 {
 public:
     CommandThread( co::LocalNode* localNode ) : _localNode( localNode ){}
@@ -96,6 +174,7 @@ protected:
     virtual bool init()
         {
             setName( std::string( "C " ) + lunchbox::className( _localNode ));
+            _localNode->_bindNUMANode();
             return true;
         }
 
@@ -109,6 +188,48 @@ private:
     co::LocalNode* const _localNode;
 };
 
+/**
+ * Executes blocking commands in order, away from the command thread, e.g., the
+ * asynchronous commits started by Object::commitNB() or the relay forwards.
+ */
+class SerialThread : public Worker
+{
+public:
+    SerialThread( co::LocalNode* localNode, const std::string& prefix )
+        : _localNode( localNode ), _prefix( prefix ), _stopped( false ) {}
+
+    /** Finish the commands queued so far and join the thread. */
+    void stop( const ICommand& command )
+        {
+            ICommand stopCommand( command );
+            stopCommand.setDispatchFunction(
+                CommandFunc< SerialThread >( this, &SerialThread::_cmdStop ));
+            getWorkerQueue()->push( stopCommand );
+            LBCHECK( join( ));
+        }
+
+protected:
+    virtual bool init()
+        {
+            setName( _prefix + lunchbox::className( _localNode ));
+            _stopped = false;
+            return true;
+        }
+
+    virtual bool stopRunning() { return _stopped; }
+
+private:
+    co::LocalNode* const _localNode;
+    const std::string _prefix;
+    bool _stopped;
+
+    bool _cmdStop( ICommand& )
+        {
+            _stopped = true;
+            return true;
+        }
+};
+
 class LocalNode
 {
 public:
@@ -117,9 +238,19 @@ public:
             , bigBuffers( 20 )
             , sendToken( true )
             , lastSendToken( 0 )
+            , nPendingCommands( 0 )
             , objectStore( 0 )
+            , budget( uint64_t( Global::getIAttribute(
+                          Global::IATTR_MEMORY_BUDGET )) * LB_1MB )
+            , underPressure( false )
+            , numaNode( -1 )
+            , history( uint64_t( Global::getIAttribute(
+                           Global::IATTR_OBJECT_HISTORY_SIZE )) * LB_1MB,
+                       budget )
             , receiverThread( 0 )
             , commandThread( 0 )
+            , commitThread( 0 )
+            , relayThread( 0 )
             , service( "_collage._tcp" )
         {
         }
@@ -129,6 +260,7 @@ public:
             LBASSERT( incoming.isEmpty( ));
             LBASSERT( connectionNodes.empty( ));
             LBASSERT( pendingCommands.empty( ));
+            LBASSERT( pendingOtherCommands.empty( ));
             LBASSERT( nodes->empty( ));
 
             delete objectStore;
@@ -137,6 +269,14 @@ public:
             delete commandThread;
             commandThread = 0;
 
+            LBASSERT( !commitThread->isRunning( ));
+            delete commitThread;
+            commitThread = 0;
+
+            LBASSERT( !relayThread->isRunning( ));
+            delete relayThread;
+            relayThread = 0;
+
             LBASSERT( !receiverThread->isRunning( ));
             delete receiverThread;
             receiverThread = 0;
@@ -144,8 +284,17 @@ public:
 
     bool inReceiverThread() const { return receiverThread->isCurrent(); }
 
-    /** Commands re-scheduled for dispatch. */
-    CommandList  pendingCommands;
+    /** Commands re-scheduled for dispatch, by object identifier. */
+    CommandListHash pendingCommands;
+
+    /** Undispatched non-object commands, retried on every redispatch. */
+    CommandList pendingOtherCommands;
+
+    /** The number of commands in pendingCommands and pendingOtherCommands. */
+    size_t nPendingCommands;
+
+    /** Objects attached since the last redispatch. */
+    std::vector< uint128_t > retryObjects;
 
     /** The command buffer 'allocator' for small packets */
     co::BufferCache smallBuffers;
@@ -160,6 +309,16 @@ public:
     /** Manager of distributed object */
     ObjectStore* objectStore;
 
+    /** Accounting of the memory used by received and retained data */
+    MemoryBudget budget;
+    bool underPressure; //!< budget exceeded at the last update, recv only
+
+    /** The NUMA node of the first listening network interface, or -1. */
+    int32_t numaNode;
+
+    /** Retention budget of the old versions of all master objects */
+    MasterHistory history;
+
     /** Needed for thread-safety during nodeID-based connect() */
     lunchbox::Lock connectLock;
 
@@ -183,6 +342,17 @@ public:
 
     ReceiverThread* receiverThread;
     CommandThread* commandThread;
+    SerialThread* commitThread; //!< executes asynchronous commits
+    SerialThread* relayThread; //!< connects & forwards to relay children
+
+    /** The relay of each object with relayed commits. w: recv only */
+    lunchbox::Lockable< RelayParentHash, lunchbox::SpinLock > relayParents;
+
+    /** The acks of the relay subtrees not yet forwarded, relay thread only */
+    RelayAckMap relayAcks;
+
+    /** The workers executing object commands, if enabled. */
+    CommandPool commandPool;
 
     lunchbox::Lockable< lunchbox::Servus > service;
 };
@@ -194,6 +364,9 @@ LocalNode::LocalNode( const uint32_t type )
 {
     _impl->receiverThread = new detail::ReceiverThread( this );
     _impl->commandThread  = new detail::CommandThread( this );
+    _impl->commandThread->getWorkerQueue()->pool = &_impl->commandPool;
+    _impl->commitThread = new detail::SerialThread( this, "M " );
+    _impl->relayThread = new detail::SerialThread( this, "F " );
     _impl->objectStore = new ObjectStore( this );
 
     CommandQueue* queue = getCommandThreadQueue();
@@ -238,13 +411,20 @@ LocalNode::LocalNode( const uint32_t type )
     registerCommand( CMD_NODE_REMOVE_LISTENER,
                      CmdFunc( this, &LocalNode::_cmdRemoveListener ), 0 );
     registerCommand( CMD_NODE_PING,
-                     CmdFunc( this, &LocalNode::_cmdPing ), queue );
+                     CmdFunc( this, &LocalNode::_cmdPing ), queue, true );
     registerCommand( CMD_NODE_PING_REPLY,
                      CmdFunc( this, &LocalNode::_cmdDiscard ), 0 );
     registerCommand( CMD_NODE_COMMAND,
                      CmdFunc( this, &LocalNode::_cmdCommand ), 0 );
     registerCommand( CMD_NODE_ADD_CONNECTION,
                      CmdFunc( this, &LocalNode::_cmdAddConnection ), 0 );
+    registerCommand( CMD_NODE_COMMIT_BATCH,
+                     CmdFunc( this, &LocalNode::_cmdCommitBatch ), 0 );
+    registerCommand( CMD_NODE_RELAY,
+                     CmdFunc( this, &LocalNode::_cmdRelay ), 0 );
+    registerCommand( CMD_NODE_RELAY_ACK,
+                     CmdFunc( this, &LocalNode::_cmdRelayAck ),
+                     _impl->relayThread->getWorkerQueue( ));
 }
 
 LocalNode::~LocalNode( )
@@ -338,6 +518,12 @@ bool LocalNode::listen()
             return false;
         }
 
+        if( _impl->numaNode < 0 &&
+            Global::getIAttribute( Global::IATTR_NUMA_AFFINITY ))
+        {
+            _impl->numaNode = numa::getNode( description->getHostname( ));
+        }
+
         _impl->connectionNodes[ connection ] = this;
         _impl->incoming.addConnection( connection );
         if( connection->isMulticast( ))
@@ -658,6 +844,43 @@ void LocalNode::expireInstanceData( const int64_t age )
     _impl->objectStore->expireInstanceData( age );
 }
 
+void LocalNode::addInstanceData( const ObjectVersion& rev,
+                                 const uint32_t masterInstanceID,
+                                 NodePtr master, const lunchbox::Bufferb& data,
+                                 const bool compact )
+{
+    _impl->objectStore->addInstanceData( rev, masterInstanceID, master, data,
+                                         compact );
+}
+
+bool LocalNode::sendRelayAck( const UUID& objectID, NodePtr master,
+                              const uint32_t masterInstanceID,
+                              const uint32_t instanceID,
+                              const uint64_t maxVersion )
+{
+    RelayParent parent;
+    {
+        lunchbox::ScopedFastRead mutex( _impl->relayParents );
+        RelayParentHashCIter i = _impl->relayParents->find( objectID );
+        if( i == _impl->relayParents->end( ))
+            return false;
+        parent = i->second;
+    }
+
+    NodePtr node = getNode( parent.nodeID );
+    ConnectionPtr connection = node ? node->getConnection() : 0;
+    if( !connection )
+        return false;
+
+    const RelayAck ack = { objectID, master->getNodeID(), masterInstanceID,
+                           getNodeID(), instanceID, maxVersion, parent.depth };
+    Connections connections( 1, connection );
+    CommitBatch::substitute( connections );
+    OCommand command( connections, CMD_NODE_RELAY_ACK );
+    _writeRelayAcks( command, std::vector< RelayAck >( 1, ack ));
+    return true;
+}
+
 void LocalNode::enableSendOnRegister()
 {
     _impl->objectStore->enableSendOnRegister();
@@ -702,6 +925,17 @@ bool LocalNode::mapObjectSync( const uint32_t requestID )
     return _impl->objectStore->mapObjectSync( requestID );
 }
 
+uint32_t LocalNode::mapObjectsNB( const Objects& objects,
+                                  const ObjectVersions& versions )
+{
+    return _impl->objectStore->mapObjectsNB( objects, versions );
+}
+
+bool LocalNode::mapObjectsSync( const uint32_t requestID )
+{
+    return _impl->objectStore->mapObjectsSync( requestID );
+}
+
 void LocalNode::unmapObject( Object* object )
 {
     _impl->objectStore->unmapObject( object );
@@ -1077,6 +1311,16 @@ CommandQueue* LocalNode::getCommandThreadQueue()
     return _impl->commandThread->getWorkerQueue();
 }
 
+MasterHistory& LocalNode::getMasterHistory()
+{
+    return _impl->history;
+}
+
+MemoryBudget& LocalNode::getMemoryBudget()
+{
+    return _impl->budget;
+}
+
 bool LocalNode::inCommandThread() const
 {
     return _impl->commandThread->isCurrent();
@@ -1157,11 +1401,16 @@ void LocalNode::_runReceiverThread()
             nErrors = 0;
     }
 
-    if( !_impl->pendingCommands.empty( ))
-        LBWARN << _impl->pendingCommands.size()
+    if( _impl->nPendingCommands > 0 )
+        LBWARN << _impl->nPendingCommands
                << " commands pending while leaving command thread" << std::endl;
 
     _impl->pendingCommands.clear();
+    _impl->pendingOtherCommands.clear();
+    _impl->nPendingCommands = 0;
+    _impl->budget.set( MemoryBudget::PENDING_COMMANDS, 0 );
+    _impl->retryObjects.clear();
+    _impl->relayParents->clear();
     LBCHECK( _impl->commandThread->join( ));
 
     ConnectionPtr connection = getConnection();
@@ -1184,6 +1433,11 @@ void LocalNode::_runReceiverThread()
 
     _impl->objectStore->clear();
     _impl->pendingCommands.clear();
+    _impl->pendingOtherCommands.clear();
+    _impl->nPendingCommands = 0;
+    _impl->budget.set( MemoryBudget::PENDING_COMMANDS, 0 );
+    _impl->retryObjects.clear();
+    _impl->relayParents->clear();
     _impl->smallBuffers.flush();
     _impl->bigBuffers.flush();
 
@@ -1235,6 +1489,7 @@ bool LocalNode::_handleData()
 {
     _impl->smallBuffers.compact();
     _impl->bigBuffers.compact();
+    _updateMemoryBudget();
 
     ConnectionPtr connection = _impl->incoming.getConnection();
     LBASSERT( connection );
@@ -1349,7 +1604,8 @@ bool LocalNode::_readTail( ICommand& command, BufferPtr buffer,
     if( needed > buffer->getMaxSize( ))
     {
         LBASSERT( needed > COMMAND_ALLOCSIZE );
-        // not enough space for remaining data, alloc and copy to new buffer
+        // not enough space for remaining data, alloc and copy to new buffer,
+        // the copy is limited to the first receive of COMMAND_MINSIZE bytes
         BufferPtr newBuffer = _impl->bigBuffers.alloc( needed );
         newBuffer->replace( *buffer );
         buffer = newBuffer;
@@ -1363,6 +1619,38 @@ bool LocalNode::_readTail( ICommand& command, BufferPtr buffer,
     return connection->recvSync( buffer );
 }
 
+void LocalNode::_updateMemoryBudget()
+{
+    MemoryBudget& budget = _impl->budget;
+    if( budget.getMaxSize() == 0 )
+        return;
+
+    budget.set( MemoryBudget::BUFFERS, _impl->smallBuffers.getFreeSize() +
+                                       _impl->bigBuffers.getFreeSize( ));
+    budget.set( MemoryBudget::INSTANCE_CACHE,
+                _impl->objectStore->getInstanceDataSize( ));
+
+    // sample the size once, the consumers change it concurrently
+    const uint64_t size = budget.getSize();
+    const uint64_t maxSize = budget.getMaxSize();
+    if( size <= maxSize )
+    {
+        if( _impl->underPressure )
+            LBINFO << "Memory pressure relieved, " << budget << std::endl;
+        _impl->underPressure = false;
+        return;
+    }
+
+    if( !_impl->underPressure )
+        LBWARN << "Memory budget exceeded, " << budget << std::endl;
+    _impl->underPressure = true;
+
+    // Release what can be rebuilt: cached instance data and free buffers.
+    // Masters and slaves react to the pressure themselves.
+    _impl->objectStore->shrinkInstanceData( size - maxSize );
+    _impl->bigBuffers.trim();
+}
+
 BufferPtr LocalNode::allocBuffer( const uint64_t size )
 {
     LBASSERT( _impl->receiverThread->isStopped() || _impl->inReceiverThread( ));
@@ -1377,12 +1665,23 @@ void LocalNode::_dispatchCommand( ICommand& command )
     LBASSERTINFO( command.isValid(), command );
 
     if( dispatchCommand( command ))
-        _redispatchCommands();
-    else
     {
         _redispatchCommands();
-        _impl->pendingCommands.push_back( command );
+        return;
+    }
+
+    // object commands are pending until their object is attached, custom
+    // command types of subclasses until any later dispatch succeeds
+    if( command.getType() == COMMANDTYPE_OBJECT )
+    {
+        const ObjectICommand objectCommand( command );
+        _impl->pendingCommands[ objectCommand.getObjectID() ].push_back(
+            command );
     }
+    else
+        _impl->pendingOtherCommands.push_back( command );
+    ++_impl->nPendingCommands;
+    _impl->budget.add( MemoryBudget::PENDING_COMMANDS, command.getSize( ));
 }
 
 bool LocalNode::dispatchCommand( ICommand& command )
@@ -1408,34 +1707,66 @@ bool LocalNode::dispatchCommand( ICommand& command )
 
 void LocalNode::_redispatchCommands()
 {
-    bool changes = true;
-    while( changes && !_impl->pendingCommands.empty( ))
+    CommandList& others = _impl->pendingOtherCommands;
+    for( CommandList::iterator i = others.begin(); i != others.end(); )
+    {
+        if( dispatchCommand( *i ))
+        {
+            _impl->budget.remove( MemoryBudget::PENDING_COMMANDS,
+                                  i->getSize( ));
+            i = others.erase( i );
+            --_impl->nPendingCommands;
+        }
+        else
+            ++i;
+    }
+
+    while( !_impl->retryObjects.empty( ))
     {
-        changes = false;
+        const uint128_t id = _impl->retryObjects.back();
+        _impl->retryObjects.pop_back();
 
-        for( CommandList::iterator i = _impl->pendingCommands.begin();
-             i != _impl->pendingCommands.end(); ++i )
+        CommandListHash::iterator i = _impl->pendingCommands.find( id );
+        if( i == _impl->pendingCommands.end( ))
+            continue;
+
+        // dispatch may attach objects, which modifies the pending commands
+        CommandList commands;
+        commands.swap( i->second );
+        _impl->pendingCommands.erase( i );
+
+        while( !commands.empty() && dispatchCommand( commands.front( )))
         {
-            ICommand& command = *i;
-            LBASSERT( command.isValid( ));
+            _impl->budget.remove( MemoryBudget::PENDING_COMMANDS,
+                                  commands.front().getSize( ));
+            commands.pop_front();
+            --_impl->nPendingCommands;
+        }
 
-            if( dispatchCommand( command ))
-            {
-                _impl->pendingCommands.erase( i );
-                changes = true;
-                break;
-            }
+        if( !commands.empty( ))
+        {
+            CommandList& pending = _impl->pendingCommands[ id ];
+            pending.splice( pending.begin(), commands );
         }
     }
 
 #ifndef NDEBUG
-    if( !_impl->pendingCommands.empty( ))
-        LBVERB << _impl->pendingCommands.size() << " undispatched commands"
+    if( _impl->nPendingCommands > 0 )
+        LBVERB << _impl->nPendingCommands << " undispatched commands"
                << std::endl;
-    LBASSERT( _impl->pendingCommands.size() < 200 );
 #endif
 }
 
+void LocalNode::_retryPendingCommands( const UUID& objectID )
+{
+    LBASSERT( _impl->inReceiverThread( ));
+    if( _impl->pendingCommands.find( objectID ) !=
+        _impl->pendingCommands.end( ))
+    {
+        _impl->retryObjects.push_back( objectID );
+    }
+}
+
 void LocalNode::_initService()
 {
     LB_TS_SCOPED( _rcvThread );
@@ -1482,7 +1813,44 @@ Zeroconf LocalNode::getZeroconf()
 //----------------------------------------------------------------------
 bool LocalNode::_startCommandThread()
 {
-    return _impl->commandThread->start();
+    const int32_t nThreads =
+        Global::getIAttribute( Global::IATTR_COMMAND_POOL_THREADS );
+    if( nThreads > 0 &&
+        !_impl->commandPool.start( nThreads, lunchbox::className( this )))
+    {
+        return false;
+    }
+    if( !_impl->commitThread->start( ))
+    {
+        _impl->commandPool.stop( ICommand( ));
+        return false;
+    }
+    if( !_impl->relayThread->start( ))
+    {
+        _impl->commitThread->stop( ICommand( ));
+        _impl->commandPool.stop( ICommand( ));
+        return false;
+    }
+    if( _impl->commandThread->start( ))
+        return true;
+
+    _impl->relayThread->stop( ICommand( ));
+    _impl->commitThread->stop( ICommand( ));
+    _impl->commandPool.stop( ICommand( ));
+    return false;
+}
+
+CommandQueue* LocalNode::_getCommitThreadQueue()
+{
+    return _impl->commitThread->getWorkerQueue();
+}
+
+void LocalNode::_bindNUMANode()
+{
+    // receive buffers are allocated and filled by the receiver thread, and
+    // thereby placed on the NUMA node of the network interface
+    if( numa::bindThread( _impl->numaNode ))
+        LBVERB << "Bound thread to NUMA node " << _impl->numaNode << std::endl;
 }
 
 bool LocalNode::_notifyCommandThreadIdle()
@@ -1517,6 +1885,11 @@ bool LocalNode::_cmdStopCmd( ICommand& command )
     LB_TS_THREAD( _cmdThread );
     LBASSERTINFO( isClosing(), *this );
 
+    // let the pool finish the object commands queued so far
+    _impl->commandPool.stop( command );
+    _impl->commitThread->stop( command );
+    _impl->relayThread->stop( command );
+    _impl->relayAcks.clear();
     _setClosed();
     return true;
 }
@@ -2013,4 +2386,259 @@ bool LocalNode::_cmdAddConnection( ICommand& command )
     return true;
 }
 
+void LocalNode::_dispatchEmbeddedCommands( NodePtr node, const bool swap,
+                                           const uint8_t* data, uint64_t size,
+                                           NodePtr relay, const uint32_t depth )
+{
+    // dispatch embedded commands in the order they were committed
+    while( size > 0 )
+    {
+        uint64_t commandSize = 0;
+        LBASSERT( size >= sizeof( commandSize ));
+        ::memcpy( &commandSize, data, sizeof( commandSize ));
+        if( swap )
+            lunchbox::byteswap( commandSize );
+
+        LBASSERTINFO( commandSize <= size, commandSize << " > " << size );
+        if( commandSize < sizeof( commandSize ) || commandSize > size )
+        {
+            LBERROR << "Malformed embedded commands from " << node
+                    << std::endl;
+            return;
+        }
+
+        BufferPtr buffer = allocBuffer( commandSize );
+        buffer->replace( data, commandSize );
+
+        ICommand embedded( this, node, buffer, swap );
+        if( relay && embedded.getType() == COMMANDTYPE_OBJECT )
+            _dispatchRelayedCommand( embedded, relay, depth );
+        else
+            _dispatchCommand( embedded );
+
+        data += commandSize;
+        size -= commandSize;
+    }
+}
+
+void LocalNode::_dispatchRelayedCommand( ICommand& command, NodePtr relay,
+                                         const uint32_t depth )
+{
+    const UUID id = ObjectICommand( command ).getObjectID();
+    {
+        // the slaves ack to the relay, or directly to the origin
+        lunchbox::ScopedFastWrite mutex( _impl->relayParents );
+        if( relay == command.getNode( ))
+            _impl->relayParents->erase( id );
+        else
+            (*_impl->relayParents)[ id ] = RelayParent( relay->getNodeID(),
+                                                        depth );
+    }
+
+    if( dispatchCommand( command ))
+    {
+        _redispatchCommands();
+        return;
+    }
+
+    // Commits are relayed only to nodes with mapped slaves. The slave was
+    // unmapped meanwhile, and nothing would ever consume the pending command.
+    LBLOG( LOG_OBJECTS ) << "Drop relayed " << command << std::endl;
+    lunchbox::ScopedFastWrite mutex( _impl->relayParents );
+    _impl->relayParents->erase( id );
+}
+
+bool LocalNode::_cmdCommitBatch( ICommand& command )
+{
+    LBASSERT( _impl->inReceiverThread( ));
+
+    const uint64_t size = command.get< uint64_t >();
+    const uint8_t* data = reinterpret_cast< const uint8_t* >(
+        command.getRemainingBuffer( size ));
+
+    _dispatchEmbeddedCommands( command.getNode(), command.isSwapping(), data,
+                               size );
+    return true;
 }
+
+bool LocalNode::_cmdRelay( ICommand& command )
+{
+    LBASSERT( _impl->inReceiverThread( ));
+
+    command.get< uint32_t >(); // fanOut
+    const NodeID originID = command.get< NodeID >();
+    const bool bigEndian = command.get< bool >();
+    const uint32_t depth = command.get< uint32_t >();
+    const NodeIDs subtree = command.get< NodeIDs >();
+    const uint64_t size = command.get< uint64_t >();
+    const uint8_t* data = reinterpret_cast< const uint8_t* >(
+        command.getRemainingBuffer( size ));
+
+    // A group returned by a relay which couldn't reach it carries our own
+    // commands, which are only forwarded
+    if( originID != getNodeID( ))
+    {
+        // embedded commands are from the origin, not from the relaying node
+        NodePtr origin = getNode( originID );
+        if( !origin )
+            origin = command.getNode();
+
+        _dispatchEmbeddedCommands( origin,
+                                   bigEndian != RelayConnection::isBigEndian(),
+                                   data, size, command.getNode(), depth );
+    }
+    if( subtree.empty( ))
+        return true;
+
+    // Forward from the relay thread, which may connect to the children. Not
+    // from the command thread, since connecting by identifier waits for the
+    // command thread of a peer, which might be relaying to us at the same time
+    command.setDispatchFunction( CmdFunc( this, &LocalNode::_cmdRelayForward ));
+    _impl->relayThread->getWorkerQueue()->push( command );
+    return true;
+}
+
+bool LocalNode::_cmdRelayForward( ICommand& command )
+{
+    const uint32_t fanOut = command.get< uint32_t >();
+    const NodeID originID = command.get< NodeID >();
+    const bool bigEndian = command.get< bool >();
+    const uint32_t depth = command.get< uint32_t >();
+    const NodeIDs subtree = command.get< NodeIDs >();
+    const uint64_t size = command.get< uint64_t >();
+    const void* data = command.getRemainingBuffer( size );
+
+    const size_t nGroups = LB_MIN( subtree.size(), size_t( fanOut ));
+    for( size_t g = 0; g < nGroups; ++g )
+    {
+        size_t begin = 0;
+        size_t end = 0;
+        RelayConnection::getGroup( subtree.size(), nGroups, g, begin, end );
+        const NodeIDs group( subtree.begin() + begin, subtree.begin() + end );
+
+        // the first reachable node of the group relays to the others
+        for( ; begin < end; ++begin )
+        {
+            NodePtr node = connect( subtree[ begin ] );
+            ConnectionPtr connection = node ? node->getConnection() : 0;
+            if( connection )
+            {
+                const NodeIDs children( subtree.begin() + begin + 1,
+                                        subtree.begin() + end );
+                RelayConnection::send( connection, fanOut, originID, bigEndian,
+                                       depth + 1, children, data, size );
+                break;
+            }
+            LBWARN << "Can't relay commit data to " << subtree[ begin ]
+                   << std::endl;
+        }
+        if( begin < end || originID == getNodeID( ))
+            continue;
+
+        // let the origin send to the group directly
+        NodePtr origin = connect( originID );
+        ConnectionPtr connection = origin ? origin->getConnection() : 0;
+        if( connection )
+            RelayConnection::send( connection, fanOut, originID, bigEndian, 0,
+                                   group, data, size );
+        else
+            LBWARN << "Can't return relay group to " << originID << std::endl;
+    }
+
+    _flushRelayAcks();
+    return true;
+}
+
+bool LocalNode::_cmdRelayAck( ICommand& command )
+{
+    const uint64_t nAcks = command.get< uint64_t >();
+    for( uint64_t i = 0; i < nAcks; ++i )
+    {
+        RelayAck ack;
+        command >> ack.objectID >> ack.masterID >> ack.masterInstanceID
+                >> ack.slaveID >> ack.instanceID >> ack.maxVersion
+                >> ack.depth;
+
+        // the newest ack of a slave instance supersedes the older ones
+        const RelayAckKey key( std::make_pair( ack.objectID, ack.slaveID ),
+                               ack.instanceID );
+        _impl->relayAcks[ key ] = ack;
+    }
+
+    _flushRelayAcks();
+    return true;
+}
+
+void LocalNode::_flushRelayAcks()
+{
+    // coalesce the acks arriving while busy, forward them once idle
+    if( _impl->relayAcks.empty() ||
+        !_impl->relayThread->getWorkerQueue()->isEmpty( ))
+    {
+        return;
+    }
+
+    RelayAcksByNode relayed;
+    std::vector< RelayAck > direct;
+    for( RelayAckMapCIter i = _impl->relayAcks.begin();
+         i != _impl->relayAcks.end(); ++i )
+    {
+        RelayAck ack = i->second;
+        RelayParent parent;
+        {
+            lunchbox::ScopedFastRead mutex( _impl->relayParents );
+            RelayParentHashCIter j = _impl->relayParents->find( ack.objectID );
+            if( j != _impl->relayParents->end( ))
+                parent = j->second;
+        }
+
+        // Up the tree only: a stale relay of a reshaped tree could cycle
+        if( parent.depth > 0 && parent.depth < ack.depth )
+        {
+            ack.depth = parent.depth;
+            relayed[ parent.nodeID ].push_back( ack );
+        }
+        else
+            direct.push_back( ack );
+    }
+    _impl->relayAcks.clear();
+
+    co::CommitBatch batch;
+    for( RelayAcksByNodeCIter i = relayed.begin(); i != relayed.end(); ++i )
+    {
+        NodePtr node = getNode( i->first );
+        ConnectionPtr connection = node ? node->getConnection() : 0;
+        if( !connection )
+        {
+            direct.insert( direct.end(), i->second.begin(), i->second.end( ));
+            continue;
+        }
+
+        Connections connections( 1, connection );
+        co::CommitBatch::substitute( connections );
+        OCommand command( connections, CMD_NODE_RELAY_ACK );
+        _writeRelayAcks( command, i->second );
+    }
+
+    for( std::vector< RelayAck >::const_iterator i = direct.begin();
+         i != direct.end(); ++i )
+    {
+        NodePtr master = getNode( i->masterID );
+        ConnectionPtr connection = master ? master->getConnection() : 0;
+        if( !connection )
+        {
+            LBWARN << "Can't forward ack to " << i->masterID << std::endl;
+            continue;
+        }
+
+        Connections connections( 1, connection );
+        co::CommitBatch::substitute( connections );
+        ObjectOCommand( connections, CMD_OBJECT_RELAY_MAX_VERSION,
+                        COMMANDTYPE_OBJECT, i->objectID, i->masterInstanceID )
+            << i->maxVersion << i->instanceID << i->slaveID;
+    }
+}
+
+}
+
+template class co::WorkerThread< co::detail::CommandThreadQueue >;
@@ -240,6 +240,37 @@ namespace detail { class LocalNode; class ReceiverThread; class CommandThread; }
         /** Finalize the mapping of a distributed object. @version 1.0 */
         CO_API virtual bool mapObjectSync( const uint32_t requestID );
 
+        /**
+         * Start mapping many distributed objects.
+         *
+         * Maps each object to the identifier and version at the same position
+         * in versions. The master nodes of all objects are resolved with one
+         * query to each connected node, and all map requests for the same
+         * master node are sent as a single command. This is considerably
+         * faster than calling mapObjectNB() for each object when mapping
+         * thousands of objects.
+         *
+         * The calling thread must not have an active CommitBatch.
+         *
+         * @param objects the objects to map.
+         * @param versions the master object identifier and initial version
+         *                 for each object.
+         * @return the request identifier for mapObjectsSync().
+         * @sa mapObject()
+         * @version 1.0
+         */
+        CO_API uint32_t mapObjectsNB( const Objects& objects,
+                                      const ObjectVersions& versions );
+
+        /**
+         * Finalize the mapping of many distributed objects.
+         *
+         * @return true if all objects were mapped, false otherwise. Use
+         *         Object::isAttached() to find the objects which were mapped.
+         * @version 1.0
+         */
+        CO_API bool mapObjectsSync( const uint32_t requestID );
+
         /**
          * Unmap a mapped object.
          *
@@ -372,6 +403,29 @@ namespace detail { class LocalNode; class ReceiverThread; class CommandThread; }
 
         /** @internal */
         CO_API int64_t getTime64() const;
+
+        /** @internal @return the old versions retained by all masters. */
+        MasterHistory& getMasterHistory();
+
+        /** @internal Cache a version a slave rebuilt from a binary delta. */
+        void addInstanceData( const ObjectVersion& rev,
+                              const uint32_t masterInstanceID, NodePtr master,
+                              const lunchbox::Bufferb& data,
+                              const bool compact );
+
+        /**
+         * @internal Send the max version ack of a slave to the relay its
+         * object receives the commits from.
+         *
+         * @return false if the commits are not relayed to this node.
+         */
+        bool sendRelayAck( const UUID& objectID, NodePtr master,
+                           const uint32_t masterInstanceID,
+                           const uint32_t instanceID,
+                           const uint64_t maxVersion );
+
+        /** @internal @return the memory accountant of this node. */
+        CO_API MemoryBudget& getMemoryBudget();
         //@}
 
         /** @name Operations */
@@ -391,8 +445,9 @@ namespace detail { class LocalNode; class ReceiverThread; class CommandThread; }
         /** @internal
          * Flush all pending commands on this listening node.
          *
-         * This causes the receiver thread to redispatch all pending commands,
-         * which are normally only redispatched when a new command is received.
+         * This causes the receiver thread to redispatch the pending commands
+         * of all objects attached since the last redispatch, which are
+         * normally only redispatched when a new command is received.
          */
         CO_API void flushCommands();
 
@@ -483,6 +538,8 @@ namespace detail { class LocalNode; class ReceiverThread; class CommandThread; }
         bool _connectSelf();
 
         bool _startCommandThread();
+        CommandQueue* _getCommitThreadQueue();
+        void _bindNUMANode();
         bool _notifyCommandThreadIdle();
         friend class detail::ReceiverThread;
         friend class detail::CommandThread;
@@ -505,6 +562,7 @@ namespace detail { class LocalNode; class ReceiverThread; class CommandThread; }
         BufferPtr _readHead( ConnectionPtr connection );
         ICommand   _setupCommand( ConnectionPtr, ConstBufferPtr );
         bool      _readTail( ICommand&, BufferPtr, ConnectionPtr );
+        void      _updateMemoryBudget();
         void   _initService();
         void   _exitService();
 
@@ -519,6 +577,16 @@ namespace detail { class LocalNode; class ReceiverThread; class CommandThread; }
         void _dispatchCommand( ICommand& command );
         void   _redispatchCommands();
 
+        /** Retry the pending commands of a newly attached object. */
+        void _retryPendingCommands( const UUID& objectID );
+        void _dispatchEmbeddedCommands( NodePtr node, const bool swap,
+                                        const uint8_t* data, uint64_t size,
+                                        NodePtr relay = 0,
+                                        const uint32_t depth = 0 );
+        void _dispatchRelayedCommand( ICommand& command, NodePtr relay,
+                                      const uint32_t depth );
+        void _flushRelayAcks();
+
         /** The command functions. */
         bool _cmdAckRequest( ICommand& command );
         bool _cmdStopRcv( ICommand& command );
@@ -540,6 +608,10 @@ namespace detail { class LocalNode; class ReceiverThread; class CommandThread; }
         bool _cmdCommand( ICommand& command );
         bool _cmdCommandAsync( ICommand& command );
         bool _cmdAddConnection( ICommand& command );
+        bool _cmdCommitBatch( ICommand& command );
+        bool _cmdRelay( ICommand& command );
+        bool _cmdRelayForward( ICommand& command );
+        bool _cmdRelayAck( ICommand& command );
         bool _cmdDiscard( ICommand& ) { return true; }
         //@}
 
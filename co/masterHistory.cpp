@@ -0,0 +1,159 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "masterHistory.h"
+
+#include "log.h"
+
+#include <lunchbox/scopedMutex.h>
+#include <lunchbox/uuid.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+namespace co
+{
+namespace
+{
+std::string _getFilename()
+{
+#ifdef _WIN32
+    const char* dir = getenv( "TEMP" );
+#else
+    const char* dir = getenv( "TMPDIR" );
+#endif
+    std::ostringstream filename;
+    filename << ( dir ? dir : "/tmp" ) << "/co." << lunchbox::UUID( true )
+             << ".history";
+    return filename.str();
+}
+}
+
+MasterHistory::MasterHistory( const uint64_t maxSize, MemoryBudget& budget )
+    : _maxSize( maxSize )
+    , _size( 0 )
+    , _budget( budget )
+    , _end( 0 )
+    , _spilled( 0 )
+{}
+
+MasterHistory::~MasterHistory()
+{
+    LBASSERTINFO( _size == 0, _size );
+    LBASSERTINFO( _spilled == 0, _spilled );
+
+    _map.unmap();
+    if( _file.is_open( ))
+        _file.close();
+    if( !_filename.empty( ))
+        ::remove( _filename.c_str( ));
+}
+
+void MasterHistory::remove( const uint64_t size )
+{
+    LBASSERTINFO( _size >= size, _size << " < " << size );
+    _size -= size;
+    _budget.remove( MemoryBudget::MASTER_HISTORY, size );
+}
+
+bool MasterHistory::_open()
+{
+    if( _file.is_open( ))
+        return true;
+
+    const bool create = _filename.empty();
+    if( create )
+        _filename = _getFilename();
+
+    _file.open( _filename.c_str(), std::ios::in | std::ios::out |
+                                   std::ios::binary | std::ios::trunc );
+    if( !_file.is_open( ))
+    {
+        LBWARN << "Can't open master history file " << _filename << std::endl;
+        return false;
+    }
+
+    if( create )
+        LBINFO << "Spilling old object versions to " << _filename
+               << std::endl;
+    _end = 0;
+    return true;
+}
+
+bool MasterHistory::_remap( const uint64_t size )
+{
+    if( _map.getAddress() && _map.getSize() >= size )
+        return true;
+
+    _file.flush();
+    _map.unmap();
+    return _map.map( _filename ) && _map.getSize() >= size;
+}
+
+bool MasterHistory::spill( const lunchbox::Bufferb& data, uint64_t& offset )
+{
+    lunchbox::ScopedMutex<> mutex( _lock );
+    if( !_open( ))
+        return false;
+
+    _file.write( reinterpret_cast< const char* >( data.getData( )),
+                 data.getSize( ));
+    if( !_file.good( ))
+    {
+        LBWARN << "Write to master history file " << _filename << " failed"
+               << std::endl;
+        _map.unmap();
+        _file.close();
+        return false;
+    }
+
+    offset = _end;
+    _end += data.getSize();
+    _spilled += data.getSize();
+    return true;
+}
+
+bool MasterHistory::load( const uint64_t offset, const uint64_t size,
+                          lunchbox::Bufferb& data )
+{
+    lunchbox::ScopedMutex<> mutex( _lock );
+    if( !_file.is_open() || offset + size > _end || !_remap( _end ))
+        return false;
+
+    const uint8_t* ptr = static_cast< const uint8_t* >( _map.getAddress( ));
+    data.replace( ptr + offset, size );
+    return true;
+}
+
+void MasterHistory::release( const uint64_t size )
+{
+    lunchbox::ScopedMutex<> mutex( _lock );
+    LBASSERTINFO( _spilled >= size, _spilled << " < " << size );
+    _spilled -= size;
+    if( _spilled > 0 || !_file.is_open( ))
+        return;
+
+    // nothing referenced anymore, start over to reclaim the disk space
+    _map.unmap();
+    _file.close();
+    _open();
+}
+
+}
@@ -0,0 +1,114 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_MASTERHISTORY_H
+#define CO_MASTERHISTORY_H
+
+#include "memoryBudget.h" // used inline
+
+#include <lunchbox/atomic.h>     // member
+#include <lunchbox/buffer.h>     // used inline
+#include <lunchbox/lock.h>       // member
+#include <lunchbox/memoryMap.h>  // member
+#include <lunchbox/nonCopyable.h> // base class
+
+#include <fstream>
+
+namespace co
+{
+    /**
+     * @internal The retention budget for the old versions of all master
+     * change managers of a local node.
+     *
+     * Masters account the memory used by their retained versions. Once the
+     * budget is exceeded, they spill their old versions to a temporary file,
+     * from which they are read back through a memory mapping when a late
+     * slave maps them. The file is created on first use, truncated whenever
+     * no spilled data is referenced anymore, and removed on destruction.
+     * The memory used is also accounted in the node's MemoryBudget, and old
+     * versions are spilled while the node is under memory pressure.
+     */
+    class MasterHistory : public lunchbox::NonCopyable
+    {
+    public:
+        /** Construct a new history with the given budget, 0 for unlimited. */
+        MasterHistory( const uint64_t maxSize, MemoryBudget& budget );
+
+        ~MasterHistory();
+
+        /** Account size bytes of retained data in memory. */
+        void add( const uint64_t size )
+        {
+            _size += size;
+            _budget.add( MemoryBudget::MASTER_HISTORY, size );
+        }
+
+        /** Release size bytes of retained data in memory. */
+        void remove( const uint64_t size );
+
+        /** @return true if the memory used exceeds a budget. */
+        bool isFull() const
+        {
+            return ( _maxSize > 0 && _size > _maxSize ) ||
+                   ( _size > 0 && _budget.isUnderPressure( ));
+        }
+
+        /** @return the memory used by retained data. */
+        uint64_t getSize() const { return _size; }
+
+        /** @return the budget for retained data, 0 if unlimited. */
+        uint64_t getMaxSize() const { return _maxSize; }
+
+        /** @return the number of bytes stored in the spill file. */
+        uint64_t getSpilledSize() const { return _spilled; }
+
+        /**
+         * Append data to the spill file.
+         *
+         * @param data the data to store.
+         * @param offset output: the position of the data in the file.
+         * @return true on success, false on error.
+         */
+        bool spill( const lunchbox::Bufferb& data, uint64_t& offset );
+
+        /** Read size bytes at offset from the spill file into data. */
+        bool load( const uint64_t offset, const uint64_t size,
+                   lunchbox::Bufferb& data );
+
+        /** Release size bytes of the spill file which are no longer used. */
+        void release( const uint64_t size );
+
+    private:
+        const uint64_t _maxSize;
+        lunchbox::Atomic< uint64_t > _size;
+        MemoryBudget& _budget;
+
+        lunchbox::Lock _lock;
+        std::string _filename;
+        std::fstream _file;
+        uint64_t _end;           //!< The end of the written data
+        lunchbox::Atomic< uint64_t > _spilled; //!< The referenced bytes
+        lunchbox::MemoryMap _map; //!< Read-only mapping of the file
+
+        bool _open();
+        bool _remap( const uint64_t size );
+    };
+}
+
+#endif // CO_MASTERHISTORY_H
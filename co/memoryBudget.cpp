@@ -0,0 +1,83 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "memoryBudget.h"
+
+#include "log.h"
+
+namespace co
+{
+namespace
+{
+const char* const _names[ MemoryBudget::NUM_CONSUMERS ] =
+{
+    "buffers",
+    "instance cache",
+    "master history",
+    "pending commands",
+    "slave queues",
+    "slave data"
+};
+}
+
+MemoryBudget::MemoryBudget( const uint64_t maxSize )
+    : _maxSize( maxSize )
+{
+    for( size_t i = 0; i < NUM_CONSUMERS; ++i )
+        _sizes[ i ] = 0;
+}
+
+MemoryBudget::~MemoryBudget()
+{
+    LBASSERTINFO( _sizes[ MASTER_HISTORY ] == 0, *this );
+    LBASSERTINFO( _sizes[ PENDING_COMMANDS ] == 0, *this );
+    LBASSERTINFO( _sizes[ SLAVE_QUEUES ] == 0, *this );
+    LBASSERTINFO( _sizes[ SLAVE_DATA ] == 0, *this );
+}
+
+void MemoryBudget::remove( const Consumer consumer, const uint64_t size )
+{
+    LBASSERTINFO( _sizes[ consumer ] >= size,
+                  _names[ consumer ] << ": " << _sizes[ consumer ] << " < "
+                  << size );
+    _sizes[ consumer ] -= size;
+}
+
+uint64_t MemoryBudget::getSize() const
+{
+    uint64_t size = 0;
+    for( size_t i = 0; i < NUM_CONSUMERS; ++i )
+        size += _sizes[ i ];
+    return size;
+}
+
+std::ostream& operator << ( std::ostream& os, const MemoryBudget& budget )
+{
+    os << "Memory " << budget.getSize() / LB_1MB << "/"
+       << budget.getMaxSize() / LB_1MB << " MB:";
+    for( size_t i = 0; i < MemoryBudget::NUM_CONSUMERS; ++i )
+    {
+        const MemoryBudget::Consumer consumer = MemoryBudget::Consumer( i );
+        os << " " << _names[ i ] << " " << budget.getSize( consumer ) / LB_1MB
+           << " MB";
+    }
+    return os;
+}
+
+}
@@ -0,0 +1,101 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_MEMORYBUDGET_H
+#define CO_MEMORYBUDGET_H
+
+#include <co/api.h>
+#include <co/types.h>
+
+#include <lunchbox/atomic.h>     // member
+#include <lunchbox/nonCopyable.h> // base class
+
+#include <iostream>
+
+namespace co
+{
+    /**
+     * The memory accountant of a local node.
+     *
+     * The subsystems holding received or retained data register their usage,
+     * either as it changes or sampled periodically by the receiver thread.
+     * Once the total exceeds the budget, the node is under pressure: the
+     * receiver thread evicts cached instance data and free buffers, masters
+     * spill their old versions, slaves limit how far their master may commit
+     * ahead, and instance data is no longer pushed speculatively on
+     * registration. Received instance data is still added to the cache,
+     * which evicts as needed.
+     *
+     * Data shared between subsystems, e.g., a version both queued by a slave
+     * and cached, is accounted by each of them.
+     */
+    class MemoryBudget : public lunchbox::NonCopyable
+    {
+    public:
+        /** The accounted subsystems. */
+        enum Consumer
+        {
+            BUFFERS,          //!< Free command buffers of the buffer caches
+            INSTANCE_CACHE,   //!< Cached instance data
+            MASTER_HISTORY,   //!< Old versions retained in memory by masters
+            PENDING_COMMANDS, //!< Commands waiting for their object
+            SLAVE_QUEUES,     //!< Versions received but not synced by slaves
+            SLAVE_DATA,       //!< Instance data retained by slaves for deltas
+            NUM_CONSUMERS
+        };
+
+        /** Construct a new budget with the given size, 0 for unlimited. */
+        explicit MemoryBudget( const uint64_t maxSize );
+
+        ~MemoryBudget();
+
+        /** Account size more bytes used by the given consumer. */
+        void add( const Consumer consumer, const uint64_t size )
+            { _sizes[ consumer ] += size; }
+
+        /** Release size bytes used by the given consumer. */
+        CO_API void remove( const Consumer consumer, const uint64_t size );
+
+        /** Set the usage of a periodically sampled consumer. */
+        void set( const Consumer consumer, const uint64_t size )
+            { _sizes[ consumer ] = size; }
+
+        /** @return the bytes used by the given consumer. */
+        uint64_t getSize( const Consumer consumer ) const
+            { return _sizes[ consumer ]; }
+
+        /** @return the bytes used by all consumers. */
+        CO_API uint64_t getSize() const;
+
+        /** @return the budget, 0 if unlimited. */
+        uint64_t getMaxSize() const { return _maxSize; }
+
+        /** @return true if the memory used exceeds the budget. */
+        bool isUnderPressure() const
+            { return _maxSize > 0 && getSize() > _maxSize; }
+
+    private:
+        const uint64_t _maxSize;
+        lunchbox::Atomic< uint64_t > _sizes[ NUM_CONSUMERS ];
+    };
+
+    CO_API std::ostream& operator << ( std::ostream&, const MemoryBudget& );
+}
+
+#endif // CO_MEMORYBUDGET_H
@@ -68,7 +68,13 @@ namespace co
         CMD_NODE_COMMAND,
         CMD_NODE_PING,
         CMD_NODE_PING_REPLY,
-        CMD_NODE_ADD_CONNECTION
+        CMD_NODE_ADD_CONNECTION,
+        CMD_NODE_COMMIT_BATCH,
+        CMD_NODE_COMMIT_OBJECT,
+        CMD_NODE_RELAY,
+        CMD_NODE_FIND_MASTER_NODE_IDS,
+        CMD_NODE_FIND_MASTER_NODE_IDS_REPLY,
+        CMD_NODE_RELAY_ACK
         // check that not more than CMD_NODE_CUSTOM have been defined!
     };
 }
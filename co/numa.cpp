@@ -0,0 +1,219 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "numa.h"
+
+#include "log.h"
+
+#if defined( CO_USE_HWLOC ) && !defined( _WIN32 )
+#  include <lunchbox/lock.h>
+#  include <lunchbox/scopedMutex.h>
+#  include <hwloc.h>
+#  include <arpa/inet.h>
+#  include <ifaddrs.h>
+#  include <netdb.h>
+#  include <string.h>
+#  define CO_NUMA
+#  if HWLOC_API_VERSION < 0x00010b00
+#    define HWLOC_OBJ_NUMANODE HWLOC_OBJ_NODE
+#  endif
+#endif
+
+namespace co
+{
+namespace numa
+{
+#ifdef CO_NUMA
+namespace
+{
+/** The machine topology including I/O devices, loaded on first use. */
+class Topology
+{
+public:
+    Topology() : topology( 0 )
+    {
+        if( hwloc_topology_init( &topology ) != 0 )
+        {
+            topology = 0;
+            return;
+        }
+
+#if HWLOC_API_VERSION >= 0x00020000
+        hwloc_topology_set_io_types_filter( topology,
+                                            HWLOC_TYPE_FILTER_KEEP_IMPORTANT );
+#else
+        hwloc_topology_set_flags( topology, HWLOC_TOPOLOGY_FLAG_IO_DEVICES );
+#endif
+        if( hwloc_topology_load( topology ) != 0 )
+        {
+            LBWARN << "Can't load hwloc topology" << std::endl;
+            hwloc_topology_destroy( topology );
+            topology = 0;
+        }
+    }
+
+    ~Topology()
+    {
+        if( topology )
+            hwloc_topology_destroy( topology );
+    }
+
+    /** @return true if the machine has more than one NUMA node. */
+    bool isNUMA() const
+    {
+        return topology &&
+               hwloc_get_nbobjs_by_type( topology, HWLOC_OBJ_NUMANODE ) > 1;
+    }
+
+    hwloc_topology_t topology;
+};
+
+lunchbox::Lock _lock;
+
+/** @return the topology, the caller has to hold _lock. */
+Topology& _getTopology()
+{
+    static Topology topology;
+    return topology;
+}
+
+/** @return the name of the local interface with the given address. */
+std::string _getInterface( const std::string& hostname )
+{
+    if( hostname.empty( ))
+        return std::string();
+
+    addrinfo hints;
+    memset( &hints, 0, sizeof( hints ));
+    hints.ai_family = AF_INET;
+    addrinfo* addresses = 0;
+    if( getaddrinfo( hostname.c_str(), 0, &hints, &addresses ) != 0 )
+        return std::string();
+
+    ifaddrs* interfaces = 0;
+    if( getifaddrs( &interfaces ) != 0 )
+    {
+        freeaddrinfo( addresses );
+        return std::string();
+    }
+
+    std::string name;
+    for( const ifaddrs* i = interfaces; i && name.empty(); i = i->ifa_next )
+    {
+        if( !i->ifa_addr || i->ifa_addr->sa_family != AF_INET )
+            continue;
+
+        const in_addr& local =
+            reinterpret_cast< const sockaddr_in* >( i->ifa_addr )->sin_addr;
+        for( const addrinfo* j = addresses; j; j = j->ai_next )
+        {
+            const in_addr& address =
+                reinterpret_cast< const sockaddr_in* >( j->ai_addr )->sin_addr;
+            if( local.s_addr == address.s_addr )
+            {
+                name = i->ifa_name;
+                break;
+            }
+        }
+    }
+
+    freeifaddrs( interfaces );
+    freeaddrinfo( addresses );
+    return name;
+}
+}
+
+int32_t getNode( const std::string& hostname )
+{
+    const std::string name = _getInterface( hostname );
+    if( name.empty( ))
+        return -1;
+
+    lunchbox::ScopedMutex<> mutex( _lock );
+    const Topology& topology = _getTopology();
+    if( !topology.isNUMA( ))
+        return -1;
+
+    for( hwloc_obj_t device = hwloc_get_next_osdev( topology.topology, 0 );
+         device; device = hwloc_get_next_osdev( topology.topology, device ))
+    {
+        if( device->attr->osdev.type != HWLOC_OBJ_OSDEV_NETWORK ||
+            name != device->name )
+        {
+            continue;
+        }
+
+        const hwloc_obj_t parent =
+            hwloc_get_non_io_ancestor_obj( topology.topology, device );
+        if( !parent || !parent->nodeset ||
+            hwloc_bitmap_iszero( parent->nodeset ))
+        {
+            return -1;
+        }
+        const int node = hwloc_bitmap_first( parent->nodeset );
+        LBINFO << "Network interface " << name << " is on NUMA node " << node
+               << std::endl;
+        return node;
+    }
+    return -1;
+}
+
+bool bindThread( const int32_t node )
+{
+    if( node < 0 )
+        return false;
+
+    lunchbox::ScopedMutex<> mutex( _lock );
+    const Topology& topology = _getTopology();
+    if( !topology.isNUMA( ))
+        return false;
+
+    const hwloc_obj_t object = hwloc_get_obj_by_type( topology.topology,
+                                                      HWLOC_OBJ_NUMANODE, 0 );
+    for( hwloc_obj_t i = object; i; i = i->next_cousin )
+    {
+        if( int32_t( i->os_index ) != node )
+            continue;
+
+        if( hwloc_set_cpubind( topology.topology, i->cpuset,
+                               HWLOC_CPUBIND_THREAD ) == 0 )
+        {
+            return true;
+        }
+        LBWARN << "Can't bind thread to NUMA node " << node << ": "
+               << lunchbox::sysError << std::endl;
+        return false;
+    }
+    return false;
+}
+
+#else
+
+int32_t getNode( const std::string& )
+{
+    return -1;
+}
+
+bool bindThread( const int32_t )
+{
+    return false;
+}
+#endif
+}
+}
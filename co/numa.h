@@ -0,0 +1,53 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_NUMA_H
+#define CO_NUMA_H
+
+#include <co/types.h>
+
+namespace co
+{
+    /**
+     * @internal NUMA placement of the node threads, using hwloc.
+     *
+     * Without hwloc support (CO_USE_HWLOC) or on single-node machines, the
+     * NUMA node is unknown and threads are not bound.
+     */
+    namespace numa
+    {
+        /**
+         * @return the NUMA node nearest to the network interface with the
+         *         given host address, or -1 if unknown.
+         */
+        int32_t getNode( const std::string& hostname );
+
+        /**
+         * Bind the calling thread to the cores of the given NUMA node.
+         *
+         * Memory is allocated on first touch, so the buffers allocated and
+         * filled by a bound thread are placed on its NUMA node.
+         *
+         * @return true if the thread was bound, false otherwise.
+         */
+        bool bindThread( const int32_t node );
+    }
+}
+
+#endif // CO_NUMA_H
@@ -212,6 +212,24 @@ uint128_t Object::commit( const uint32_t incarnation )
     return impl_->cm->commit( incarnation );
 }
 
+uint32_t Object::commitNB( const uint32_t incarnation )
+{
+    LBASSERT( isAttached( ));
+    LocalNodePtr localNode = getLocalNode();
+    const uint32_t requestID = localNode->registerRequest( this );
+
+    // executed by ObjectStore::_cmdCommitObject in the commit thread
+    localNode->send( CMD_NODE_COMMIT_OBJECT ) << requestID << incarnation;
+    return requestID;
+}
+
+uint128_t Object::commitSync( const uint32_t requestID )
+{
+    uint128_t version = VERSION_NONE;
+    getLocalNode()->waitRequest( requestID, version );
+    return version;
+}
+
 
 void Object::setupChangeManager( const Object::ChangeType type,
                                  const bool master, LocalNodePtr localNode,
@@ -134,6 +134,18 @@ public:
      */
     CO_API virtual uint32_t chooseCompressor() const;
 
+    /**
+     * Return if the object data uses compact integer encoding.
+     *
+     * When enabled, all 32, 64 and 128 bit integers serialized by this object
+     * are varint-encoded, which reduces the data size considerably for small
+     * values. Serialization and deserialization have to use the same integer
+     * types. The receiving instances detect the encoding from the transmitted
+     * data. The default implementation returns false.
+     * @version 1.0
+     */
+    virtual bool useCompactEncoding() const { return false; }
+
     /**
      * Return if this object needs a commit.
      *
@@ -205,6 +217,36 @@ public:
     CO_API virtual uint128_t commit( const uint32_t incarnation =
                                      CO_COMMIT_NEXT );
 
+    /**
+     * Start committing a new version of this object.
+     *
+     * The commit is executed asynchronously by the commit thread of the
+     * local node, which allows the caller to continue while the new version is
+     * serialized and distributed, and while the commit waits on slow slaves.
+     * The object may not be modified until commitSync() has returned. Each
+     * commitNB() has to be completed by exactly one commitSync().
+     *
+     * Asynchronous commits are executed one at a time in the order they were
+     * started, i.e., a commit waiting on slow slaves delays the following
+     * asynchronous commits of all objects of the local node.
+     *
+     * @param incarnation the commit incarnation for auto obsoletion.
+     * @return the request identifier to be passed to commitSync().
+     * @sa commit()
+     * @version 1.0
+     */
+    CO_API uint32_t commitNB( const uint32_t incarnation = CO_COMMIT_NEXT );
+
+    /**
+     * Finish a commit started by commitNB().
+     *
+     * @param requestID the request identifier returned by commitNB().
+     * @return the new head version (master) or commit id (slave).
+     * @sa commit()
+     * @version 1.0
+     */
+    CO_API uint128_t commitSync( const uint32_t requestID );
+
     /**
      * Automatically obsolete old versions.
      *
@@ -231,7 +273,9 @@ public:
      * Slave objects can be synced to VERSION_HEAD, VERSION_NEXT or to any past
      * or future version generated by a commit on the master instance. Syncing
      * to a concrete version applies all pending versions up to this version and
-     * potentially blocks if given a future version.
+     * potentially blocks if given a future version. Pending versions of
+     * INSTANCE objects which are superseded by an already received later
+     * version are skipped, since each version carries the full instance data.
      *
      * Master objects can only be synced to VERSION_HEAD, VERSION_NEXT or to
      * any version generated by a commit on a slave instance. Syncing to a
@@ -20,6 +20,7 @@
 
 #include "objectCM.h"
 
+#include "localNode.h"
 #include "nodeCommand.h"
 #include "nullCM.h"
 #include "node.h"
@@ -28,6 +29,8 @@
 #include "objectInstanceDataOStream.h"
 #include "objectDataOCommand.h"
 
+#include <lunchbox/stdExt.h>
+
 co::ObjectCMPtr co::ObjectCM::ZERO = new co::NullCM;
 
 #ifdef EQ_INSTRUMENT_MULTICAST
@@ -41,6 +44,12 @@ ObjectCM::ObjectCM( Object* object )
         : _object( object )
 {}
 
+NodeID ObjectCM::getLocalNodeID() const
+{
+    LocalNodePtr localNode = _object->getLocalNode();
+    return localNode ? localNode->getNodeID() : NodeID();
+}
+
 void ObjectCM::push( const uint128_t& groupID, const uint128_t& typeID,
                      const Nodes& nodes )
 {
@@ -77,9 +86,55 @@ void ObjectCM::_addSlave( MasterCMCommand command, const uint128_t& version )
         return;
     }
 
-    const bool replyUseCache = command.useCache() &&
-                   (command.getMasterInstanceID() == _object->getInstanceID( ));
-    _initSlave( command, version, replyUseCache );
+    _initSlave( command, version, _useCache( command ));
+}
+
+void ObjectCM::addSlaves( const ICommands& commands )
+{
+    for( ICommandsCIter i = commands.begin(); i != commands.end(); ++i )
+        addSlave( MasterCMCommand( *i ));
+}
+
+void ObjectCM::_addSlaves( const ICommands& commands,
+                           const uint128_t& version )
+{
+    ICommands initCommands;
+    for( ICommandsCIter i = commands.begin(); i != commands.end(); ++i )
+    {
+        MasterCMCommand command( *i );
+        if( command.getRequestedVersion() == VERSION_NONE )
+            _addSlave( command, version );
+        else
+            initCommands.push_back( *i );
+    }
+
+    if( initCommands.size() == 1 )
+        _addSlave( MasterCMCommand( initCommands.front( )), version );
+    else if( !initCommands.empty( ))
+        _initSlaves( initCommands, version );
+}
+
+bool ObjectCM::_useCache( const MasterCMCommand& command ) const
+{
+    return command.useCache() &&
+           command.getMasterInstanceID() == _object->getInstanceID();
+}
+
+Connections ObjectCM::_getMapConnections( const ICommands& commands )
+{
+    // Use the same connection as the map success of each slave, sending at
+    // most once over each multicast connection
+    Connections connections;
+    for( ICommandsCIter i = commands.begin(); i != commands.end(); ++i )
+    {
+        ConnectionPtr connection = i->getNode()->getConnection( true );
+        if( connection &&
+            stde::find( connections, connection ) == connections.end( ))
+        {
+            connections.push_back( connection );
+        }
+    }
+    return connections;
 }
 
 void ObjectCM::_initSlave( MasterCMCommand command,
@@ -130,13 +185,64 @@ void ObjectCM::_initSlave( MasterCMCommand command,
     _sendMapReply( command, replyVersion, true, replyUseCache, true );
 }
 
+void ObjectCM::_initSlaves( const ICommands& commands,
+                            const uint128_t& replyVersion )
+{
+    ICommands misses;
+    for( ICommandsCIter i = commands.begin(); i != commands.end(); ++i )
+    {
+        MasterCMCommand command( *i );
+        if( _useCache( command ) &&
+            command.getMinCachedVersion() <= replyVersion &&
+            command.getMaxCachedVersion() >= replyVersion )
+        {
+            _initSlave( command, replyVersion, true ); // cache hit
+        }
+        else
+            misses.push_back( *i );
+    }
+
+    if( misses.size() < 2 )
+    {
+        if( !misses.empty( ))
+            _initSlave( MasterCMCommand( misses.front( )), replyVersion,
+                        false );
+        return;
+    }
+
+#ifdef EQ_INSTRUMENT_MULTICAST
+    _miss += misses.size();
+#endif
+    for( ICommandsCIter i = misses.begin(); i != misses.end(); ++i )
+        _sendMapSuccess( MasterCMCommand( *i ), true, replyVersion,
+                         replyVersion );
+
+    // send instance data once to all slaves
+    ObjectInstanceDataOStream os( this );
+    os.enableMap( replyVersion, _getMapConnections( misses ));
+    _object->getInstanceData( os );
+    os.disable();
+
+    for( ICommandsCIter i = misses.begin(); i != misses.end(); ++i )
+    {
+        MasterCMCommand command( *i );
+        if( !os.hasSentData( ))
+            // no data, send empty command to set version
+            _sendEmptyVersion( command, replyVersion, true /* mc */ );
+        _sendMapReply( command, replyVersion, true, false, true );
+    }
+}
+
 void ObjectCM::_sendMapSuccess( const MasterCMCommand& command,
-                                const bool multicast )
+                                const bool multicast,
+                                const uint128_t& first,
+                                const uint128_t& last )
 {
     command.getNode()->send( CMD_NODE_MAP_OBJECT_SUCCESS, multicast )
             << command.getNode()->getNodeID() << command.getObjectID()
             << command.getRequestID() << command.getInstanceID()
-            << _object->getChangeType() << _object->getInstanceID();
+            << _object->getChangeType() << _object->getInstanceID()
+            << first << last;
 }
 
 void ObjectCM::_sendMapReply( const MasterCMCommand& command,
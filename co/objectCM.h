@@ -119,6 +119,15 @@ public:
      */
     virtual void addSlave( MasterCMCommand command ) = 0;
 
+    /**
+     * Add the subscribed slaves of concurrent map requests.
+     *
+     * The default implementation adds them one by one.
+     *
+     * @param commands the subscribe commands initiating the add.
+     */
+    virtual void addSlaves( const ICommands& commands );
+
     /**
      * Remove a subscribed slave.
      *
@@ -146,9 +155,18 @@ public:
     /** Speculatively send instance data to all nodes. */
     virtual void sendInstanceData( Nodes& nodes ){}
 
+    /**
+     * @return true if commit data can be relayed through the given slave node.
+     *         Called with the slaves locked during commit.
+     */
+    virtual bool canRelay( NodePtr ) const { return false; }
+
     /** @internal @return the object. */
     const Object* getObject( ) const { return _object; }
 
+    /** @internal @return the identifier of the node holding the object. */
+    NodeID getLocalNodeID() const;
+
     /** @internal Swap the object. */
     void setObject( Object* object )
         { LBASSERT( object ); _object = object; }
@@ -166,11 +184,32 @@ protected:
 #endif
 
     void _addSlave( MasterCMCommand command, const uint128_t& version );
+    void _addSlaves( const ICommands& commands, const uint128_t& version );
     virtual void _initSlave( MasterCMCommand command,
                              const uint128_t& replyVersion,
                              bool replyUseCache );
+
+    /**
+     * Initialize the slaves of concurrent map requests, serializing the
+     * instance data only once for all requests not served from the cache.
+     */
+    virtual void _initSlaves( const ICommands& commands,
+                              const uint128_t& replyVersion );
+
+    /** @return true if the slave may use its instance cache. */
+    bool _useCache( const MasterCMCommand& command ) const;
+
+    /** @return the connections to send map data to all requesters. */
+    static Connections _getMapConnections( const ICommands& commands );
+
+    /**
+     * Send the map success, announcing map data for the given versions which
+     * might be sent to multiple slaves at once.
+     */
     void _sendMapSuccess( const MasterCMCommand& command,
-                          const bool multicast );
+                          const bool multicast,
+                          const uint128_t& first = VERSION_NONE,
+                          const uint128_t& last = VERSION_NONE );
     void _sendMapReply( const MasterCMCommand& command,
                         const uint128_t& version, const bool result,
                         const bool useCache, const bool multicast );
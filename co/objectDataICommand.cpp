@@ -107,7 +107,12 @@ uint32_t ObjectDataICommand::getCompressor() const
 
 uint32_t ObjectDataICommand::getChunks() const
 {
-    return _impl->chunks;
+    return _impl->chunks & ~DATA_CHUNKS_COMPACT;
+}
+
+bool ObjectDataICommand::isCompact() const
+{
+    return ( _impl->chunks & DATA_CHUNKS_COMPACT ) != 0;
 }
 
 bool ObjectDataICommand::isLast() const
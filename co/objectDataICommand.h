@@ -56,6 +56,9 @@ public:
     /** @return the number of chunks containing the object data. */
     CO_API uint32_t getChunks() const;
 
+    /** @return true if the object data uses compact integer encoding. */
+    CO_API bool isCompact() const;
+
     /** @return true if this is the last command for one object. */
     CO_API bool isLast() const;
 
@@ -86,16 +86,26 @@ void ObjectDataIStream::addDataCommand( ObjectDataICommand command )
 }
 
 bool ObjectDataIStream::hasInstanceData() const
+{
+    return _getCommand() == CMD_OBJECT_INSTANCE;
+}
+
+bool ObjectDataIStream::hasInstanceDelta() const
+{
+    return _getCommand() == CMD_OBJECT_INSTANCE_DELTA;
+}
+
+uint32_t ObjectDataIStream::_getCommand() const
 {
     if( !_usedCommand.isValid() && _commands.empty( ))
     {
         LBUNREACHABLE;
-        return false;
+        return CMD_OBJECT_CUSTOM;
     }
 
     const ICommand& command = _usedCommand.isValid() ? _usedCommand :
                                                       _commands.front();
-    return( command.getCommand() == CMD_OBJECT_INSTANCE );
+    return command.getCommand();
 }
 
 NodePtr ObjectDataIStream::getMaster()
@@ -145,6 +155,7 @@ bool ObjectDataIStream::getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
 
     LBASSERT( _usedCommand.getCommand() == CMD_OBJECT_INSTANCE ||
               _usedCommand.getCommand() == CMD_OBJECT_DELTA ||
+              _usedCommand.getCommand() == CMD_OBJECT_INSTANCE_DELTA ||
               _usedCommand.getCommand() == CMD_OBJECT_SLAVE_DELTA );
 
     ObjectDataICommand command( _usedCommand );
@@ -169,6 +180,7 @@ bool ObjectDataIStream::getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
     *chunkData = command.getRemainingBuffer( command.getRemainingBufferSize( ));
 
     setSwapping( command.isSwapping( ));
+    setCompact( command.isCompact( ));
     return true;
 }
 
@@ -53,6 +53,9 @@ namespace co
         virtual void reset();
 
         bool hasInstanceData() const;
+
+        /** @return true if the data is a binary delta of the instance data. */
+        bool hasInstanceDelta() const;
         CO_API virtual NodePtr getMaster();
 
     protected:
@@ -71,6 +74,7 @@ namespace co
         lunchbox::Monitor< uint128_t > _version;
 
         void _setReady() { _version = getPendingVersion(); }
+        uint32_t _getCommand() const;
         void _reset();
 
         LB_TS_VAR( _thread );
@@ -106,7 +106,8 @@ ObjectDataOCommand::~ObjectDataOCommand()
     delete _impl;
 }
 
-ObjectDataICommand ObjectDataOCommand::_getCommand( LocalNodePtr node )
+ObjectDataICommand ObjectDataOCommand::_getCommand( LocalNodePtr node,
+                                                    NodePtr remote )
 {
     lunchbox::Bufferb& outBuffer = getBuffer();
     uint8_t* bytes = outBuffer.getData();
@@ -114,7 +115,10 @@ ObjectDataICommand ObjectDataOCommand::_getCommand( LocalNodePtr node )
 
     BufferPtr inBuffer = node->allocBuffer( outBuffer.getSize( ));
     inBuffer->swap( outBuffer );
-    return ObjectDataICommand( node, node, inBuffer, false );
+    _impl->stream = 0; // the data is in the command, nothing left to send
+    if( !remote )
+        remote = node;
+    return ObjectDataICommand( node, remote, inBuffer, false );
 }
 
 }
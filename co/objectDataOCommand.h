@@ -76,8 +76,11 @@ private:
     ObjectDataOCommand& operator = ( const ObjectDataOCommand& );
     detail::ObjectDataOCommand* const _impl;
 
-    CO_API ObjectDataICommand _getCommand( LocalNodePtr node ); // needed by:
+    /** @return the command for local use, received from remote or node. */
+    CO_API ObjectDataICommand _getCommand( LocalNodePtr node,
+                                           NodePtr remote = NodePtr( ));
     friend int ::testMain( int, char ** );
+    friend class ObjectStore;
 
     void _init( const uint128_t& version, const uint32_t sequence,
                 const uint64_t dataSize, const bool isLast );
@@ -21,9 +21,11 @@
 
 #include "objectDataOStream.h"
 
+#include "global.h"
 #include "log.h"
 #include "objectCM.h"
 #include "objectDataOCommand.h"
+#include "relayConnection.h"
 
 namespace co
 {
@@ -35,6 +37,7 @@ ObjectDataOStream::ObjectDataOStream( const ObjectCM* cm )
     const Object* object = cm->getObject();
     const uint32_t name = object->chooseCompressor();
     _initCompressor( name );
+    setCompact( object->useCompactEncoding( ));
     LBLOG( LOG_OBJECTS )
         << "Using byte compressor 0x" << std::hex << name << std::dec << " for "
         << lunchbox::className( object ) << std::endl;
@@ -51,10 +54,43 @@ void ObjectDataOStream::enableCommit( const uint128_t& version,
                                       const Nodes& receivers )
 {
     _version = version;
-    _setupConnections( receivers );
+    _setupCommitConnections( receivers );
     _enable();
 }
 
+void ObjectDataOStream::_setupCommitConnections( const Nodes& receivers )
+{
+    const int32_t fanOut =
+        Global::getIAttribute( Global::IATTR_OBJECT_RELAY_FANOUT );
+    if( fanOut <= 0 || receivers.size() <= size_t( fanOut ))
+    {
+        _setupConnections( receivers );
+        return;
+    }
+
+    Nodes direct;
+    Nodes relayed;
+    for( NodesCIter i = receivers.begin(); i != receivers.end(); ++i )
+    {
+        if( _cm->canRelay( *i ))
+            relayed.push_back( *i );
+        else
+            direct.push_back( *i );
+    }
+
+    if( relayed.size() <= size_t( fanOut ))
+    {
+        _setupConnections( receivers );
+        return;
+    }
+
+    _setupConnections( direct );
+    Connections connections = getConnections();
+    RelayConnection::gather( relayed, _cm->getLocalNodeID(), fanOut,
+                             connections );
+    _setupConnections( connections );
+}
+
 ObjectDataOCommand ObjectDataOStream::send(
     const uint32_t cmd, const uint32_t type, const uint32_t instanceID,
     const uint64_t size, const bool last )
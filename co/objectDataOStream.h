@@ -46,6 +46,12 @@ namespace co
                                  const uint32_t instanceID, const uint64_t size,
                                  const bool last );
 
+        /**
+         * Set up the connections for committing to the receivers, relaying
+         * through slaves if IATTR_OBJECT_RELAY_FANOUT is set.
+         */
+        void _setupCommitConnections( const Nodes& receivers );
+
         const ObjectCM* _cm;
         uint128_t _version;
         uint32_t _sequence;
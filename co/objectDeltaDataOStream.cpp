@@ -28,8 +28,10 @@
 
 namespace co
 {
-ObjectDeltaDataOStream::ObjectDeltaDataOStream( const ObjectCM* cm )
+ObjectDeltaDataOStream::ObjectDeltaDataOStream( const ObjectCM* cm,
+                                                const uint32_t command )
         : ObjectDataOStream( cm )
+        , _command( command )
 {}
 
 ObjectDeltaDataOStream::~ObjectDeltaDataOStream()
@@ -38,7 +40,7 @@ ObjectDeltaDataOStream::~ObjectDeltaDataOStream()
 void ObjectDeltaDataOStream::sendData( const void* buffer, const uint64_t size,
                                        const bool last )
 {
-    ObjectDataOStream::send( CMD_OBJECT_DELTA, COMMANDTYPE_OBJECT,
+    ObjectDataOStream::send( _command, COMMANDTYPE_OBJECT,
                              EQ_INSTANCE_ALL, size, last );
 }
 
@@ -22,6 +22,7 @@
 #define CO_OBJECTDELTADATAOSTREAM_H
 
 #include "objectDataOStream.h"   // base class
+#include "objectICommand.h"      // CMD_OBJECT_DELTA default
 
 namespace co
 {
@@ -29,12 +30,20 @@ namespace co
     class ObjectDeltaDataOStream : public ObjectDataOStream
     {
     public:
-        ObjectDeltaDataOStream( const ObjectCM* cm );
+        /**
+         * Construct a delta stream sending the given object command, either
+         * CMD_OBJECT_DELTA or CMD_OBJECT_INSTANCE_DELTA.
+         */
+        ObjectDeltaDataOStream( const ObjectCM* cm,
+                                const uint32_t command = CMD_OBJECT_DELTA );
         virtual ~ObjectDeltaDataOStream();
 
     protected:
         virtual void sendData( const void* buffer, const uint64_t size,
                                const bool last );
+
+    private:
+        const uint32_t _command;
     };
 }
 #endif //CO_OBJECTDELTADATAOSTREAM_H
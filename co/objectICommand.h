@@ -30,7 +30,9 @@ enum ObjectCommands
     CMD_OBJECT_INSTANCE,
     CMD_OBJECT_DELTA,
     CMD_OBJECT_SLAVE_DELTA,
-    CMD_OBJECT_MAX_VERSION
+    CMD_OBJECT_MAX_VERSION,
+    CMD_OBJECT_INSTANCE_DELTA,
+    CMD_OBJECT_RELAY_MAX_VERSION
     // check that not more then CMD_OBJECT_CUSTOM have been defined!
 };
 
@@ -63,7 +63,9 @@ void ObjectInstanceDataOStream::enablePush( const uint128_t& version,
     _command = CMD_NODE_OBJECT_INSTANCE_PUSH;
     _nodeID = 0;
     _instanceID = EQ_INSTANCE_NONE;
-    ObjectDataOStream::enableCommit( version, receivers );
+    _version = version;
+    _setupConnections( receivers ); // pushes are not relayed
+    _enable();
 }
 
 void ObjectInstanceDataOStream::push( const Nodes& receivers,
@@ -83,6 +85,16 @@ void ObjectInstanceDataOStream::push( const Nodes& receivers,
     _clearConnections();
 }
 
+void ObjectInstanceDataOStream::commit( const Nodes& receivers )
+{
+    _command = CMD_NODE_OBJECT_INSTANCE_COMMIT;
+    _nodeID = 0;
+    _instanceID = EQ_INSTANCE_NONE;
+    _setupCommitConnections( receivers );
+    _resend();
+    _clearConnections();
+}
+
 void ObjectInstanceDataOStream::sendInstanceData( const Nodes& receivers )
 {
     _command = CMD_NODE_OBJECT_INSTANCE;
@@ -104,6 +116,16 @@ void ObjectInstanceDataOStream::sendMapData( NodePtr node,
     _clearConnections();
 }
 
+void ObjectInstanceDataOStream::sendMapData( const Connections& connections )
+{
+    _command = CMD_NODE_OBJECT_INSTANCE_MAP;
+    _nodeID = 0; // see ObjectStore::_dispatchMapData()
+    _instanceID = EQ_INSTANCE_NONE;
+    _setupConnections( connections );
+    _resend();
+    _clearConnections();
+}
+
 void ObjectInstanceDataOStream::enableMap( const uint128_t& version,
                                            NodePtr node,
                                            const uint32_t instanceID )
@@ -116,6 +138,17 @@ void ObjectInstanceDataOStream::enableMap( const uint128_t& version,
     _enable();
 }
 
+void ObjectInstanceDataOStream::enableMap( const uint128_t& version,
+                                           const Connections& connections )
+{
+    _command = CMD_NODE_OBJECT_INSTANCE_MAP;
+    _nodeID = 0; // see ObjectStore::_dispatchMapData()
+    _instanceID = EQ_INSTANCE_NONE;
+    _version = version;
+    _setupConnections( connections );
+    _enable();
+}
+
 void ObjectInstanceDataOStream::sendData( const void* buffer,
                                           const uint64_t size, const bool last )
 {
@@ -49,12 +49,28 @@ namespace co
         void enableMap( const uint128_t& version, NodePtr node,
                         const uint32_t instanceID );
 
+        /**
+         * Set up mapping of the given version to all slaves awaiting it on the
+         * given connections.
+         */
+        void enableMap( const uint128_t& version,
+                        const Connections& connections );
+
+        /** Commit a stored instance data to the receivers. */
+        void commit( const Nodes& receivers );
+
+        /** @return the saved instance data, uncompressed until first sent. */
+        const lunchbox::Bufferb& getSaveBuffer() { return getBuffer(); }
+
         /** Send-on-register instance data to all receivers. */
         void sendInstanceData( const Nodes& receivers );
 
         /** Send mapping data to the node, using multicast if available. */
         void sendMapData( NodePtr node, const uint32_t instanceID );
 
+        /** Send mapping data to all slaves awaiting it on the connections. */
+        void sendMapData( const Connections& connections );
+
     protected:
         virtual void sendData( const void* buffer, const uint64_t size,
                                const bool last );
@@ -20,9 +20,12 @@
 
 #include "objectMap.h"
 
+#include "commit.h"
+#include "commitBatch.h"
 #include "dataIStream.h"
 #include "dataOStream.h"
 #include "objectFactory.h"
+#include "syncBatch.h"
 
 #include <lunchbox/scopedMutex.h>
 
@@ -56,7 +59,8 @@ class ObjectMap
 {
 public:
     ObjectMap( ObjectHandler& h, ObjectFactory& f )
-        : handler( h ) , factory( f ) {}
+        : handler( h ) , factory( f ), batchedCommit( false )
+        , parallelCommit( false ) {}
 
     ~ObjectMap()
     {
@@ -107,6 +111,12 @@ public:
 
     /** Changed master objects since the last commit. */
     ObjectVersions changed;
+
+    /** Coalesce the commits of all masters into one command per receiver. */
+    bool batchedCommit;
+
+    /** Commit the masters concurrently using co::commit(). */
+    bool parallelCommit;
 };
 }
 
@@ -129,6 +139,26 @@ uint128_t ObjectMap::commit( const uint32_t incarnation )
     return version;
 }
 
+void ObjectMap::setBatchedCommit( const bool onOff )
+{
+    _impl->batchedCommit = onOff;
+}
+
+bool ObjectMap::isBatchedCommit() const
+{
+    return _impl->batchedCommit;
+}
+
+void ObjectMap::setParallelCommit( const bool onOff )
+{
+    _impl->parallelCommit = onOff;
+}
+
+bool ObjectMap::isParallelCommit() const
+{
+    return _impl->parallelCommit;
+}
+
 bool ObjectMap::isDirty() const
 {
     if( Serializable::isDirty( ))
@@ -145,13 +175,31 @@ void ObjectMap::_commitMasters( const uint32_t incarnation )
 {
     lunchbox::ScopedFastWrite mutex( _impl->lock );
 
+    Objects dirty;
     for( ObjectsCIter i =_impl->masters.begin(); i !=_impl->masters.end(); ++i )
     {
         Object* object = *i;
-        if( !object->isDirty() || object->getChangeType() == Object::STATIC )
-            continue;
+        if( object->isDirty() && object->getChangeType() != Object::STATIC )
+            dirty.push_back( object );
+    }
 
-        const ObjectVersion ov( object->getID(), object->commit( incarnation ));
+    ObjectVersions versions;
+    if( _impl->parallelCommit )
+        versions = co::commit( dirty, incarnation, _impl->batchedCommit );
+    else
+    {
+        CommitBatch batch( _impl->batchedCommit );
+        for( ObjectsCIter i = dirty.begin(); i != dirty.end(); ++i )
+        {
+            Object* object = *i;
+            versions.push_back( ObjectVersion( object->getID(),
+                                               object->commit( incarnation )));
+        }
+    }
+
+    for( ObjectVersionsCIter i = versions.begin(); i != versions.end(); ++i )
+    {
+        const ObjectVersion& ov = *i;
         Entry& entry = _impl->map[ ov.identifier ];
         if( entry.version == ov.version )
             continue;
@@ -241,6 +289,7 @@ void ObjectMap::deserialize( DataIStream& is, const uint64_t dirtyBits )
         ObjectVersions changed;
         is >> changed;
 
+        SyncBatch batch;
         for( ObjectVersionsCIter i = changed.begin(); i!=changed.end(); ++i)
         {
             const ObjectVersion& ov = *i;
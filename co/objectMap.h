@@ -117,6 +117,37 @@ public:
     /** Deregister or unmap all registered and mapped objects. @version 1.0 */
     CO_API void clear();
 
+    /**
+     * Enable or disable batched commits of the registered master objects.
+     *
+     * In batched mode, the data of all objects committed by commit() is
+     * coalesced into one command per receiver connection, instead of sending
+     * at least one padded command per object. All nodes mapping the objects
+     * need to support batched commits. Disabled by default.
+     *
+     * @param onOff true to enable batched commits, false to disable them.
+     * @version 1.0
+     */
+    CO_API void setBatchedCommit( const bool onOff );
+
+    /** @return true if batched commits are enabled. @version 1.0 */
+    CO_API bool isBatchedCommit() const;
+
+    /**
+     * Enable or disable parallel commits of the registered master objects.
+     *
+     * In parallel mode, commit() commits all dirty masters concurrently using
+     * co::commit(). The masters have to support being committed from
+     * multiple threads. Disabled by default.
+     *
+     * @param onOff true to enable parallel commits, false to disable them.
+     * @version 1.0
+     */
+    CO_API void setParallelCommit( const bool onOff );
+
+    /** @return true if parallel commits are enabled. @version 1.0 */
+    CO_API bool isParallelCommit() const;
+
     /** Commit all registered objects. @version 1.0 */
     CO_API virtual uint128_t commit( const uint32_t incarnation =
                                      CO_COMMIT_NEXT );
@@ -22,22 +22,27 @@
 #include "objectStore.h"
 
 #include "barrier.h"
+#include "commandQueue.h"
+#include "commitBatch.h"
 #include "connection.h"
 #include "connectionDescription.h"
 #include "global.h"
 #include "instanceCache.h"
 #include "log.h"
+#include "memoryBudget.h"
 #include "masterCMCommand.h"
 #include "nodeCommand.h"
 #include "oCommand.h"
 #include "objectCM.h"
 #include "objectDataIStream.h"
 #include "objectDataICommand.h"
+#include "objectDataOCommand.h"
 #include "objectICommand.h"
 
 #include <lunchbox/scopedMutex.h>
 
 #include <limits>
+#include <map>
 
 //#define DEBUG_DISPATCH
 #ifdef DEBUG_DISPATCH
@@ -46,13 +51,31 @@
 
 namespace co
 {
+namespace
+{
+/** Provides the data header of uncompressed data for a local command. */
+class HeaderOStream : public DataOStream
+{
+public:
+    explicit HeaderOStream( const bool compact ) { setCompact( compact ); }
+
+protected:
+    virtual void sendData( const void*, const uint64_t, const bool )
+        { LBDONTCALL; }
+};
+}
+
 typedef CommandFunc<ObjectStore> CmdFunc;
 
 ObjectStore::ObjectStore( LocalNode* localNode )
         : _localNode( localNode )
         , _instanceIDs( -0x7FFFFFFF )
-        , _instanceCache( new InstanceCache( Global::getIAttribute(
-                              Global::IATTR_INSTANCE_CACHE_SIZE ) * LB_1MB ) )
+        , _instanceCache( new InstanceCache(
+              uint64_t( Global::getIAttribute(
+                            Global::IATTR_INSTANCE_CACHE_SIZE )) * LB_1MB,
+              Global::getInstanceCacheFile(),
+              uint64_t( Global::getIAttribute(
+                         Global::IATTR_INSTANCE_CACHE_FILE_SIZE )) * LB_1MB ))
 {
     LBASSERT( localNode );
     CommandQueue* queue = localNode->getCommandThreadQueue();
@@ -61,6 +84,10 @@ ObjectStore::ObjectStore( LocalNode* localNode )
         CmdFunc( this, &ObjectStore::_cmdFindMasterNodeID ), queue );
     localNode->_registerCommand( CMD_NODE_FIND_MASTER_NODE_ID_REPLY,
         CmdFunc( this, &ObjectStore::_cmdFindMasterNodeIDReply ), 0 );
+    localNode->_registerCommand( CMD_NODE_FIND_MASTER_NODE_IDS,
+        CmdFunc( this, &ObjectStore::_cmdFindMasterNodeIDs ), queue );
+    localNode->_registerCommand( CMD_NODE_FIND_MASTER_NODE_IDS_REPLY,
+        CmdFunc( this, &ObjectStore::_cmdFindMasterNodeIDsReply ), 0 );
     localNode->_registerCommand( CMD_NODE_ATTACH_OBJECT,
         CmdFunc( this, &ObjectStore::_cmdAttachObject ), 0 );
     localNode->_registerCommand( CMD_NODE_DETACH_OBJECT,
@@ -93,6 +120,9 @@ ObjectStore::ObjectStore( LocalNode* localNode )
         CmdFunc( this, &ObjectStore::_cmdRemoveNode ), queue );
     localNode->_registerCommand( CMD_NODE_OBJECT_PUSH,
         CmdFunc( this, &ObjectStore::_cmdObjectPush ), queue );
+    localNode->_registerCommand( CMD_NODE_COMMIT_OBJECT,
+        CmdFunc( this, &ObjectStore::_cmdCommitObject ),
+        localNode->_getCommitThreadQueue( ));
 }
 
 ObjectStore::~ObjectStore()
@@ -135,6 +165,7 @@ void ObjectStore::clear( )
     LBASSERT( !_instanceCache || _instanceCache->isEmpty( ));
 
     _objects->clear();
+    _masterNodeIDs->clear();
     _sendQueue.clear();
 }
 
@@ -155,6 +186,54 @@ void ObjectStore::removeInstanceData( const NodeID& nodeID )
 {
     if( _instanceCache )
         _instanceCache->remove( nodeID );
+
+    lunchbox::ScopedFastWrite mutex( _masterNodeIDs );
+    for( NodeIDHash::iterator i = _masterNodeIDs->begin();
+         i != _masterNodeIDs->end(); )
+    {
+        if( i->second == nodeID )
+            _masterNodeIDs->erase( i++ );
+        else
+            ++i;
+    }
+}
+
+void ObjectStore::addInstanceData( const ObjectVersion& rev,
+                                   const uint32_t masterInstanceID,
+                                   NodePtr master,
+                                   const lunchbox::Bufferb& data,
+                                   const bool compact )
+{
+    if( !_instanceCache || data.isEmpty( ))
+        return;
+
+    // only provides the data header of the uncompressed data
+    HeaderOStream header( compact );
+    ObjectDataOCommand out( Connections(), CMD_OBJECT_INSTANCE,
+                            COMMANDTYPE_OBJECT, rev.identifier,
+                            EQ_INSTANCE_NONE, rev.version, 0, data.getSize(),
+                            true, &header );
+    out << NodeID() << masterInstanceID
+        << Array< const uint8_t >( data.getData(), data.getSize( ));
+
+    ObjectDataICommand command = out._getCommand( _localNode, master );
+    _instanceCache->add( rev, masterInstanceID, command, 0 );
+}
+
+uint64_t ObjectStore::getInstanceDataSize() const
+{
+    if( !_instanceCache )
+        return 0;
+    return _instanceCache->getSize() + _instanceCache->getFileQueueSize();
+}
+
+void ObjectStore::shrinkInstanceData( const uint64_t size )
+{
+    if( !_instanceCache )
+        return;
+
+    const uint64_t used = _instanceCache->getSize();
+    _instanceCache->shrink( used > size ? used - size : 0 );
 }
 
 void ObjectStore::enableSendOnRegister()
@@ -181,34 +260,127 @@ NodeID ObjectStore::_findMasterNodeID( const UUID& identifier )
 {
     LB_TS_NOT_THREAD( _commandThread );
 
-    // OPT: look up locally first?
-    Nodes nodes;
-    _localNode->getNodes( nodes );
+    UUIDs masterIDs;
+    _findMasterNodeIDs( UUIDs( 1, identifier ), masterIDs );
 
-    // OPT: send to multiple nodes at once?
-    for( NodesIter i = nodes.begin(); i != nodes.end(); ++i )
+    LBLOG( LOG_OBJECTS ) << "Object " << identifier << " master "
+                         << masterIDs.front() << std::endl;
+    return masterIDs.front();
+}
+
+void ObjectStore::_findMasterNodeIDs( const UUIDs& ids, UUIDs& masterIDs )
+{
+    LB_TS_NOT_THREAD( _commandThread );
+
+    masterIDs.resize( ids.size( ));
+    UUIDs unknown;
+    std::vector< size_t > indices;
+    for( size_t i = 0; i < ids.size(); ++i )
     {
-        NodePtr node = *i;
-        const uint32_t requestID = _localNode->registerRequest();
+        masterIDs[i] = _findLocalMasterNodeID( ids[i] );
+        if( masterIDs[i] != 0 )
+            continue;
+
+        unknown.push_back( ids[i] );
+        indices.push_back( i );
+    }
+
+    if( unknown.empty( ))
+        return;
+
+    Nodes nodes;
+    _localNode->getNodes( nodes, false );
 
-        LBLOG( LOG_OBJECTS ) << "Finding " << identifier << " on " << node
-                             << " req " << requestID << std::endl;
-        node->send( CMD_NODE_FIND_MASTER_NODE_ID ) << identifier << requestID;
+    // send all remaining identifiers to all nodes at once
+    std::vector< UUIDs > replies( nodes.size( ));
+    std::vector< uint32_t > requestIDs( nodes.size( ));
+    for( size_t i = 0; i < nodes.size(); ++i )
+    {
+        requestIDs[i] = _localNode->registerRequest( &replies[i] );
+        LBLOG( LOG_OBJECTS ) << "Finding " << unknown.size() << " objects on "
+                             << nodes[i] << " req " << requestIDs[i]
+                             << std::endl;
+        nodes[i]->send( CMD_NODE_FIND_MASTER_NODE_IDS ) << unknown
+                                                        << requestIDs[i];
+    }
 
-        NodeID masterNodeID;
-        _localNode->waitRequest( requestID, masterNodeID );
+    for( size_t i = 0; i < nodes.size(); ++i )
+    {
+        _localNode->waitRequest( requestIDs[i] );
 
-        if( masterNodeID != 0 )
+        const UUIDs& reply = replies[i];
+        LBASSERTINFO( reply.size() == unknown.size(),
+                      reply.size() << " != " << unknown.size( ));
+        for( size_t j = 0; j < reply.size() && j < unknown.size(); ++j )
         {
-            LBLOG( LOG_OBJECTS ) << "Found " << identifier << " on "
-                                 << masterNodeID << std::endl;
-            return masterNodeID;
+            NodeID& masterID = masterIDs[ indices[j] ];
+            if( masterID == 0 )
+                masterID = reply[j];
         }
     }
 
+    for( size_t i = 0; i < unknown.size(); ++i )
+    {
+        const NodeID& masterID = masterIDs[ indices[i] ];
+        if( masterID != 0 )
+            _setMasterNodeID( unknown[i], masterID );
+    }
+}
+
+NodeID ObjectStore::_findLocalMasterNodeID( const UUID& id )
+{
+    {
+        lunchbox::ScopedFastRead mutex( _masterNodeIDs );
+        NodeIDHash::const_iterator i = _masterNodeIDs->find( id );
+        if( i != _masterNodeIDs->end( ))
+            return i->second;
+    }
+
+    lunchbox::ScopedFastRead mutex( _objects );
+    ObjectsHashCIter i = _objects->find( id );
+    if( i == _objects->end( ))
+        return NodeID();
+
+    const Objects& objects = i->second;
+    LBASSERT( !objects.empty( ));
+
+    for( ObjectsCIter j = objects.begin(); j != objects.end(); ++j )
+    {
+        Object* object = *j;
+        if( object->isMaster( ))
+            return _localNode->getNodeID();
+
+        NodePtr master = object->getMasterNode();
+        if( master.isValid() && master->getNodeID() != 0 )
+            return master->getNodeID();
+    }
     return NodeID();
 }
 
+void ObjectStore::_setMasterNodeID( const UUID& id, const NodeID& nodeID )
+{
+    LBASSERT( nodeID != 0 );
+    {
+        lunchbox::ScopedFastRead mutex( _masterNodeIDs );
+        NodeIDHash::const_iterator i = _masterNodeIDs->find( id );
+        if( i != _masterNodeIDs->end() && i->second == nodeID )
+            return;
+    }
+
+    lunchbox::ScopedFastWrite mutex( _masterNodeIDs );
+    NodeID& masterID = _masterNodeIDs.data[ id ];
+    if( masterID != nodeID ) // changed meanwhile
+        masterID = nodeID;
+}
+
+void ObjectStore::_removeMasterNodeID( const UUID& id, const NodeID& nodeID )
+{
+    lunchbox::ScopedFastWrite mutex( _masterNodeIDs );
+    NodeIDHash::iterator i = _masterNodeIDs->find( id );
+    if( i != _masterNodeIDs->end() && ( nodeID == 0 || i->second == nodeID ))
+        _masterNodeIDs->erase( i );
+}
+
 //---------------------------------------------------------------------------
 // object mapping
 //---------------------------------------------------------------------------
@@ -261,7 +433,7 @@ void ObjectStore::_attachObject( Object* object, const UUID& id,
         objects.push_back( object );
     }
 
-    _localNode->flushCommands(); // redispatch pending commands
+    _localNode->_retryPendingCommands( id ); // redispatch pending commands
 
     LBLOG( LOG_OBJECTS ) << "attached " << *object << " @"
                          << static_cast< void* >( object ) << std::endl;
@@ -347,9 +519,12 @@ uint32_t ObjectStore::mapObjectNB( Object* object, const UUID& id,
 
     NodePtr master = _connectMaster( id );
     LBASSERT( master );
-    if( master )
-        return mapObjectNB( object, id, version, master );
-    return LB_UNDEFINED_UINT32;
+    if( !master )
+        return LB_UNDEFINED_UINT32;
+
+    const uint32_t requestID = mapObjectNB( object, id, version, master );
+    _addMapRetry( requestID, id, version, master );
+    return requestID;
 }
 
 uint32_t ObjectStore::mapObjectNB( Object* object, const UUID& id,
@@ -358,6 +533,13 @@ uint32_t ObjectStore::mapObjectNB( Object* object, const UUID& id,
     if( !master )
         return mapObjectNB( object, id, version ); // will call us again
 
+    return _mapObjectNB( object, id, version, master, false );
+}
+
+uint32_t ObjectStore::_mapObjectNB( Object* object, const UUID& id,
+                                    const uint128_t& version, NodePtr master,
+                                    const bool batch )
+{
     LB_TS_NOT_THREAD( _commandThread );
     LB_TS_NOT_THREAD( _receiverThread );
     LBLOG( LOG_OBJECTS )
@@ -396,7 +578,7 @@ uint32_t ObjectStore::mapObjectNB( Object* object, const UUID& id,
     uint32_t masterInstanceID = 0;
     bool useCache = false;
 
-    if( _instanceCache )
+    if( _instanceCache && _instanceCache->load( id, _localNode, master ))
     {
         const InstanceCache::Data& cached = (*_instanceCache)[ id ];
         if( cached != InstanceCache::Data::NONE )
@@ -414,7 +596,11 @@ uint32_t ObjectStore::mapObjectNB( Object* object, const UUID& id,
     }
 
     object->notifyAttach();
-    master->send( CMD_NODE_MAP_OBJECT )
+
+    Connections connections( 1, master->getConnection( ));
+    if( batch )
+        CommitBatch::substitute( connections );
+    OCommand( connections, CMD_NODE_MAP_OBJECT )
         << version << minCachedVersion << maxCachedVersion << id
         << object->getMaxVersions() << requestID << _genNextID( _instanceIDs )
         << masterInstanceID << useCache;
@@ -431,10 +617,39 @@ bool ObjectStore::mapObjectSync( const uint32_t requestID )
         return false;
 
     Object* object = LBSAFECAST( Object*, data );
+    MapRetry retry;
+    bool retryable = false;
+    {
+        lunchbox::ScopedFastWrite mutex( _mapRetries );
+        MapRetryHash::iterator i = _mapRetries->find( requestID );
+        if( i != _mapRetries->end( ))
+        {
+            retry = i->second;
+            retryable = true;
+            _mapRetries->erase( i );
+        }
+    }
+
     uint128_t version = VERSION_NONE;
     _localNode->waitRequest( requestID, version );
 
     const bool mapped = object->isAttached();
+    if( !mapped && retryable )
+    {
+        // The failed reply removed the stale directory entry, ask all nodes
+        const NodeID masterID = _findMasterNodeID( retry.id );
+        if( masterID != 0 && masterID != retry.masterID )
+        {
+            LBLOG( LOG_OBJECTS ) << "Retry mapping " << retry.id << " from "
+                                 << masterID << std::endl;
+            NodePtr master = _connectMaster( retry.id, masterID );
+            if( master )
+                return mapObjectSync( _mapObjectNB( object, retry.id,
+                                                    retry.version, master,
+                                                    false ));
+        }
+    }
+
     if( mapped )
         object->applyMapData( version ); // apply initial instance data
 
@@ -443,6 +658,77 @@ bool ObjectStore::mapObjectSync( const uint32_t requestID )
     return mapped;
 }
 
+uint32_t ObjectStore::mapObjectsNB( const Objects& objects,
+                                    const ObjectVersions& versions )
+{
+    LB_TS_NOT_THREAD( _commandThread );
+    LB_TS_NOT_THREAD( _receiverThread );
+    LBASSERTINFO( objects.size() == versions.size(),
+                  objects.size() << " != " << versions.size( ));
+
+    const size_t nObjects = LB_MIN( objects.size(), versions.size( ));
+    UUIDs ids( nObjects );
+    for( size_t i = 0; i < nObjects; ++i )
+        ids[i] = versions[i].identifier;
+
+    UUIDs masterIDs;
+    _findMasterNodeIDs( ids, masterIDs );
+
+    typedef std::map< NodeID, NodePtr > NodeMap;
+    NodeMap masters;
+    std::vector< uint32_t >* requestIDs = new std::vector< uint32_t >;
+    requestIDs->reserve( nObjects );
+    {
+        // send all map requests for one master in a single command
+        CommitBatch batch;
+        for( size_t i = 0; i < nObjects; ++i )
+        {
+            const NodeID& masterID = masterIDs[i];
+            if( masterID == 0 )
+            {
+                LBWARN << "Can't find master node for object id " << ids[i]
+                       << std::endl;
+                requestIDs->push_back( LB_UNDEFINED_UINT32 );
+                continue;
+            }
+
+            NodeMap::iterator j = masters.find( masterID );
+            if( j == masters.end( ))
+                j = masters.insert( std::make_pair( masterID,
+                                   _localNode->connect( masterID ))).first;
+
+            const uint32_t mapID = _mapObjectNB( objects[i], ids[i],
+                                                 versions[i].version,
+                                                 j->second, true );
+            _addMapRetry( mapID, ids[i], versions[i].version, j->second );
+            requestIDs->push_back( mapID );
+        }
+    }
+    return _localNode->registerRequest( requestIDs );
+}
+
+bool ObjectStore::mapObjectsSync( const uint32_t requestID )
+{
+    if( requestID == LB_UNDEFINED_UINT32 )
+        return false;
+
+    std::vector< uint32_t >* requestIDs =
+        static_cast< std::vector< uint32_t >* >(
+            _localNode->getRequestData( requestID ));
+    if( requestIDs == 0 )
+        return false;
+
+    bool mapped = true;
+    for( size_t i = 0; i < requestIDs->size(); ++i )
+        if( !mapObjectSync( (*requestIDs)[i] ))
+            mapped = false;
+
+    _localNode->serveRequest( requestID );
+    _localNode->waitRequest( requestID );
+    delete requestIDs;
+    return mapped;
+}
+
 void ObjectStore::unmapObject( Object* object )
 {
     LBASSERT( object );
@@ -497,6 +783,7 @@ bool ObjectStore::registerObject( Object* object )
     object->setupChangeManager( object->getChangeType(), true, _localNode,
                                 EQ_INSTANCE_INVALID );
     attachObject( object, id, EQ_INSTANCE_INVALID );
+    _setMasterNodeID( id, _localNode->getNodeID( ));
 
     if( Global::getIAttribute( Global::IATTR_NODE_SEND_QUEUE_SIZE ) > 0 )
         _localNode->send( CMD_NODE_REGISTER_OBJECT ) << object;
@@ -527,6 +814,7 @@ void ObjectStore::deregisterObject( Object* object )
     }
 
     const UUID id = object->getID();
+    _removeMasterNodeID( id, NodeID( ));
     detachObject( object );
     object->setupChangeManager( Object::NONE, true, 0, EQ_INSTANCE_INVALID );
     if( _instanceCache )
@@ -543,6 +831,21 @@ NodePtr ObjectStore::_connectMaster( const UUID& id )
         return 0;
     }
 
+    NodePtr master = _connectMaster( id, masterNodeID );
+    if( master )
+        return master;
+
+    // the directory entry may be stale, ask all nodes
+    _removeMasterNodeID( id, masterNodeID );
+    const NodeID newMasterNodeID = _findMasterNodeID( id );
+    if( newMasterNodeID == 0 || newMasterNodeID == masterNodeID )
+        return 0;
+    return _connectMaster( id, newMasterNodeID );
+}
+
+NodePtr ObjectStore::_connectMaster( const UUID& id,
+                                     const NodeID& masterNodeID )
+{
     NodePtr master = _localNode->connect( masterNodeID );
     if( master.isValid() && !master->isClosed( ))
         return master;
@@ -552,6 +855,17 @@ NodePtr ObjectStore::_connectMaster( const UUID& id )
     return 0;
 }
 
+void ObjectStore::_addMapRetry( const uint32_t requestID, const UUID& id,
+                                const uint128_t& version, NodePtr master )
+{
+    if( requestID == LB_UNDEFINED_UINT32 || !master )
+        return;
+
+    const MapRetry retry = { id, version, master->getNodeID() };
+    lunchbox::ScopedFastWrite mutex( _mapRetries );
+    _mapRetries.data[ requestID ] = retry;
+}
+
 bool ObjectStore::notifyCommandThreadIdle()
 {
     LB_TS_THREAD( _commandThread );
@@ -559,6 +873,13 @@ bool ObjectStore::notifyCommandThreadIdle()
         return false;
 
     LBASSERT( _sendOnRegister > 0 );
+    if( _localNode->getMemoryBudget().isUnderPressure( ))
+    {
+        // pushing instance data is speculative, skip it under pressure
+        _sendQueue.clear();
+        return false;
+    }
+
     SendQueueItem& item = _sendQueue.front();
 
     if( item.age > _localNode->getTime64( ))
@@ -639,32 +960,7 @@ bool ObjectStore::_cmdFindMasterNodeID( ICommand& command )
     const uint32_t requestID = command.get< uint32_t >();
     LBASSERT( id.isGenerated() );
 
-    NodeID masterNodeID;
-    {
-        lunchbox::ScopedFastRead mutex( _objects );
-        ObjectsHashCIter i = _objects->find( id );
-
-        if( i != _objects->end( ))
-        {
-            const Objects& objects = i->second;
-            LBASSERT( !objects.empty( ));
-
-            for( ObjectsCIter j = objects.begin(); j != objects.end(); ++j )
-            {
-                Object* object = *j;
-                if( object->isMaster( ))
-                    masterNodeID = _localNode->getNodeID();
-                else
-                {
-                    NodePtr master = object->getMasterNode();
-                    if( master.isValid( ))
-                        masterNodeID = master->getNodeID();
-                }
-                if( masterNodeID != 0 )
-                    break;
-            }
-        }
-    }
+    const NodeID masterNodeID = _findLocalMasterNodeID( id );
 
     LBLOG( LOG_OBJECTS ) << "Object " << id << " master " << masterNodeID
                          << " req " << requestID << std::endl;
@@ -681,6 +977,39 @@ bool ObjectStore::_cmdFindMasterNodeIDReply( ICommand& command )
     return true;
 }
 
+bool ObjectStore::_cmdFindMasterNodeIDs( ICommand& command )
+{
+    LB_TS_THREAD( _commandThread );
+
+    const UUIDs ids = command.get< UUIDs >();
+    const uint32_t requestID = command.get< uint32_t >();
+
+    UUIDs masterIDs;
+    masterIDs.reserve( ids.size( ));
+    for( size_t i = 0; i < ids.size(); ++i )
+        masterIDs.push_back( _findLocalMasterNodeID( ids[i] ));
+
+    LBLOG( LOG_OBJECTS ) << "Found masters of " << ids.size() << " objects"
+                         << " req " << requestID << std::endl;
+    command.getNode()->send( CMD_NODE_FIND_MASTER_NODE_IDS_REPLY )
+            << masterIDs << requestID;
+    return true;
+}
+
+bool ObjectStore::_cmdFindMasterNodeIDsReply( ICommand& command )
+{
+    const UUIDs masterIDs = command.get< UUIDs >();
+    const uint32_t requestID = command.get< uint32_t >();
+
+    UUIDs* result = static_cast< UUIDs* >(
+        _localNode->getRequestData( requestID ));
+    LBASSERT( result );
+    if( result )
+        *result = masterIDs;
+    _localNode->serveRequest( requestID );
+    return true;
+}
+
 bool ObjectStore::_cmdAttachObject( ICommand& command )
 {
     LB_TS_THREAD( _receiverThread );
@@ -781,45 +1110,85 @@ bool ObjectStore::_cmdMapObject( ICommand& cmd )
     LB_TS_THREAD( _commandThread );
 
     MasterCMCommand command( cmd );
-    const UUID& id = command.getObjectID();
-
-    LBLOG( LOG_OBJECTS ) << "Cmd map object " << command << " id " << id << "."
+    LBLOG( LOG_OBJECTS ) << "Cmd map object " << command << " id "
+                         << command.getObjectID() << "."
                          << command.getInstanceID() << " req "
                          << command.getRequestID() << std::endl;
 
-    ObjectCMPtr masterCM;
+    // Coalesce all map requests received until the command thread processes
+    // the flush queued behind them, see _cmdMapObjectFlush()
+    _mapRequests.push_back( cmd );
+    if( _mapRequests.size() > 1 )
+        return true;
+
+    cmd.setDispatchFunction( CmdFunc( this, &ObjectStore::_cmdMapObjectFlush ));
+    _localNode->getCommandThreadQueue()->push( cmd );
+    return true;
+}
+
+bool ObjectStore::_cmdMapObjectFlush( ICommand& )
+{
+    LB_TS_THREAD( _commandThread );
+
+    ICommands requests;
+    requests.swap( _mapRequests );
+
+    // hand all requests for one object at once to its master, which sends
+    // the instance data only once for concurrent requests of one version
+    while( !requests.empty( ))
     {
-        lunchbox::ScopedFastRead mutex( _objects );
-        ObjectsHash::const_iterator i = _objects->find( id );
-        if( i != _objects->end( ))
+        const UUID id = MasterCMCommand( requests.front( )).getObjectID();
+        ICommands objectRequests;
+        for( ICommandsIter i = requests.begin(); i != requests.end(); )
         {
-            const Objects& objects = i->second;
-
-            for( ObjectsCIter j = objects.begin(); j != objects.end(); ++j )
+            if( MasterCMCommand( *i ).getObjectID() == id )
             {
-                Object* object = *j;
-                if( object->isMaster( ))
-                {
-                    masterCM = object->_getChangeManager();
-                    break;
-                }
+                objectRequests.push_back( *i );
+                i = requests.erase( i );
             }
+            else
+                ++i;
+        }
+
+        ObjectCMPtr masterCM = _findMasterCM( id );
+        if( masterCM )
+        {
+            masterCM->addSlaves( objectRequests );
+            continue;
         }
-    }
 
-    if( masterCM )
-        masterCM->addSlave( command );
-    else
-    {
         LBWARN << "Can't find master object to map " << id << std::endl;
-        NodePtr node = command.getNode();
-        node->send( CMD_NODE_MAP_OBJECT_REPLY )
-            << node->getNodeID() << id << command.getRequestedVersion()
-            << command.getRequestID() << false << command.useCache() << false;
+        for( ICommandsCIter i = objectRequests.begin();
+             i != objectRequests.end(); ++i )
+        {
+            MasterCMCommand command( *i );
+            NodePtr node = command.getNode();
+            node->send( CMD_NODE_MAP_OBJECT_REPLY )
+                << node->getNodeID() << id << command.getRequestedVersion()
+                << command.getRequestID() << false << command.useCache()
+                << false;
+        }
     }
     return true;
 }
 
+ObjectCMPtr ObjectStore::_findMasterCM( const UUID& id )
+{
+    lunchbox::ScopedFastRead mutex( _objects );
+    ObjectsHash::const_iterator i = _objects->find( id );
+    if( i == _objects->end( ))
+        return 0;
+
+    const Objects& objects = i->second;
+    for( ObjectsCIter j = objects.begin(); j != objects.end(); ++j )
+    {
+        Object* object = *j;
+        if( object->isMaster( ))
+            return object->_getChangeManager();
+    }
+    return 0;
+}
+
 bool ObjectStore::_cmdMapObjectSuccess( ICommand& command )
 {
     LB_TS_THREAD( _receiverThread );
@@ -830,6 +1199,8 @@ bool ObjectStore::_cmdMapObjectSuccess( ICommand& command )
     const uint32_t instanceID = command.get< uint32_t >();
     const Object::ChangeType changeType = command.get< Object::ChangeType >();
     const uint32_t masterInstanceID = command.get< uint32_t >();
+    const uint128_t firstVersion = command.get< uint128_t >();
+    const uint128_t lastVersion = command.get< uint128_t >();
 
     // Map success commands are potentially multicasted (see above)
     // verify that we are the intended receiver
@@ -849,6 +1220,10 @@ bool ObjectStore::_cmdMapObjectSuccess( ICommand& command )
     object->setupChangeManager( Object::ChangeType( changeType ), false,
                                 _localNode, masterInstanceID );
     _attachObject( object, objectID, instanceID );
+
+    const PendingMap pending = { objectID, instanceID, firstVersion,
+                                 lastVersion };
+    _pendingMaps.push_back( pending );
     return true;
 }
 
@@ -881,7 +1256,19 @@ bool ObjectStore::_cmdMapObjectReply( ICommand& command )
         LBASSERT( object );
         LBASSERT( !object->isMaster( ));
 
+        for( PendingMaps::iterator i = _pendingMaps.begin();
+             i != _pendingMaps.end(); ++i )
+        {
+            if( i->objectID == objectID &&
+                i->instanceID == object->getInstanceID( ))
+            {
+                _pendingMaps.erase( i );
+                break;
+            }
+        }
+
         object->setMasterNode( command.getNode( ));
+        _setMasterNodeID( objectID, command.getNode()->getNodeID( ));
 
         if( useCache )
         {
@@ -906,6 +1293,8 @@ bool ObjectStore::_cmdMapObjectReply( ICommand& command )
         if( releaseCache )
             _instanceCache->release( objectID, 1 );
 
+        // the directory entry which led us here may be stale
+        _removeMasterNodeID( objectID, command.getNode()->getNodeID( ));
         LBWARN << "Could not map object " << objectID << std::endl;
     }
 
@@ -993,6 +1382,12 @@ bool ObjectStore::_cmdInstance( ICommand& inCommand )
     command.setType( COMMANDTYPE_OBJECT );
     command.setCommand( CMD_OBJECT_INSTANCE );
 
+    // Instance data is sent by the master node of the object. Commits go to
+    // mapped slaves only, whose master was recorded when they were mapped.
+    if( cmd != CMD_NODE_OBJECT_INSTANCE_COMMIT )
+        _setMasterNodeID( command.getObjectID(),
+                          command.getNode()->getNodeID( ));
+
     if( _instanceCache )
     {
         const ObjectVersion rev( command.getObjectID(), command.getVersion( ));
@@ -1010,6 +1405,8 @@ bool ObjectStore::_cmdInstance( ICommand& inCommand )
         return true;
 
       case CMD_NODE_OBJECT_INSTANCE_MAP:
+        if( nodeID == 0 ) // for all slaves mapping this version
+            return _dispatchMapData( command );
         if( nodeID != _localNode->getNodeID( )) // not for me
             return true;
 
@@ -1033,6 +1430,35 @@ bool ObjectStore::_cmdInstance( ICommand& inCommand )
     }
 }
 
+bool ObjectStore::_dispatchMapData( ObjectDataICommand& command )
+{
+    LB_TS_THREAD( _receiverThread );
+    const UUID& id = command.getObjectID();
+    const uint128_t& version = command.getVersion();
+
+    ObjectsHash::const_iterator i = _objects->find( id );
+    if( i == _objects->end( ))
+        return true;
+
+    const Objects& objects = i->second;
+    for( PendingMapsCIter j = _pendingMaps.begin(); j != _pendingMaps.end(); ++j)
+    {
+        if( j->objectID != id || version < j->first || version > j->last )
+            continue;
+
+        for( ObjectsCIter k = objects.begin(); k != objects.end(); ++k )
+        {
+            Object* object = *k;
+            if( object->getInstanceID() == j->instanceID )
+            {
+                LBCHECK( object->dispatchCommand( command ));
+                break;
+            }
+        }
+    }
+    return true;
+}
+
 bool ObjectStore::_cmdDisableSendOnRegister( ICommand& command )
 {
     LB_TS_THREAD( _commandThread );
@@ -1061,6 +1487,20 @@ bool ObjectStore::_cmdDisableSendOnRegister( ICommand& command )
     return true;
 }
 
+bool ObjectStore::_cmdCommitObject( ICommand& command )
+{
+    LB_TS_THREAD( _commitThread );
+
+    const uint32_t requestID = command.get< uint32_t >();
+    const uint32_t incarnation = command.get< uint32_t >();
+
+    Object* object = static_cast< Object* >( _localNode->getRequestData(
+                                                 requestID ));
+    LBASSERT( object );
+    _localNode->serveRequest( requestID, object->commit( incarnation ));
+    return true;
+}
+
 bool ObjectStore::_cmdRemoveNode( ICommand& command )
 {
     LB_TS_THREAD( _commandThread );
@@ -34,6 +34,8 @@
 namespace co
 {
     class InstanceCache;
+    class ObjectCM;
+    typedef lunchbox::RefPtr< ObjectCM > ObjectCMPtr;
 
     /** An object store manages Object mapping for a LocalNode. */
     class ObjectStore : public Dispatcher
@@ -96,6 +98,13 @@ namespace co
         /** Finalize the mapping of a distributed object. */
         bool mapObjectSync( const uint32_t requestID );
 
+        /** Start mapping many distributed objects. */
+        uint32_t mapObjectsNB( const Objects& objects,
+                               const ObjectVersions& versions );
+
+        /** Finalize the mapping of many distributed objects. */
+        bool mapObjectsSync( const uint32_t requestID );
+
         /**
          * Unmap a mapped object.
          *
@@ -138,6 +147,24 @@ namespace co
         /** Remove all entries of the node from the cache. */
         void removeInstanceData( const NodeID& nodeID );
 
+        /**
+         * Add a version of a slave object, rebuilt from a binary delta, to the
+         * cache. The data is cached uncompressed, as if sent by the master.
+         */
+        void addInstanceData( const ObjectVersion& rev,
+                              const uint32_t masterInstanceID, NodePtr master,
+                              const lunchbox::Bufferb& data,
+                              const bool compact );
+
+        /**
+         * @return the bytes of instance data held by the cache, including the
+         *         data queued for the cache file.
+         */
+        uint64_t getInstanceDataSize() const;
+
+        /** Release at least size bytes of cached data, if possible. */
+        void shrinkInstanceData( const uint64_t size );
+
         /** Disable the instance cache of an stopped local node. */
         void disableInstanceCache();
 
@@ -181,6 +208,14 @@ namespace co
         typedef stde::hash_map< lunchbox::uint128_t, Objects > ObjectsHash;
         typedef ObjectsHash::const_iterator ObjectsHashCIter;
 
+        typedef stde::hash_map< lunchbox::uint128_t, NodeID > NodeIDHash;
+
+        /** The known master node of object identifiers.
+         *   - written from registration, mapping and instance data traffic
+         *   - locked reads and writes in all threads
+         */
+        lunchbox::Lockable< NodeIDHash, lunchbox::SpinLock > _masterNodeIDs;
+
         /** All registered and mapped objects.
          *   - locked writes (only in receiver thread)
          *   - unlocked reads in receiver thread
@@ -199,6 +234,31 @@ namespace co
         SendQueue _sendQueue;          //!< Object data to broadcast when idle
         InstanceCache* _instanceCache; //!< cached object mapping data
         DataIStreamQueue _pushData;    //!< Object::push() queue
+        ICommands _mapRequests;        //!< Map requests to coalesce
+
+        struct PendingMap //!< A slave waiting for its map data
+        {
+            UUID objectID;
+            uint32_t instanceID;
+            uint128_t first; //!< first version of the map data
+            uint128_t last;  //!< last version of the map data
+        };
+        typedef std::vector< PendingMap > PendingMaps;
+        typedef PendingMaps::const_iterator PendingMapsCIter;
+
+        /** The mappings in progress, receiver thread only. */
+        PendingMaps _pendingMaps;
+
+        struct MapRetry //!< A map request sent to a possibly stale master
+        {
+            UUID id;
+            uint128_t version;
+            NodeID masterID;
+        };
+        typedef stde::hash_map< uint32_t, MapRetry > MapRetryHash;
+
+        /** The map requests to retry with another master if they fail. */
+        lunchbox::Lockable< MapRetryHash, lunchbox::SpinLock > _mapRetries;
 
         /**
          * Returns the master node id for an identifier.
@@ -209,18 +269,65 @@ namespace co
          */
         NodeID _findMasterNodeID( const UUID& id );
 
+        typedef std::vector< UUID > UUIDs;
+
+        /**
+         * Find the master node ids for many identifiers with one query per
+         * node.
+         *
+         * @param ids the identifiers.
+         * @param masterIDs output: the master node id for each identifier, or
+         *                  0 if no master node is found.
+         */
+        void _findMasterNodeIDs( const UUIDs& ids, UUIDs& masterIDs );
+
+        /**
+         * @return the master node id of an object mapped on this node or
+         *         found in the master directory, or 0.
+         */
+        NodeID _findLocalMasterNodeID( const UUID& id );
+
+        /** Record a changed master node of an object in the directory. */
+        void _setMasterNodeID( const UUID& id, const NodeID& nodeID );
+
+        /**
+         * Remove an object from the master directory.
+         *
+         * @param id the object identifier.
+         * @param nodeID the master node to remove, or 0 for any master node.
+         */
+        void _removeMasterNodeID( const UUID& id, const NodeID& nodeID );
+
         NodePtr _connectMaster( const UUID& id );
+        NodePtr _connectMaster( const UUID& id, const NodeID& masterNodeID );
+
+        /** Remember a map request to retry if its master was stale. */
+        void _addMapRetry( const uint32_t requestID, const UUID& id,
+                           const uint128_t& version, NodePtr master );
+
+        uint32_t _mapObjectNB( Object* object, const UUID& id,
+                               const uint128_t& version, NodePtr master,
+                               const bool batch );
 
         void _attachObject( Object* object, const UUID& id,
                             const uint32_t instanceID );
         void _detachObject( Object* object );
 
+        /** @return the change manager of the master instance of an object. */
+        ObjectCMPtr _findMasterCM( const UUID& id );
+
+        /** Dispatch map data sent to multiple slaves to the local ones. */
+        bool _dispatchMapData( ObjectDataICommand& command );
+
         /** The command handler functions. */
         bool _cmdFindMasterNodeID( ICommand& command );
         bool _cmdFindMasterNodeIDReply( ICommand& command );
+        bool _cmdFindMasterNodeIDs( ICommand& command );
+        bool _cmdFindMasterNodeIDsReply( ICommand& command );
         bool _cmdAttachObject( ICommand& command );
         bool _cmdDetachObject( ICommand& command );
         bool _cmdMapObject( ICommand& command );
+        bool _cmdMapObjectFlush( ICommand& command );
         bool _cmdMapObjectSuccess( ICommand& command );
         bool _cmdMapObjectReply( ICommand& command );
         bool _cmdUnmapObject( ICommand& command );
@@ -231,9 +338,11 @@ namespace co
         bool _cmdDisableSendOnRegister( ICommand& command );
         bool _cmdRemoveNode( ICommand& command );
         bool _cmdObjectPush( ICommand& command );
+        bool _cmdCommitObject( ICommand& command );
 
         LB_TS_VAR( _receiverThread );
         LB_TS_VAR( _commandThread );
+        LB_TS_VAR( _commitThread );
     };
 
     std::ostream& operator << ( std::ostream& os, ObjectStore* objectStore );
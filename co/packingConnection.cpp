@@ -0,0 +1,94 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "packingConnection.h"
+
+#include "commands.h"
+
+namespace co
+{
+PackingConnection::PackingConnection( ConnectionPtr connection )
+    : _connection( connection )
+    , _size( 0 )
+    , _received( 0 )
+    , _start( 0 )
+{
+    _setState( STATE_CONNECTED );
+}
+
+PackingConnection::~PackingConnection()
+{
+    _setState( STATE_CLOSED );
+    if( !_buffer.isEmpty( ))
+        LBWARN << "Deleting PackingConnection with buffered data" << std::endl;
+}
+
+void PackingConnection::clear()
+{
+    LBASSERT( isComplete( ));
+    _buffer.setSize( 0 );
+    _start = 0;
+}
+
+int64_t PackingConnection::write( const void* buffer, const uint64_t bytes )
+{
+    const uint8_t* data = static_cast< const uint8_t* >( buffer );
+    uint64_t left = bytes;
+
+    while( left > 0 )
+    {
+        if( _size == 0 ) // read size of next command
+        {
+            const uint64_t nBytes = LB_MIN( sizeof( uint64_t ) - _received,
+                                            left );
+            _buffer.append( data, nBytes );
+            _received += nBytes;
+            data += nBytes;
+            left -= nBytes;
+
+            if( _received == sizeof( uint64_t ))
+            {
+                _size = *reinterpret_cast< const uint64_t* >(
+                    _buffer.getData() + _start );
+                LBASSERT( _size >= sizeof( uint64_t ));
+            }
+            continue;
+        }
+
+        // keep command payload, skip padding
+        const uint64_t total = LB_MAX( _size, uint64_t( COMMAND_MINSIZE ));
+        const uint64_t nBytes = LB_MIN( total - _received, left );
+        if( _received < _size )
+            _buffer.append( data, LB_MIN( _size - _received, nBytes ));
+        _received += nBytes;
+        data += nBytes;
+        left -= nBytes;
+
+        if( _received == total )
+        {
+            _size = 0;
+            _received = 0;
+            _start = _buffer.getSize();
+            notifyCommand();
+        }
+    }
+    return bytes;
+}
+
+}
@@ -0,0 +1,78 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_PACKINGCONNECTION_H
+#define CO_PACKINGCONNECTION_H
+
+#include <co/connection.h> // base class
+#include <lunchbox/buffer.h> // member
+
+namespace co
+{
+    /**
+     * @internal A proxy connection packing the commands written to it.
+     *
+     * The commands are accumulated back-to-back in a memory buffer, dropping
+     * the padding which fills each command up to COMMAND_MINSIZE. The packed
+     * commands are sent to the proxied connection by the subclasses, typically
+     * embedded in a node command.
+     */
+    class PackingConnection : public Connection
+    {
+    public:
+        /** Construct a new packing connection for the given connection. */
+        explicit PackingConnection( ConnectionPtr connection );
+
+        virtual ~PackingConnection();
+
+        /** @return the proxied connection. */
+        ConnectionPtr getConnection() { return _connection; }
+
+    protected:
+        /** @return the packed, complete commands. */
+        lunchbox::Bufferb& getBuffer() { return _buffer; }
+
+        /** @return true if no command is partially written. */
+        bool isComplete() const { return _size == 0 && _received == 0; }
+
+        /** Clear the packed commands. */
+        void clear();
+
+        /** Called after each completely written command. */
+        virtual void notifyCommand() {}
+
+        /** @internal */
+        //@{
+        virtual void readNB( void*, const uint64_t ) { LBDONTCALL; }
+        virtual int64_t readSync( void*, const uint64_t, const bool )
+            { LBDONTCALL; return -1; }
+        virtual int64_t write( const void* buffer, const uint64_t bytes );
+        virtual Notifier getNotifier() const { LBDONTCALL; return 0; }
+        //@}
+
+    private:
+        ConnectionPtr _connection;
+        lunchbox::Bufferb _buffer;
+        uint64_t _size;     //!< size of the current command, 0 if unknown
+        uint64_t _received; //!< bytes received for the current command
+        uint64_t _start;    //!< start of the current command in _buffer
+    };
+}
+
+#endif // CO_PACKINGCONNECTION_H
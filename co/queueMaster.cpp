@@ -119,7 +119,8 @@ void QueueMaster::attach( const UUID& id, const uint32_t instanceID )
     CommandQueue* queue = getLocalNode()->getCommandThreadQueue();
     registerCommand( CMD_QUEUE_GET_ITEM,
                      CommandFunc< detail::QueueMaster >(
-                         _impl, &detail::QueueMaster::cmdGetItem ), queue );
+                         _impl, &detail::QueueMaster::cmdGetItem ), queue,
+                     true );
 }
 
 void QueueMaster::clear()
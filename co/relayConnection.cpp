@@ -0,0 +1,112 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "relayConnection.h"
+
+#include "node.h"
+#include "nodeCommand.h"
+#include "oCommand.h"
+
+namespace co
+{
+RelayConnection::RelayConnection( ConnectionPtr connection,
+                                  const NodeID& originID,
+                                  const uint32_t fanOut,
+                                  const NodeIDs& subtree )
+    : PackingConnection( connection )
+    , _originID( originID )
+    , _fanOut( fanOut )
+    , _subtree( subtree )
+{}
+
+RelayConnection::~RelayConnection()
+{}
+
+void RelayConnection::notifyCommand()
+{
+    lunchbox::Bufferb& buffer = getBuffer();
+    send( getConnection(), _fanOut, _originID, isBigEndian(), 1, _subtree,
+          buffer.getData(), buffer.getSize( ));
+    clear();
+}
+
+void RelayConnection::gather( const Nodes& nodes, const NodeID& originID,
+                              const uint32_t fanOut, Connections& result )
+{
+    LBASSERT( fanOut > 0 );
+    const size_t nGroups = LB_MIN( nodes.size(), size_t( fanOut ));
+
+    for( size_t g = 0; g < nGroups; ++g )
+    {
+        size_t begin = 0;
+        size_t end = 0;
+        getGroup( nodes.size(), nGroups, g, begin, end );
+
+        // the first connected node of the group relays to the others
+        ConnectionPtr connection;
+        for( ; begin < end && !connection; ++begin )
+            connection = nodes[ begin ]->getConnection();
+        if( !connection )
+            continue;
+
+        if( begin == end )
+        {
+            result.push_back( connection );
+            continue;
+        }
+
+        NodeIDs subtree;
+        subtree.reserve( end - begin );
+        for( size_t i = begin; i < end; ++i )
+            subtree.push_back( nodes[ i ]->getNodeID( ));
+
+        result.push_back( new RelayConnection( connection, originID, fanOut,
+                                               subtree ));
+    }
+}
+
+void RelayConnection::send( ConnectionPtr connection, const uint32_t fanOut,
+                            const NodeID& originID, const bool bigEndian,
+                            const uint32_t depth, const NodeIDs& subtree,
+                            const void* data, const uint64_t size )
+{
+    OCommand command( Connections( 1, connection ), CMD_NODE_RELAY );
+    command << fanOut << originID << bigEndian << depth << subtree << size;
+    command.sendHeader( size );
+    connection->send( data, size, true );
+}
+
+void RelayConnection::getGroup( const size_t n, const size_t nGroups,
+                                const size_t g, size_t& begin, size_t& end )
+{
+    LBASSERT( g < nGroups );
+    begin = g * n / nGroups;
+    end = ( g + 1 ) * n / nGroups;
+}
+
+bool RelayConnection::isBigEndian()
+{
+#ifdef COLLAGE_BIGENDIAN
+    return true;
+#else
+    return false;
+#endif
+}
+
+}
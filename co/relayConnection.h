@@ -0,0 +1,112 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_RELAYCONNECTION_H
+#define CO_RELAYCONNECTION_H
+
+#include "packingConnection.h" // base class
+
+namespace co
+{
+    typedef std::vector< NodeID > NodeIDs;
+
+    /**
+     * @internal The max version ack of a slave instance, forwarded to the
+     * master through the relay tree.
+     */
+    struct RelayAck
+    {
+        UUID objectID;
+        NodeID masterID;
+        uint32_t masterInstanceID;
+        NodeID slaveID;
+        uint32_t instanceID;
+        uint64_t maxVersion;
+        uint32_t depth; //!< depth of the node which sent the ack last
+    };
+
+    /**
+     * @internal A proxy connection relaying commit data through a tree of
+     * nodes.
+     *
+     * Each command written to the connection is embedded in a CMD_NODE_RELAY
+     * for the relay node at the other end. The relay dispatches the embedded
+     * commands locally and forwards them to the nodes of its subtree, which
+     * is split into at most fanOut groups, the first node of each group
+     * relaying to the remaining nodes of the group. A relay which can't
+     * reach any node of a group returns the group to the origin, which sends
+     * to its nodes directly.
+     *
+     * Slaves ack their versions to the relay they received the commits from.
+     * The relays coalesce the acks of their subtree and forward them up the
+     * tree, so that the master's commit window covers all relayed slaves.
+     */
+    class RelayConnection : public PackingConnection
+    {
+    public:
+        /**
+         * Construct a new relay connection.
+         *
+         * @param connection the connection to the relay node.
+         * @param originID the identifier of the node sending the commands.
+         * @param fanOut the maximum number of children per relay.
+         * @param subtree the nodes the relay forwards the commands to.
+         */
+        RelayConnection( ConnectionPtr connection, const NodeID& originID,
+                         const uint32_t fanOut, const NodeIDs& subtree );
+        virtual ~RelayConnection();
+
+        /**
+         * Gather the connections to send to the given nodes through relays.
+         *
+         * The nodes are split into at most fanOut groups, each group is
+         * reached through a connection to its first connected node. Groups
+         * reached through their last node use the plain connection.
+         */
+        static void gather( const Nodes& nodes, const NodeID& originID,
+                            const uint32_t fanOut, Connections& result );
+
+        /**
+         * Send a CMD_NODE_RELAY with the given commands to the connection.
+         *
+         * @param depth the depth of the receiving node in the relay tree.
+         */
+        static void send( ConnectionPtr connection, const uint32_t fanOut,
+                          const NodeID& originID, const bool bigEndian,
+                          const uint32_t depth, const NodeIDs& subtree,
+                          const void* data, const uint64_t size );
+
+        /** Compute the range [begin, end) of group g of n items. */
+        static void getGroup( const size_t n, const size_t nGroups,
+                              const size_t g, size_t& begin, size_t& end );
+
+        /** @return true if this process uses big endian byte order. */
+        static bool isBigEndian();
+
+    protected:
+        virtual void notifyCommand();
+
+    private:
+        const NodeID _originID;
+        const uint32_t _fanOut;
+        const NodeIDs _subtree;
+    };
+}
+
+#endif // CO_RELAYCONNECTION_H
@@ -0,0 +1,42 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "sync.h"
+
+#include "object.h"
+#include "syncBatch.h"
+
+namespace co
+{
+void sync( const Objects& objects, const ObjectVersions& versions )
+{
+    LBASSERT( objects.size() == versions.size( ));
+    SyncBatch batch;
+
+    for( size_t i = 0; i < objects.size(); ++i )
+    {
+        Object* object = objects[ i ];
+        const ObjectVersion& ov = versions[ i ];
+        LBASSERT( object->getID() == ov.identifier );
+        LBASSERT( !object->isMaster( ));
+
+        object->sync( ov.version );
+    }
+}
+}
@@ -0,0 +1,45 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_SYNC_H
+#define CO_SYNC_H
+
+#include <co/api.h>
+#include <co/objectVersion.h>
+
+namespace co
+{
+    /**
+     * Sync a set of slave objects to the given versions.
+     *
+     * Each object is synced to the version of the corresponding entry in
+     * versions, which may also be VERSION_HEAD to apply all received versions.
+     * The version acknowledgements needed for the master's flow control are
+     * sent once per object and bundled into one command per master node, and
+     * the pending commands of the local node are flushed only once.
+     *
+     * @param objects the slave objects to sync.
+     * @param versions the versions to sync to, in the order of the objects.
+     * @sa Object::sync()
+     * @version 1.0
+     */
+    CO_API void sync( const Objects& objects, const ObjectVersions& versions );
+}
+
+#endif // CO_SYNC_H
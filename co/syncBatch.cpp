@@ -0,0 +1,137 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "syncBatch.h"
+
+#include "commitBatch.h"
+#include "localNode.h"
+#include "object.h"
+#include "objectICommand.h"
+#include "objectOCommand.h"
+
+#include <lunchbox/perThread.h>
+#include <lunchbox/stdExt.h>
+
+namespace co
+{
+namespace
+{
+struct Ack
+{
+    LocalNodePtr localNode;
+    NodePtr master;
+    UUID id;
+    uint32_t masterInstanceID;
+    uint32_t instanceID;
+    uint64_t maxVersion;
+};
+
+typedef stde::hash_map< const Object*, Ack > Acks;
+typedef Acks::const_iterator AcksCIter;
+
+lunchbox::PerThread< detail::SyncBatch,
+                     lunchbox::perThreadNoDelete< detail::SyncBatch > >
+    _current;
+}
+
+namespace detail
+{
+class SyncBatch
+{
+public:
+    void send()
+    {
+        // coalesces the acks into one command per master connection
+        co::CommitBatch batch;
+
+        for( AcksCIter i = acks.begin(); i != acks.end(); ++i )
+        {
+            const Ack& ack = i->second;
+            if( ack.localNode->sendRelayAck( ack.id, ack.master,
+                                             ack.masterInstanceID,
+                                             ack.instanceID, ack.maxVersion ))
+            {
+                continue;
+            }
+
+            ConnectionPtr connection = ack.master->getConnection();
+            if( !connection )
+                continue;
+
+            Connections connections( 1, connection );
+            co::CommitBatch::substitute( connections );
+            ObjectOCommand( connections, CMD_OBJECT_MAX_VERSION,
+                            COMMANDTYPE_OBJECT, ack.id, ack.masterInstanceID )
+                << ack.maxVersion << ack.instanceID;
+        }
+        acks.clear();
+    }
+
+    Acks acks;
+    LocalNodePtr localNode; //!< the node to flush, if any
+};
+}
+
+SyncBatch::SyncBatch()
+    : _impl( _current.get() ? 0 : new detail::SyncBatch )
+{
+    if( _impl )
+        _current = _impl;
+}
+
+SyncBatch::~SyncBatch()
+{
+    if( !_impl )
+        return;
+
+    _current = 0;
+    _impl->send();
+    if( _impl->localNode )
+        _impl->localNode->flushCommands();
+    delete _impl;
+}
+
+bool SyncBatch::addAck( Object* object, NodePtr master,
+                        const uint32_t masterInstanceID,
+                        const uint64_t maxVersion )
+{
+    detail::SyncBatch* batch = _current.get();
+    if( !batch )
+        return false;
+
+    Ack& ack = batch->acks[ object ];
+    ack.localNode = object->getLocalNode();
+    ack.master = master;
+    ack.id = object->getID();
+    ack.masterInstanceID = masterInstanceID;
+    ack.instanceID = object->getInstanceID();
+    ack.maxVersion = maxVersion;
+    return true;
+}
+
+void SyncBatch::flushCommands( LocalNodePtr node )
+{
+    detail::SyncBatch* batch = _current.get();
+    if( batch )
+        batch->localNode = node;
+    else
+        node->flushCommands();
+}
+
+}
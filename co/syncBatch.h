@@ -0,0 +1,73 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_SYNCBATCH_H
+#define CO_SYNCBATCH_H
+
+#include <co/api.h>
+#include <co/types.h>
+#include <lunchbox/nonCopyable.h>
+
+namespace co
+{
+namespace detail { class SyncBatch; }
+
+    /**
+     * @internal Coalesces the version acknowledgements of many slave syncs.
+     *
+     * While a sync batch is active, the max version acknowledgements of all
+     * slave objects synced by the same thread are collected, keeping only the
+     * latest one per object. On destruction, they are sent using one command
+     * per master connection, and the local node's commands are flushed once.
+     *
+     * Batches do not nest; a batch constructed while another one is active in
+     * the same thread is inactive.
+     */
+    class SyncBatch : public lunchbox::NonCopyable
+    {
+    public:
+        /** Activate a new batch for the calling thread. */
+        CO_API SyncBatch();
+
+        /** Send the collected acknowledgements and deactivate the batch. */
+        CO_API ~SyncBatch();
+
+        /**
+         * Collect the max version acknowledgement of a slave object in the
+         * batch active in the calling thread.
+         *
+         * @return true if the acknowledgement was collected, false if no batch
+         *         is active.
+         */
+        static bool addAck( Object* object, NodePtr master,
+                            const uint32_t masterInstanceID,
+                            const uint64_t maxVersion );
+
+        /**
+         * Flush the commands of the given node, or defer the flush to the end
+         * of the batch active in the calling thread.
+         */
+        static void flushCommands( LocalNodePtr node );
+
+    private:
+        detail::SyncBatch* const _impl;
+    };
+}
+
+#endif // CO_SYNCBATCH_H
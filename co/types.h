@@ -136,6 +136,8 @@ typedef ICommands::const_iterator                  ICommandsCIter;
 /** @cond IGNORE */
 class BufferListener;
 class MasterCMCommand;
+class MasterHistory;
+class MemoryBudget;
 
 typedef lunchbox::RefPtr< Buffer > BufferPtr;
 typedef lunchbox::RefPtr< const Buffer > ConstBufferPtr;
@@ -144,6 +146,7 @@ typedef std::vector< ObjectVersion > ObjectVersions;
 typedef ObjectVersions::const_iterator ObjectVersionsCIter;
 typedef std::deque< ObjectDataIStream* > ObjectDataIStreamDeque;
 typedef std::vector< ObjectDataIStream* > ObjectDataIStreams;
+typedef ObjectDataIStreams::const_iterator ObjectDataIStreamsCIter;
 /** @endcond */
 
 #ifndef EQ_2_0_API
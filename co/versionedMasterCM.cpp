@@ -44,6 +44,9 @@ VersionedMasterCM::VersionedMasterCM( Object* object )
     object->registerCommand( CMD_OBJECT_DELTA,
                              CmdFunc( this, &VersionedMasterCM::_cmdDiscard ),
                              0 );
+    object->registerCommand( CMD_OBJECT_INSTANCE_DELTA,
+                             CmdFunc( this, &VersionedMasterCM::_cmdDiscard ),
+                             0 );
 
     object->registerCommand( CMD_OBJECT_SLAVE_DELTA,
                             CmdFunc( this, &VersionedMasterCM::_cmdSlaveDelta ),
@@ -51,6 +54,9 @@ VersionedMasterCM::VersionedMasterCM( Object* object )
     object->registerCommand( CMD_OBJECT_MAX_VERSION,
                             CmdFunc( this, &VersionedMasterCM::_cmdMaxVersion ),
                              0 );
+    object->registerCommand( CMD_OBJECT_RELAY_MAX_VERSION,
+                       CmdFunc( this, &VersionedMasterCM::_cmdRelayMaxVersion ),
+                             0 );
 }
 
 VersionedMasterCM::~VersionedMasterCM()
@@ -106,6 +112,22 @@ void VersionedMasterCM::addSlave( MasterCMCommand command )
     LB_TS_THREAD( _cmdThread );
     Mutex mutex( _slaves );
 
+    _addSlaveData( command );
+    ObjectCM::_addSlave( command, _version );
+}
+
+void VersionedMasterCM::addSlaves( const ICommands& commands )
+{
+    LB_TS_THREAD( _cmdThread );
+    Mutex mutex( _slaves );
+
+    for( ICommandsCIter i = commands.begin(); i != commands.end(); ++i )
+        _addSlaveData( MasterCMCommand( *i ));
+    ObjectCM::_addSlaves( commands, _version );
+}
+
+void VersionedMasterCM::_addSlaveData( const MasterCMCommand& command )
+{
     SlaveData data;
     data.node = command.getNode();
     data.instanceID = command.getInstanceID();
@@ -120,8 +142,6 @@ void VersionedMasterCM::addSlave( MasterCMCommand command )
 
     _slaves->push_back( data.node );
     stde::usort( *_slaves );
-
-    ObjectCM::_addSlave( command, _version );
 }
 
 void VersionedMasterCM::removeSlave( NodePtr node, const uint32_t instanceID )
@@ -169,6 +189,26 @@ void VersionedMasterCM::removeSlaves( NodePtr node )
     _updateMaxVersion();
 }
 
+bool VersionedMasterCM::canRelay( NodePtr node ) const
+{
+    // Only slaves which have applied their map data may receive relayed
+    // commits, which could otherwise overtake the map data. The master's own
+    // node never relays.
+    if( node->getNodeID() == getLocalNodeID( ))
+        return false;
+
+    bool found = false;
+    for( SlaveDatasCIter i = _slaveData.begin(); i != _slaveData.end(); ++i )
+    {
+        if( i->node != node )
+            continue;
+        if( !i->acked )
+            return false;
+        found = true;
+    }
+    return found;
+}
+
 void VersionedMasterCM::_updateMaxVersion()
 {
     uint64_t maxVersion = std::numeric_limits< uint64_t >::max();
@@ -205,22 +245,40 @@ bool VersionedMasterCM::_cmdMaxVersion( ICommand& cmd )
     const uint64_t version = command.get< uint64_t >();
     const uint32_t slaveID = command.get< uint32_t >();
 
+    _setMaxVersion( command.getNode()->getNodeID(), slaveID, version );
+    return true;
+}
+
+bool VersionedMasterCM::_cmdRelayMaxVersion( ICommand& cmd )
+{
+    // sent by the relay closest to the master on behalf of the slave node
+    ObjectICommand command( cmd );
+    const uint64_t version = command.get< uint64_t >();
+    const uint32_t slaveID = command.get< uint32_t >();
+    const NodeID nodeID = command.get< NodeID >();
+
+    _setMaxVersion( nodeID, slaveID, version );
+    return true;
+}
+
+void VersionedMasterCM::_setMaxVersion( const NodeID& nodeID,
+                                        const uint32_t instanceID,
+                                        const uint64_t version )
+{
     Mutex mutex( _slaves );
 
     // Update slave's max version
-    SlaveData data;
-    data.node = command.getNode();
-    data.instanceID = slaveID;
-    SlaveDatasIter i = stde::find( _slaveData, data );
-    if( i == _slaveData.end( ))
+    for( SlaveDatasIter i = _slaveData.begin(); i != _slaveData.end(); ++i )
     {
-        LBWARN << "Got max version from unmapped slave" << std::endl;
-        return true;
-    }
-    i->maxVersion = version;
+        if( i->instanceID != instanceID || i->node->getNodeID() != nodeID )
+            continue;
 
-    _updateMaxVersion();
-    return true;
+        i->maxVersion = version;
+        i->acked = true;
+        _updateMaxVersion();
+        return;
+    }
+    LBWARN << "Got max version from unmapped slave" << std::endl;
 }
 
 }
@@ -62,10 +62,12 @@ namespace co
             { LBDONTCALL; return EQ_INSTANCE_INVALID; }
 
         virtual void addSlave( MasterCMCommand command );
+        virtual void addSlaves( const ICommands& commands );
         virtual void removeSlave( NodePtr node, const uint32_t instanceID );
         virtual void removeSlaves( NodePtr node );
         virtual const Nodes getSlaveNodes() const
             { Mutex mutex( _slaves ); return *_slaves; }
+        virtual bool canRelay( NodePtr node ) const;
 
     protected:
         /** The list of subscribed slave nodes. */
@@ -81,13 +83,14 @@ namespace co
         struct SlaveData
         {
             SlaveData() : maxVersion( std::numeric_limits< uint64_t >::max( ))
-                        , instanceID( LB_UNDEFINED_UINT32 ) {}
+                        , instanceID( LB_UNDEFINED_UINT32 ), acked( false ) {}
             bool operator == ( const SlaveData& rhs ) const
                 { return node == rhs.node && instanceID == rhs.instanceID; }
 
             NodePtr node;
             uint64_t maxVersion;
             uint32_t instanceID;
+            bool acked; //!< slave has applied the map data
         };
         typedef std::vector< SlaveData > SlaveDatas;
         typedef SlaveDatas::const_iterator SlaveDatasCIter;
@@ -100,11 +103,15 @@ namespace co
         DataIStreamQueue _slaveCommits;
 
         uint128_t _apply( ObjectDataIStream* is );
+        void _addSlaveData( const MasterCMCommand& command );
         void _updateMaxVersion();
+        void _setMaxVersion( const NodeID& nodeID, const uint32_t instanceID,
+                             const uint64_t version );
 
         /* The command handlers. */
         bool _cmdSlaveDelta( ICommand& command );
         bool _cmdMaxVersion( ICommand& command );
+        bool _cmdRelayMaxVersion( ICommand& command );
         bool _cmdDiscard( ICommand& ) { return true; }
 
         LB_TS_VAR( _cmdThread );
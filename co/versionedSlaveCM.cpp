@@ -20,11 +20,18 @@
 
 #include "versionedSlaveCM.h"
 
+#include "bufferDelta.h"
+#include "global.h"
+#include "localNode.h"
 #include "log.h"
+#include "memoryBudget.h"
 #include "object.h"
 #include "objectDataICommand.h"
 #include "objectDataIStream.h"
 #include "objectDataOCommand.h"
+#include "syncBatch.h"
+
+#include <lunchbox/plugins/compressor.h>
 #include <lunchbox/scopedMutex.h>
 #include <limits>
 
@@ -32,15 +39,58 @@ namespace co
 {
 typedef CommandFunc< VersionedSlaveCM > CmdFunc;
 
+namespace
+{
+/** Reads the instance data retained by the slave for delta decoding. */
+class RetainedIStream : public DataIStream
+{
+public:
+    RetainedIStream( const lunchbox::Bufferb& data, ObjectDataIStream& from )
+        : DataIStream( from.isSwapping( ))
+        , _data( &data )
+        , _from( from )
+        , _compact( from.isCompact( ))
+    {}
+
+    virtual size_t nRemainingBuffers() const { return _data ? 1 : 0; }
+    virtual uint128_t getVersion() const { return _from.getVersion(); }
+    virtual NodePtr getMaster() { return _from.getMaster(); }
+
+protected:
+    virtual bool getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
+                                const void** chunkData, uint64_t& size )
+    {
+        if( !_data || _data->isEmpty( ))
+            return false;
+
+        compressor = EQ_COMPRESSOR_NONE;
+        nChunks = 1;
+        *chunkData = _data->getData();
+        size = _data->getSize();
+        setCompact( _compact );
+        _data = 0;
+        return true;
+    }
+
+private:
+    const lunchbox::Bufferb* _data;
+    ObjectDataIStream& _from;
+    const bool _compact;
+};
+}
+
 VersionedSlaveCM::VersionedSlaveCM( Object* object, uint32_t masterInstanceID )
         : ObjectCM( object )
         , _version( VERSION_NONE )
-        , _currentIStream( 0 )
+        , _queuedHead( VERSION_NONE )
         , _masterInstanceID( masterInstanceID )
 #pragma warning(push)
 #pragma warning(disable: 4355)
         , _ostream( this )
 #pragma warning(pop)
+        , _localNode( object->getLocalNode( ))
+        , _throttled( 0 )
+        , _retainedSize( 0 )
 {
     LBASSERT( object );
 
@@ -48,16 +98,37 @@ VersionedSlaveCM::VersionedSlaveCM( Object* object, uint32_t masterInstanceID )
                              CmdFunc( this, &VersionedSlaveCM::_cmdData ), 0 );
     object->registerCommand( CMD_OBJECT_DELTA,
                              CmdFunc( this, &VersionedSlaveCM::_cmdData ), 0 );
+    object->registerCommand( CMD_OBJECT_INSTANCE_DELTA,
+                             CmdFunc( this, &VersionedSlaveCM::_cmdData ), 0 );
 }
 
 VersionedSlaveCM::~VersionedSlaveCM()
 {
     while( !_queuedVersions.isEmpty( ))
-        delete _queuedVersions.pop();
+    {
+        ObjectDataIStream* is = _popVersion();
+        _releaseBuffer( is );
+        delete is;
+    }
+
+    LBASSERT( _currentIStreams.empty( ));
+    for( VersionIStreamsCIter i = _currentIStreams.begin();
+         i != _currentIStreams.end(); ++i )
+    {
+        _releaseBuffer( i->second );
+        delete i->second;
+    }
+    _currentIStreams.clear();
 
-    LBASSERT( !_currentIStream );
-    delete _currentIStream;
-    _currentIStream = 0;
+    for( VersionIStreamsCIter i = _pendingIStreams.begin();
+         i != _pendingIStreams.end(); ++i )
+    {
+        _releaseBuffer( i->second );
+        delete i->second;
+    }
+    _pendingIStreams.clear();
+    _localNode->getMemoryBudget().remove( MemoryBudget::SLAVE_DATA,
+                                          _retainedSize );
 
     _version = VERSION_NONE;
     _master = 0;
@@ -101,12 +172,13 @@ uint128_t VersionedSlaveCM::sync( const uint128_t& v )
                   lunchbox::className( _object ) << " " << _object->getID() <<
                   " (" << _version << ", " << version <<")" );
 
+    _unpackReadyVersions( version );
     while( _version < version )
-        _unpackOneVersion( _queuedVersions.pop( ));
+        _unpackOneVersion( _popVersion( ));
 
     LocalNodePtr node = _object->getLocalNode();
     if( node.isValid( ))
-        node->flushCommands();
+        SyncBatch::flushCommands( node );
 
     return _version;
 }
@@ -116,17 +188,56 @@ void VersionedSlaveCM::_syncToHead()
     if( _queuedVersions.isEmpty( ))
         return;
 
-    ObjectDataIStream* is = 0;
-    while( _queuedVersions.tryPop( is ))
-        _unpackOneVersion( is );
+    _unpackReadyVersions( VERSION_HEAD );
 
     LocalNodePtr localNode = _object->getLocalNode();
     if( localNode.isValid( ))
-        localNode->flushCommands();
+        SyncBatch::flushCommands( localNode );
+}
+
+void VersionedSlaveCM::_unpackReadyVersions( const uint128_t& version )
+{
+    ObjectDataIStreams streams;
+    ObjectDataIStream* is = 0;
+    while( _queuedVersions.tryPop( is ))
+    {
+        if( is->getVersion() > version )
+        {
+            _queuedVersions.pushFront( is );
+            break;
+        }
+        _removeQueued( is );
+        streams.push_back( is );
+    }
+
+    // Full instance data supersedes all previous versions, skip them
+    ObjectDataIStreamsCIter first = streams.begin();
+    for( ObjectDataIStreamsCIter i = streams.end(); i != streams.begin(); )
+    {
+        --i;
+        if( (*i)->hasInstanceData( ))
+        {
+            first = i;
+            break;
+        }
+    }
+
+    for( ObjectDataIStreamsCIter i = streams.begin(); i != first; ++i )
+        _releaseStream( *i );
+    if( first != streams.begin( ))
+    {
+        LBLOG( LOG_OBJECTS ) << "Skip " << first - streams.begin()
+                             << " versions of " << *_object << std::endl;
+        _version = (*first)->getVersion() - 1;
+    }
+
+    for( ObjectDataIStreamsCIter i = first; i != streams.end(); ++i )
+        _unpackOneVersion( *i );
 }
 
 void VersionedSlaveCM::_releaseStream( ObjectDataIStream* stream )
 {
+    _releaseBuffer( stream );
 #ifdef CO_AGGRESSIVE_CACHING
     stream->reset();
     _iStreamCache.release( stream );
@@ -135,6 +246,16 @@ void VersionedSlaveCM::_releaseStream( ObjectDataIStream* stream )
 #endif
 }
 
+void VersionedSlaveCM::_releaseBuffer( ObjectDataIStream* stream )
+{
+    lunchbox::Bufferb* buffer = stream->getDecompressionBuffer();
+    if( !buffer )
+        return;
+
+    stream->setDecompressionBuffer( 0 );
+    _bufferCache.release( buffer );
+}
+
 uint128_t VersionedSlaveCM::getHeadVersion() const
 {
     ObjectDataIStream* is = 0;
@@ -153,8 +274,10 @@ void VersionedSlaveCM::_unpackOneVersion( ObjectDataIStream* is )
                   << _version + 1 << ", got " << is->getVersion() << " for "
                   << *_object );
 
-    if( is->hasInstanceData( ))
-        _object->applyInstanceData( *is );
+    if( is->hasInstanceDelta( ))
+        _applyInstanceDelta( *is );
+    else if( is->hasInstanceData( ))
+        _applyInstanceData( *is );
     else
         _object->unpack( *is );
 
@@ -177,25 +300,137 @@ void VersionedSlaveCM::_unpackOneVersion( ObjectDataIStream* is )
 
 void VersionedSlaveCM::_sendAck()
 {
-    const uint64_t maxVersion = _version.low() + _object->getMaxVersions();
-    if( maxVersion <= _version.low( )) // overflow: default unblocking commit
+    uint64_t maxVersion = _version.low() + _object->getMaxVersions();
+    if( maxVersion <= _version.low( )) // overflow: unblocking commit
+        maxVersion = std::numeric_limits< uint64_t >::max();
+
+    if( _localNode->getMemoryBudget().isUnderPressure( ))
+    {
+        // back pressure: let the master commit only one version ahead
+        maxVersion = LB_MIN( maxVersion, _version.low() + 1 );
+        _throttled = 1;
+    }
+    else if( maxVersion == std::numeric_limits< uint64_t >::max( ))
+    {
+        if( !_throttled ) // default unblocking commit
+            return;
+        _throttled = 0; // release the master
+    }
+    else
+        _throttled = 0;
+
+    _sendMaxVersion( maxVersion );
+}
+
+void VersionedSlaveCM::_sendMaxVersion( const uint64_t maxVersion )
+{
+    if( SyncBatch::addAck( _object, _master, _masterInstanceID, maxVersion ))
+        return;
+    if( _localNode->sendRelayAck( _object->getID(), _master, _masterInstanceID,
+                                  _object->getInstanceID(), maxVersion ))
+    {
+        return;
+    }
+
+    _object->send( _master, CMD_OBJECT_MAX_VERSION, _masterInstanceID )
+            << maxVersion << _object->getInstanceID();
+}
+
+void VersionedSlaveCM::_sendMapAck()
+{
+    // The master relays commits only to slaves which acked their map data
+    if( Global::getIAttribute( Global::IATTR_OBJECT_RELAY_FANOUT ) <= 0 ||
+        !_master )
+    {
         return;
+    }
+
+    uint64_t maxVersion = _version.low() + _object->getMaxVersions();
+    if( maxVersion <= _version.low( ))
+        maxVersion = std::numeric_limits< uint64_t >::max();
 
     _object->send( _master, CMD_OBJECT_MAX_VERSION, _masterInstanceID )
             << maxVersion << _object->getInstanceID();
 }
 
+void VersionedSlaveCM::_applyInstanceData( ObjectDataIStream& is )
+{
+    if( _object->getChangeType() != Object::INSTANCE )
+    {
+        _object->applyInstanceData( is );
+        return;
+    }
+
+    // only the FullMasterCM of INSTANCE objects sends deltas
+    _instanceData.setSize( 0 );
+    while( is.hasData( ))
+    {
+        const uint64_t size = is.getRemainingBufferSize();
+        const void* data = is.getRemainingBuffer( size );
+        _instanceData.append( static_cast< const uint8_t* >( data ), size );
+    }
+    _updateRetainedSize();
+    _applyRetainedData( is );
+}
+
+void VersionedSlaveCM::_applyInstanceDelta( ObjectDataIStream& is )
+{
+    LBASSERT( _object->getChangeType() == Object::INSTANCE );
+
+    is >> _instanceDelta;
+    if( !applyDelta( _instanceData, _instanceDelta.getData(),
+                     _instanceDelta.getSize( )))
+    {
+        LBERROR << "Malformed instance delta for v" << is.getVersion()
+                << " of " << *_object << std::endl;
+        _instanceData.setSize( 0 );
+        return;
+    }
+    _updateRetainedSize();
+
+    // The master sent no instance data for the cache, add the rebuilt one.
+    // It is in the byte order of the master, which a local command can't have
+    if( !is.isSwapping( ))
+        _localNode->addInstanceData( ObjectVersion( _object->getID(),
+                                                    is.getVersion( )),
+                                     _masterInstanceID, _master, _instanceData,
+                                     is.isCompact( ));
+    _applyRetainedData( is );
+}
+
+void VersionedSlaveCM::_applyRetainedData( ObjectDataIStream& is )
+{
+    RetainedIStream stream( _instanceData, is );
+    _object->applyInstanceData( stream );
+    LBASSERTINFO( !stream.hasData( ), lunchbox::className( _object ) <<
+                  " did not unpack all data" );
+}
+
+void VersionedSlaveCM::_updateRetainedSize()
+{
+    const uint64_t size = _instanceData.getMaxSize() +
+                          _instanceDelta.getMaxSize();
+    MemoryBudget& budget = _localNode->getMemoryBudget();
+    if( size > _retainedSize )
+        budget.add( MemoryBudget::SLAVE_DATA, size - _retainedSize );
+    else
+        budget.remove( MemoryBudget::SLAVE_DATA, _retainedSize - size );
+    _retainedSize = size;
+}
+
 void VersionedSlaveCM::applyMapData( const uint128_t& version )
 {
     while( true )
     {
-        ObjectDataIStream* is = _queuedVersions.pop();
+        ObjectDataIStream* is = _popVersion();
         if( is->getVersion() == version )
         {
             LBASSERTINFO( is->hasInstanceData(), *_object );
 
             if( is->hasData( )) // not VERSION_NONE
-                _object->applyInstanceData( *is );
+                _applyInstanceData( *is );
+            else
+                _instanceData.setSize( 0 );
             _version = is->getVersion();
 
             LBASSERT( _version != VERSION_INVALID );
@@ -206,6 +441,7 @@ void VersionedSlaveCM::applyMapData( const uint128_t& version )
                           is->nRemainingBuffers() << " buffer(s)" );
 
             _releaseStream( is );
+            _sendMapAck();
 #if 0
             LBLOG( LOG_OBJECTS ) << "Mapped initial data of " << _object
                                  << std::endl;
@@ -283,7 +519,9 @@ void VersionedSlaveCM::addInstanceDatas( const ObjectDataIStreamDeque& cache,
         if( debugStream )
             LBASSERT( debugStream->getVersion() == stream->getVersion() + 1);
 #endif
-        _queuedVersions.pushFront( new ObjectDataIStream( *stream ));
+        ObjectDataIStream* copy = new ObjectDataIStream( *stream );
+        _addQueued( copy );
+        _queuedVersions.pushFront( copy );
 #if 0
         LBLOG( LOG_OBJECTS ) << stream->getVersion() << ' ';
 #endif
@@ -304,7 +542,11 @@ void VersionedSlaveCM::addInstanceDatas( const ObjectDataIStreamDeque& cache,
             LBASSERT( debugStream->getVersion() + 1 == stream->getVersion( ));
         }
 #endif
-        _queuedVersions.push( new ObjectDataIStream( *stream ));
+        ObjectDataIStream* copy = new ObjectDataIStream( *stream );
+        _addQueued( copy );
+        _queuedVersions.push( copy );
+        if( stream->getVersion() > _queuedHead )
+            _queuedHead = stream->getVersion();
 #if 0
         LBLOG( LOG_OBJECTS ) << stream->getVersion() << ' ';
 #endif
@@ -314,6 +556,80 @@ void VersionedSlaveCM::addInstanceDatas( const ObjectDataIStreamDeque& cache,
 #endif
 }
 
+void VersionedSlaveCM::_queueVersion( ObjectDataIStream* is )
+{
+    LB_TS_THREAD( _rcvThread );
+    const uint128_t& version = is->getVersion();
+
+    // commits relayed through other slaves may overtake direct ones
+    if( _queuedHead != VERSION_NONE && version > _queuedHead + 1 )
+    {
+        LBASSERT( _pendingIStreams.find( version ) == _pendingIStreams.end( ));
+        _pendingIStreams[ version ] = is;
+        return;
+    }
+
+    _pushVersion( is );
+    while( !_pendingIStreams.empty() &&
+           _pendingIStreams.begin()->first == _queuedHead + 1 )
+    {
+        is = _pendingIStreams.begin()->second;
+        _pendingIStreams.erase( _pendingIStreams.begin( ));
+        _pushVersion( is );
+    }
+}
+
+void VersionedSlaveCM::_pushVersion( ObjectDataIStream* is )
+{
+    const uint128_t version = is->getVersion();
+#if 0
+    LBLOG( LOG_OBJECTS ) << "v" << version << ", id " << _object->getID()
+                         << "." << _object->getInstanceID() << " ready"
+                         << std::endl;
+#endif
+#ifndef NDEBUG
+    ObjectDataIStream* debugStream = 0;
+    _queuedVersions.getBack( debugStream );
+    if ( debugStream )
+    {
+        LBASSERT( debugStream->getVersion() + 1 == version );
+    }
+#endif
+    _addQueued( is );
+    if( _master && _version != VERSION_NONE && // mapped
+        _localNode->getMemoryBudget().isUnderPressure( ))
+    {
+        // Back pressure for slaves not syncing: stop the master at this
+        // version, before the application may ack it.
+        _throttled = 1;
+        _sendMaxVersion( version.low( ));
+    }
+
+    _queuedVersions.push( is );
+    if( version > _queuedHead )
+        _queuedHead = version;
+    _object->notifyNewHeadVersion( version );
+}
+
+void VersionedSlaveCM::_addQueued( const ObjectDataIStream* is )
+{
+    _localNode->getMemoryBudget().add( MemoryBudget::SLAVE_QUEUES,
+                                       is->getDataSize( ));
+}
+
+void VersionedSlaveCM::_removeQueued( const ObjectDataIStream* is )
+{
+    _localNode->getMemoryBudget().remove( MemoryBudget::SLAVE_QUEUES,
+                                          is->getDataSize( ));
+}
+
+ObjectDataIStream* VersionedSlaveCM::_popVersion()
+{
+    ObjectDataIStream* is = _queuedVersions.pop();
+    _removeQueued( is );
+    return is;
+}
+
 //---------------------------------------------------------------------------
 // command handlers
 //---------------------------------------------------------------------------
@@ -324,29 +640,19 @@ bool VersionedSlaveCM::_cmdData( ICommand& cmd )
     LB_TS_THREAD( _rcvThread );
     LBASSERT( command.getNode().isValid( ));
 
-    if( !_currentIStream )
-        _currentIStream = _iStreamCache.alloc();
+    ObjectDataIStream*& current = _currentIStreams[ command.getVersion() ];
+    if( !current )
+    {
+        current = _iStreamCache.alloc();
+        current->setDecompressionBuffer( _bufferCache.alloc( ));
+    }
 
-    _currentIStream->addDataCommand( command );
-    if( _currentIStream->isReady( ))
+    ObjectDataIStream* is = current;
+    is->addDataCommand( command );
+    if( is->isReady( ))
     {
-        const uint128_t& version = _currentIStream->getVersion();
-#if 0
-        LBLOG( LOG_OBJECTS ) << "v" << version << ", id " << _object->getID()
-                             << "." << _object->getInstanceID() << " ready"
-                             << std::endl;
-#endif
-#ifndef NDEBUG
-        ObjectDataIStream* debugStream = 0;
-        _queuedVersions.getBack( debugStream );
-        if ( debugStream )
-        {
-            LBASSERT( debugStream->getVersion() + 1 == version );
-        }
-#endif
-        _queuedVersions.push( _currentIStream );
-        _object->notifyNewHeadVersion( version );
-        _currentIStream = 0;
+        _currentIStreams.erase( is->getVersion( ));
+        _queueVersion( is );
     }
     return true;
 }
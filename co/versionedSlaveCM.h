@@ -25,10 +25,14 @@
 #include "objectDataIStream.h"      // member
 #include "objectSlaveDataOStream.h" // member
 
+#include <lunchbox/atomic.h>      // member
+#include <lunchbox/buffer.h>      // member
 #include <lunchbox/mtQueue.h>     // member
 #include <lunchbox/pool.h>        // member
 #include <lunchbox/thread.h>      // thread-safety macro
 
+#include <map>
+
 namespace co
 {
     class Node;
@@ -71,8 +75,20 @@ namespace co
         /** The current version. */
         uint128_t _version;
 
-        /** istream for receiving the current version */
-        ObjectDataIStream* _currentIStream;
+        typedef std::map< uint128_t, ObjectDataIStream* > VersionIStreams;
+        typedef VersionIStreams::const_iterator VersionIStreamsCIter;
+
+        /**
+         * istreams for receiving the current versions. Relayed commits may
+         * interleave with directly sent ones.
+         */
+        VersionIStreams _currentIStreams;
+
+        /** Ready versions waiting for a preceding, slower relayed version. */
+        VersionIStreams _pendingIStreams;
+
+        /** The newest version queued by the receiver thread. */
+        uint128_t _queuedHead;
 
         /** The change queue. */
         lunchbox::MTQueue< ObjectDataIStream* > _queuedVersions;
@@ -80,6 +96,9 @@ namespace co
         /** Cached input streams (+decompressor) */
         lunchbox::Pool< ObjectDataIStream, true > _iStreamCache;
 
+        /** Decompression buffers, shared by all received versions */
+        lunchbox::Pool< lunchbox::Bufferb, true > _bufferCache;
+
         /** The instance identifier of the master object. */
         uint32_t _masterInstanceID;
 
@@ -89,9 +108,55 @@ namespace co
         /** The node holding the master object. */
         NodePtr _master;
 
+        /** Keeps the memory budget alive until all versions are released. */
+        const LocalNodePtr _localNode;
+
+        /**
+         * The master was limited to commit one version ahead of the slave,
+         * by the application or the receiver thread.
+         */
+        lunchbox::a_int32_t _throttled;
+
+        /** The uncompressed instance data of an INSTANCE object's version. */
+        lunchbox::Bufferb _instanceData;
+        lunchbox::Bufferb _instanceDelta; //!< The received binary delta
+        uint64_t _retainedSize; //!< The memory of both, as accounted
+
         void _syncToHead();
+
+        /** Queue a ready version, in order of the version numbers. */
+        void _queueVersion( ObjectDataIStream* is );
+        void _pushVersion( ObjectDataIStream* is );
+
+        /** Account the memory of a queued version, before it is read. */
+        void _addQueued( const ObjectDataIStream* is );
+        void _removeQueued( const ObjectDataIStream* is );
+        ObjectDataIStream* _popVersion();
+
+        /**
+         * Unpack all received versions up to the given version, skipping the
+         * versions superseded by a later version with full instance data.
+         */
+        void _unpackReadyVersions( const uint128_t& version );
         void _releaseStream( ObjectDataIStream* stream );
+        void _releaseBuffer( ObjectDataIStream* stream );
         void _sendAck();
+        void _sendMapAck();
+
+        /** Send the last version the master may commit. */
+        void _sendMaxVersion( const uint64_t maxVersion );
+
+        /** Apply instance data, retaining it as the base for deltas. */
+        void _applyInstanceData( ObjectDataIStream& is );
+
+        /** Apply a binary delta against the retained instance data. */
+        void _applyInstanceDelta( ObjectDataIStream& is );
+
+        /** Apply the retained instance data, using the flags of is. */
+        void _applyRetainedData( ObjectDataIStream& is );
+
+        /** Update the accounted memory of the retained data. */
+        void _updateRetainedSize();
 
         /** Apply the data in the input stream to the object */
         virtual void _unpackOneVersion( ObjectDataIStream* is );
@@ -44,6 +44,16 @@ template< class Q > void WorkerThread< Q >::run()
             if( stopRunning( ))
                 break;
 
+            // latency-critical commands overtake the rest of the batch
+            for( ICommand priority = _commands.tryPopPriority();
+                 priority.isValid(); priority = _commands.tryPopPriority( ))
+            {
+                if( !priority( ))
+                {
+                    LBABORT( "Error handling " << priority );
+                }
+            }
+
             _commands.pump();
         }
     }
@@ -22,15 +22,57 @@
 #include <co/bufferCache.h>
 #include <co/commandQueue.h>
 #include <co/dispatcher.h>
+#include <co/global.h>
 #include <co/iCommand.h>
 #include <co/init.h>
 #include <co/oCommand.h>
 #include <lunchbox/clock.h>
 
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
 // Tests the functionality of the network command buffer cache
 
 #define N_READER 13
 #define RUNTIME 5000
+#define HUGEPAGESIZE ( 2 * LB_1MB )
+
+#ifdef __linux__
+/** @return true if the memory at address is advised to use huge pages. */
+static bool _isHugePageAdvised( const void* address )
+{
+    const unsigned long addr = reinterpret_cast< unsigned long >( address );
+    std::ifstream smaps( "/proc/self/smaps" );
+    std::string line;
+    bool inside = false;
+    while( std::getline( smaps, line ))
+    {
+        unsigned long start = 0;
+        unsigned long end = 0;
+        if( ::sscanf( line.c_str(), "%lx-%lx", &start, &end ) == 2 )
+            inside = addr >= start && addr < end;
+        else if( inside && line.compare( 0, 8, "VmFlags:" ) == 0 )
+            return line.find( " hg" ) != std::string::npos;
+    }
+    return false;
+}
+
+/** @return true if the kernel supports transparent huge pages. */
+static bool _hasHugePages()
+{
+    std::ifstream file( "/sys/kernel/mm/transparent_hugepage/enabled" );
+    return file.is_open();
+}
+
+/** @return the first huge page boundary of the buffer. */
+static const uint8_t* _getHugePage( const co::Buffer& buffer )
+{
+    const uintptr_t data = reinterpret_cast< uintptr_t >( buffer.getData( ));
+    return reinterpret_cast< const uint8_t* >(
+        ( data + HUGEPAGESIZE - 1 ) & ~uintptr_t( HUGEPAGESIZE - 1 ));
+}
+#endif
 
 uint64_t rTime = 1;
 lunchbox::SpinLock _lock;
@@ -128,6 +170,65 @@ int main( int argc, char **argv )
         std::cout << N_READER * nOps / wTime << " write, "
                   << N_READER * nOps / rTime << " read ops/ms" << std::endl;
     }
+    {
+        // free buffers are reused for allocations of their size class
+        co::BufferCache cache( 2 );
+        const uint64_t allocSize = co::COMMAND_ALLOCSIZE;
+        const co::Buffer* small = 0;
+        {
+            co::BufferPtr buffer = cache.alloc( allocSize );
+            TEST( buffer->getMaxSize() >= allocSize );
+            small = buffer.get();
+        }
+
+        co::BufferPtr big = cache.alloc( allocSize * 10 );
+        TEST( big.get() != small );
+        TESTINFO( big->getMaxSize() >= allocSize * 16, big->getMaxSize( ));
+
+        co::BufferPtr buffer = cache.alloc( allocSize );
+        TEST( buffer.get() == small );
+        TEST( buffer->isEmpty( ));
+    }
+    {
+        // buffers from the threshold on are advised to use huge pages
+        const int32_t threshold = co::Global::getIAttribute(
+            co::Global::IATTR_HUGE_PAGE_BUFFER_SIZE );
+        co::Global::setIAttribute( co::Global::IATTR_HUGE_PAGE_BUFFER_SIZE,
+                                   4 );
+        co::BufferCache cache( 2 );
+        const uint64_t largeSize = 16 * LB_1MB;
+        const uint64_t smallSize = LB_1MB;
+
+        co::BufferPtr large = cache.alloc( largeSize );
+        TEST( large->getMaxSize() >= largeSize );
+        large->resize( largeSize );
+        ::memset( large->getData(), 0x5a, largeSize );
+        const co::Buffer* address = large.get();
+        const uint8_t* data = large->getData();
+
+        co::BufferPtr small = cache.alloc( smallSize );
+        TEST( small->getMaxSize() >= smallSize );
+        small->resize( smallSize );
+        ::memset( small->getData(), 0xa5, smallSize );
+#ifdef __linux__
+        if( _hasHugePages( ))
+        {
+            TEST( _isHugePageAdvised( _getHugePage( *large )));
+            TEST( !_isHugePageAdvised( small->getData( )));
+        }
+#endif
+
+        // the freed buffer is reused without reallocation
+        large = 0;
+        small = 0;
+        large = cache.alloc( largeSize );
+        TEST( large.get() == address );
+        TEST( large->getData() == data );
+        TEST( large->isEmpty( ));
+
+        co::Global::setIAttribute( co::Global::IATTR_HUGE_PAGE_BUFFER_SIZE,
+                                   threshold );
+    }
 
     TEST( co::exit( ));
     return EXIT_SUCCESS;
@@ -0,0 +1,124 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <co/bufferDelta.h> // private header
+#include <co/init.h>
+#include <lunchbox/rng.h>
+
+#include <cstring>
+#include <limits>
+
+// Tests the binary delta encoding used for INSTANCE object commits
+
+#define NLOOPS 10000
+#define MAXSIZE 512
+#define PARTSIZE 64
+
+static void _randomize( lunchbox::Bufferb& buffer, const uint64_t size,
+                        lunchbox::RNG& rng )
+{
+    buffer.resize( size );
+    for( uint64_t i = 0; i < size; ++i )
+        buffer[i] = rng.get< uint8_t >();
+}
+
+int main( int argc, char **argv )
+{
+    co::init( argc, argv );
+    lunchbox::RNG rng;
+    uint64_t nBytes = 0;
+    uint64_t nDeltaBytes = 0;
+
+    for( size_t i = 0; i < NLOOPS; ++i )
+    {
+        lunchbox::Bufferb base;
+        _randomize( base, rng.get< uint16_t >() % MAXSIZE, rng );
+
+        // same, grown or shrunk data with a few modified bytes
+        lunchbox::Bufferb data;
+        _randomize( data, ( i % 4 ) ? base.getSize() :
+                                      rng.get< uint16_t >() % MAXSIZE, rng );
+        const uint64_t common = LB_MIN( base.getSize(), data.getSize( ));
+        if( common > 0 )
+            ::memcpy( data.getData(), base.getData(), common );
+        for( size_t j = rng.get< uint8_t >() % 8; j > 0 && common > 0; --j )
+            data[ rng.get< uint32_t >() % common ] ^= 0x5a;
+
+        lunchbox::Bufferb delta;
+        TEST( co::encodeDelta( base, data.getData(), data.getSize(),
+                               std::numeric_limits< uint64_t >::max(), delta ));
+
+        lunchbox::Bufferb result;
+        result.append( base.getData(), base.getSize( ));
+        TEST( co::applyDelta( result, delta.getData(), delta.getSize( )));
+        TESTINFO( result.getSize() == data.getSize(),
+                  result.getSize() << " != " << data.getSize( ));
+        TEST( data.getSize() == 0 ||
+              ::memcmp( result.getData(), data.getData(),
+                        data.getSize( )) == 0 );
+
+        nBytes += data.getSize();
+        nDeltaBytes += delta.getSize();
+
+        // the encoder gives up once the delta reaches the given size
+        if( data.getSize() > 0 && data.getSize() != base.getSize( ))
+            TEST( !co::encodeDelta( base, data.getData(), data.getSize(), 1,
+                                    delta ));
+
+        // piecewise deltas skipping the unchanged parts are equivalent
+        co::startDelta( delta, data.getSize( ));
+        uint64_t unchanged = 0;
+        for( uint64_t j = 0; j < data.getSize(); j += PARTSIZE )
+        {
+            const uint64_t size = LB_MIN( PARTSIZE, data.getSize() - j );
+            const uint64_t baseSize = j < base.getSize() ?
+                LB_MIN( PARTSIZE, base.getSize() - j ) : 0;
+            if( size == baseSize && ::memcmp( data.getData() + j,
+                                              base.getData() + j, size ) == 0 )
+            {
+                unchanged += size;
+                continue;
+            }
+            const uint8_t* basePart = baseSize ? base.getData() + j : 0;
+            TEST( co::appendDelta( delta, unchanged, basePart, baseSize,
+                                   data.getData() + j, size,
+                                   std::numeric_limits< uint64_t >::max( )));
+            unchanged = 0;
+        }
+        TEST( co::appendDelta( delta, unchanged, 0, 0, 0, 0,
+                               std::numeric_limits< uint64_t >::max( )));
+
+        result.replace( base.getData(), base.getSize( ));
+        TEST( co::applyDelta( result, delta.getData(), delta.getSize( )));
+        TEST( result.getSize() == data.getSize( ));
+        TEST( data.getSize() == 0 ||
+              ::memcmp( result.getData(), data.getData(),
+                        data.getSize( )) == 0 );
+
+        // truncated deltas are detected
+        if( delta.getSize() > 1 )
+            TEST( !co::applyDelta( result, delta.getData(),
+                                   delta.getSize() - 1 ));
+    }
+
+    TESTINFO( nDeltaBytes < nBytes / 2, nDeltaBytes << " of " << nBytes );
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
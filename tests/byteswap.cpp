@@ -0,0 +1,91 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests correctness and throughput of the bulk endian conversion
+// Usage: ./byteswap
+
+#include <test.h>
+#include <co/byteswap.h>
+#include <co/init.h>
+#include <lunchbox/bitOperation.h>
+#include <lunchbox/clock.h>
+
+#include <iostream>
+#include <vector>
+
+#define NBYTES LB_10MB
+#define NLOOPS 10
+
+template< class T > static void _fill( std::vector< T >& data )
+{
+    uint64_t value = 0x0102030405060708ull;
+    for( size_t i = 0; i < data.size(); ++i )
+    {
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+        data[i] = T( value );
+    }
+}
+
+template< class T >
+static void _test( void (*swapArray)( void*, const uint64_t ),
+                   const std::string& name )
+{
+    // odd sizes and offsets exercise the vector heads and tails
+    for( size_t num = 0; num < 100; ++num )
+    {
+        std::vector< T > data( num + 1 );
+        _fill( data );
+        std::vector< T > expected = data;
+        for( size_t i = 1; i <= num; ++i )
+            lunchbox::byteswap( expected[i] );
+
+        swapArray( &data[1], num );
+        TESTINFO( data == expected, name << " " << num );
+    }
+
+    std::vector< T > data( NBYTES / sizeof( T ));
+    _fill( data );
+    const float mBytes = float( data.size() * sizeof( T )) / LB_1MB * NLOOPS;
+
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < NLOOPS; ++i )
+        for( size_t j = 0; j < data.size(); ++j )
+            lunchbox::byteswap( data[j] );
+    const float scalarTime = clock.getTimef();
+
+    clock.reset();
+    for( size_t i = 0; i < NLOOPS; ++i )
+        swapArray( &data.front(), data.size( ));
+    const float bulkTime = clock.getTimef();
+
+    std::cerr << name << ": " << mBytes * 1000.f / scalarTime
+              << " MB/s scalar, " << mBytes * 1000.f / bulkTime
+              << " MB/s bulk" << std::endl;
+}
+
+int main( int argc, char **argv )
+{
+    co::init( argc, argv );
+
+    _test< uint16_t >( co::byteswap16, "16 bit" );
+    _test< uint32_t >( co::byteswap32, "32 bit" );
+    _test< uint64_t >( co::byteswap64, "64 bit" );
+    _test< lunchbox::uint128_t >( co::byteswap128, "128 bit" );
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
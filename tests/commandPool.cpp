@@ -0,0 +1,146 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <co/commandFunc.h>
+#include <co/connectionDescription.h>
+#include <co/dataIStream.h>
+#include <co/dataOStream.h>
+#include <co/global.h>
+#include <co/init.h>
+#include <co/node.h>
+#include <co/object.h>
+#include <co/objectICommand.h>
+#include <co/objectOCommand.h>
+#include <lunchbox/monitor.h>
+#include <lunchbox/rng.h>
+
+#include <iostream>
+
+// Tests the in-order execution of object commands by the command pool
+
+#define NOBJECTS  8
+#define NCOMMANDS 1000
+
+namespace
+{
+lunchbox::Monitor< uint32_t > _nReceived( 0 );
+
+class Object : public co::Object
+{
+public:
+    Object() : _next( 0 ) {}
+
+    virtual void attach( const co::UUID& id, const uint32_t instanceID )
+    {
+        co::Object::attach( id, instanceID );
+        registerCommand( co::CMD_OBJECT_CUSTOM,
+                         co::CommandFunc< Object >( this, &Object::_cmdCustom ),
+                         getLocalNode()->getCommandThreadQueue( ));
+    }
+
+protected:
+    virtual void getInstanceData( co::DataOStream& os ) { os << _next; }
+    virtual void applyInstanceData( co::DataIStream& is ) { is >> _next; }
+
+private:
+    uint32_t _next;
+
+    bool _cmdCustom( co::ICommand& cmd )
+    {
+        co::ObjectICommand command( cmd );
+        const uint32_t sequence = command.get< uint32_t >();
+
+        TESTINFO( sequence == _next, sequence << " != " << _next );
+        TEST( !getLocalNode()->inCommandThread( ));
+        ++_next;
+        ++_nReceived;
+        return true;
+    }
+};
+}
+
+int main( int argc, char **argv )
+{
+    co::init( argc, argv );
+    co::Global::setIAttribute( co::Global::IATTR_COMMAND_POOL_THREADS, 4 );
+
+    lunchbox::RNG rng;
+    const uint16_t port = (rng.get<uint16_t>() % 60000) + 1024;
+
+    co::LocalNodePtr server = new co::LocalNode;
+    co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->port = port;
+    connDesc->setHostname( "localhost" );
+
+    server->addConnectionDescription( connDesc );
+    TEST( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( connDesc );
+
+    connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( connDesc );
+    TEST( client->listen( ));
+    TEST( client->connect( serverProxy ));
+
+    Object masters[ NOBJECTS ];
+    Object slaves[ NOBJECTS ];
+    for( size_t i = 0; i < NOBJECTS; ++i )
+    {
+        TEST( server->registerObject( &masters[i] ));
+        TEST( client->mapObject( &slaves[i], masters[i].getID( )));
+    }
+
+    // interleave the command streams of all objects
+    for( uint32_t i = 0; i < NCOMMANDS; ++i )
+        for( size_t j = 0; j < NOBJECTS; ++j )
+            slaves[j].send( serverProxy, co::CMD_OBJECT_CUSTOM,
+                            masters[j].getInstanceID( )) << i;
+
+    TESTINFO( _nReceived.timedWaitEQ( NOBJECTS * NCOMMANDS, 10000 ),
+              _nReceived.get( ));
+
+    for( size_t i = 0; i < NOBJECTS; ++i )
+    {
+        client->unmapObject( &slaves[i] );
+        server->deregisterObject( &masters[i] );
+    }
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+
+    serverProxy->printHolders( std::cerr );
+    TESTINFO( serverProxy->getRefCount() == 1, serverProxy->getRefCount( ));
+    TESTINFO( client->getRefCount() == 1, client->getRefCount( ));
+    TESTINFO( server->getRefCount() == 1, server->getRefCount( ));
+
+    serverProxy = 0;
+    client      = 0;
+    server      = 0;
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
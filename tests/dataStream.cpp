@@ -25,6 +25,7 @@
 #include <co/connectionDescription.h>
 #include <co/dataIStream.h>
 #include <co/dataOStream.h>
+#include <co/global.h>
 #include <co/init.h>
 
 #include <lunchbox/thread.h>
@@ -37,6 +38,7 @@
 #define CONTAINER_SIZE LB_64KB
 
 static std::string _message( "So long, and thanks for all the fish" );
+static std::string _longMessage( 2 * LB_64KB, '4' );
 
 class DataOStream : public co::DataOStream
 {
@@ -127,6 +129,7 @@ protected:
 
             stream << doubles;
             stream << _message;
+            stream << _longMessage;
 
             char blob[128];
             for( size_t i=0; i < 128; ++i )
@@ -145,6 +148,9 @@ private:
 int main( int argc, char **argv )
 {
     co::init( argc, argv );
+    // split the big writes over multiple commands
+    co::Global::setIAttribute( co::Global::IATTR_OBJECT_COMMAND_SIZE, 64 );
+
     co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
     desc->type = co::CONNECTIONTYPE_PIPE;
     co::ConnectionPtr connection = co::Connection::create( desc );
@@ -221,6 +227,9 @@ int main( int argc, char **argv )
     TESTINFO( message == _message,
               '\'' <<  message << "' != '" << _message << '\'' );
 
+    stream >> message;
+    TESTINFO( message == _longMessage, message.length( ));
+
     char blob[128] = { 0 };
     stream >> co::Array< void >( blob, 128 );
     for( size_t i=0; i < 128; ++i )
@@ -26,6 +26,28 @@
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/vector.hpp>
 
+// a bitwise serializable type, (de)serialized in bulk in containers
+struct Vertex
+{
+    Vertex( const float x_ = 0.f, const float y_ = 0.f, const float z_ = 0.f )
+        : x( x_ ), y( y_ ), z( z_ ) {}
+
+    bool operator == ( const Vertex& rhs ) const
+        { return x == rhs.x && y == rhs.y && z == rhs.z; }
+
+    template< class Archive > void serialize( Archive& ar, const unsigned int )
+        { ar & x & y & z; }
+
+    float x, y, z;
+};
+BOOST_IS_BITWISE_SERIALIZABLE( Vertex )
+
+namespace co
+{
+template<> struct ArchiveSwapSize< Vertex >
+    : public boost::integral_constant< std::size_t, sizeof( float )> {};
+}
+
 template< typename T >
 class Object : public co::Object
 {
@@ -109,6 +131,9 @@ int main( int argc, char **argv )
     testObjectSerialization( server, client, std::string( "blablub" ));
     testObjectSerialization( server, client, co::uint128_t( 12345, 54321 ));
     testObjectSerialization( server, client, std::vector< int >( 9 ));
+    testObjectSerialization( server, client, std::vector< float >( 1000, 3.f ));
+    testObjectSerialization( server, client,
+                             std::vector< Vertex >( 1000, Vertex( 1, 2, 3 )));
 
     TEST( client->disconnect( serverProxy ));
     TEST( client->close( ));
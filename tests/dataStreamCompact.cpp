@@ -0,0 +1,243 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <co/connectionDescription.h>
+#include <co/dataIStream.h>
+#include <co/dataOStream.h>
+#include <co/init.h>
+#include <co/localNode.h>
+#include <co/object.h>
+#include <co/objectVersion.h>
+
+#include <lunchbox/plugins/compressorTypes.h>
+#include <lunchbox/rng.h>
+
+#include <limits>
+
+// Tests the compact integer encoding of the DataOStream and DataIStream, and
+// its transmission in the data header of object commands
+
+class DataOStream : public co::DataOStream
+{
+public:
+    DataOStream( const bool compact )
+        {
+            setCompact( compact );
+            enableSave();
+            _enable();
+        }
+
+    const lunchbox::Bufferb& getSaved() { return getBuffer(); }
+
+protected:
+    virtual void sendData( const void*, const uint64_t, const bool ) {}
+};
+
+class DataIStream : public co::DataIStream
+{
+public:
+    DataIStream( const lunchbox::Bufferb& buffer, const bool compact )
+        : co::DataIStream( false /*swap*/ )
+        , _buffer( &buffer )
+        , _compact( compact )
+    {}
+
+    virtual size_t nRemainingBuffers() const { return _buffer ? 1 : 0; }
+    virtual lunchbox::uint128_t getVersion() const { return co::VERSION_NONE;}
+    virtual co::NodePtr getMaster() { return 0; }
+
+protected:
+    virtual bool getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
+                                const void** chunkData, uint64_t& size )
+        {
+            if( !_buffer )
+                return false;
+
+            compressor = EQ_COMPRESSOR_NONE;
+            nChunks = 1;
+            *chunkData = _buffer->getData();
+            size = _buffer->getSize();
+            setCompact( _compact );
+            _buffer = 0;
+            return true;
+        }
+
+private:
+    const lunchbox::Bufferb* _buffer;
+    const bool _compact;
+};
+
+static const co::ObjectVersion _version( co::UUID( true ),
+                                         co::uint128_t( 0, 42 ));
+
+static void _write( co::DataOStream& os )
+{
+    os << uint32_t( 1 ) << int32_t( -2 ) << uint64_t( 300 )
+       << int64_t( -70000 ) << std::numeric_limits< uint64_t >::max()
+       << std::numeric_limits< int64_t >::min() << co::uint128_t( 0, 17 )
+       << _version << std::string( "fish" ) << 42.f;
+
+    std::vector< uint32_t > values;
+    for( uint32_t i = 0; i < 3; ++i )
+        values.push_back( i );
+    os << values;
+
+    std::map< uint32_t, int64_t > map;
+    map[ 7 ] = -7;
+    map[ 8 ] = 8;
+    os << map;
+}
+
+static void _read( co::DataIStream& is )
+{
+    uint32_t u32;
+    int32_t i32;
+    uint64_t u64;
+    int64_t i64;
+    uint64_t maxU64;
+    int64_t minI64;
+    co::uint128_t u128;
+    co::ObjectVersion version;
+    std::string string;
+    float f;
+
+    is >> u32 >> i32 >> u64 >> i64 >> maxU64 >> minI64 >> u128 >> version
+       >> string >> f;
+    TESTINFO( u32 == 1, u32 );
+    TESTINFO( i32 == -2, i32 );
+    TESTINFO( u64 == 300, u64 );
+    TESTINFO( i64 == -70000, i64 );
+    TEST( maxU64 == std::numeric_limits< uint64_t >::max( ));
+    TEST( minI64 == std::numeric_limits< int64_t >::min( ));
+    TESTINFO( u128 == co::uint128_t( 0, 17 ), u128 );
+    TESTINFO( version == _version, version << " != " << _version );
+    TESTINFO( string == "fish", string );
+    TEST( f == 42.f );
+
+    std::vector< uint32_t > values;
+    is >> values;
+    TEST( values.size() == 3 );
+    for( uint32_t i = 0; i < 3; ++i )
+        TEST( values[i] == i );
+
+    std::map< uint32_t, int64_t > map;
+    is >> map;
+    TEST( map.size() == 2 );
+    TEST( map[ 7 ] == -7 );
+    TEST( map[ 8 ] == 8 );
+    TEST( !is.hasData( ));
+}
+
+/** Serializes the test data compactly, for instance data and deltas. */
+class Object : public co::Object
+{
+public:
+    Object() : _nApplied( 0 ) {}
+
+    size_t getNumApplied() const { return _nApplied; }
+
+protected:
+    virtual ChangeType getChangeType() const { return DELTA; }
+    virtual bool useCompactEncoding() const { return true; }
+
+    virtual void getInstanceData( co::DataOStream& os )
+        { TEST( os.isCompact( )); _write( os ); }
+    virtual void applyInstanceData( co::DataIStream& is )
+        { _read( is ); ++_nApplied; }
+
+private:
+    size_t _nApplied;
+};
+
+static void _testWire()
+{
+    lunchbox::RNG rng;
+    co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->port = (rng.get<uint16_t>() % 60000) + 1024;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr server = new co::LocalNode;
+    server->addConnectionDescription( connDesc );
+    TEST( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( connDesc );
+
+    connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( connDesc );
+    TEST( client->listen( ));
+    TEST( client->connect( serverProxy ));
+
+    // the receivers only know the encoding from the transmitted data header
+    Object master;
+    TEST( server->registerObject( &master ));
+
+    Object slave;
+    TEST( client->mapObject( &slave, master.getID( )));
+    TESTINFO( slave.getNumApplied() == 1, slave.getNumApplied( ));
+
+    master.commit();
+    slave.sync( master.getVersion( ));
+    TESTINFO( slave.getNumApplied() == 2, slave.getNumApplied( ));
+
+    client->unmapObject( &slave );
+    server->deregisterObject( &master );
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+
+    TESTINFO( serverProxy->getRefCount() == 1, serverProxy->getRefCount( ));
+    TESTINFO( client->getRefCount() == 1, client->getRefCount( ));
+    TESTINFO( server->getRefCount() == 1, server->getRefCount( ));
+}
+
+int main( int argc, char **argv )
+{
+    co::init( argc, argv );
+
+    ::DataOStream plain( false );
+    _write( plain );
+    plain.disable();
+
+    ::DataOStream compact( true );
+    TEST( compact.isCompact( ));
+    _write( compact );
+    compact.disable();
+
+    const uint64_t plainSize = plain.getSaved().getSize();
+    const uint64_t compactSize = compact.getSaved().getSize();
+    TESTINFO( compactSize < plainSize, compactSize << " >= " << plainSize );
+
+    ::DataIStream plainIn( plain.getSaved(), false );
+    _read( plainIn );
+
+    ::DataIStream compactIn( compact.getSaved(), true );
+    _read( compactIn );
+
+    _testWire();
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
@@ -23,6 +23,7 @@
 #include <co/buffer.h>
 #include <co/bufferCache.h>
 #include <co/commandFunc.h>
+#include <co/commandQueue.h>
 #include <co/dispatcher.h>
 #include <co/iCommand.h>
 #include <co/localNode.h>
@@ -135,5 +136,31 @@ int main( int argc, char **argv )
     barFoo.dispatchCommand ( command );
     TESTINFO( calls == 3, calls );
 
+    // priority commands overtake queued normal commands
+    co::CommandQueue queue;
+    bar.registerCommand( co::CMD_NODE_CUSTOM,
+                         co::CommandFunc< Bar >( &bar, &Bar::cmd ), &queue );
+    bar.registerCommand( co::CMD_NODE_CUSTOM + 1,
+                         co::CommandFunc< Bar >( &bar, &Bar::cmd ), &queue,
+                         true );
+
+    co::ICommand priority( command );
+    priority.setCommand( co::CMD_NODE_CUSTOM + 1 );
+    bar.dispatchCommand( command );
+    bar.dispatchCommand( priority );
+    TESTINFO( queue.getSize() == 2, queue.getSize( ));
+
+    co::ICommands commands = queue.popAll();
+    TESTINFO( commands.size() == 2, commands.size( ));
+    TEST( commands[0].isPriority( ));
+    TEST( commands[0].getCommand() == co::CMD_NODE_CUSTOM + 1 );
+    TEST( !commands[1].isPriority( ));
+    TEST( commands[1].getCommand() == co::CMD_NODE_CUSTOM );
+    TEST( !queue.tryPopPriority().isValid( ));
+
+    TEST( commands[0]( ));
+    TEST( commands[1]( ));
+    TESTINFO( calls == 5, calls );
+
     return EXIT_SUCCESS;
 }
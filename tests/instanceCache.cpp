@@ -101,6 +101,8 @@ int main( int argc, char **argv )
     for( lunchbox::UUID key; key.low() < 65536; ++key ) // Fill cache
         if( !cache.add( co::ObjectVersion( key, 1 ), 1, in ))
             break;
+    TEST( cache.getEvictions() > 0 );
+    TESTINFO( cache.getSize() <= cache.getMaxSize(), cache );
 
     _clock.reset();
     for( size_t i = 0; i < N_READER; ++i )
@@ -154,6 +156,7 @@ int main( int argc, char **argv )
     {
         TEST( cache[ key ] == co::InstanceCache::Data::NONE );
     }
+    TEST( cache.getMisses() >= 65536 );
 
     std::cout << cache << std::endl;
 
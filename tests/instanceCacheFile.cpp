@@ -0,0 +1,136 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <co/init.h>
+#include <co/instanceCache.h> // private header
+#include <co/localNode.h>
+#include <co/nodeCommand.h>
+#include <co/objectDataICommand.h>
+#include <co/objectDataIStream.h>
+#include <co/objectDataOCommand.h>
+#include <co/objectVersion.h>
+
+#include <cstdio>
+#include <fstream>
+
+// Tests loading the instance cache from its file after a restart, and the
+// eviction of the least recently used objects from a full file
+
+#define FILENAME "instanceCacheFile.cache"
+#define EVICTFILENAME "instanceCacheFileEvict.cache"
+#define NOBJECTS 10
+#define NVERSIONS 3
+
+static co::ObjectDataICommand _createCommand( co::LocalNodePtr node,
+                                              const co::uint128_t& version )
+{
+    co::ObjectDataOCommand out( co::Connections(),
+                                co::CMD_NODE_OBJECT_INSTANCE,
+                                co::COMMANDTYPE_NODE, co::UUID(), 0, version,
+                                0, 0, true, 0 );
+    return out._getCommand( node );
+}
+
+static void _fill( co::InstanceCache& cache, co::LocalNodePtr node )
+{
+    for( size_t i = 0; i < NOBJECTS; ++i )
+    {
+        for( uint64_t j = 1; j <= NVERSIONS; ++j )
+        {
+            co::ObjectDataICommand command = _createCommand( node, j );
+            TEST( cache.add( co::ObjectVersion( co::UUID( i + 1, 0 ), j ),
+                             1, command ));
+        }
+    }
+}
+
+static uint64_t _getFileSize( const char* filename )
+{
+    std::ifstream file( filename, std::ios::binary | std::ios::ate );
+    return file ? uint64_t( file.tellg( )) : 0;
+}
+
+static void _testEviction( co::LocalNodePtr node, const uint64_t fileSize )
+{
+    const uint64_t maxSize = fileSize / 2;
+    ::remove( EVICTFILENAME );
+    {
+        co::InstanceCache cache( LB_100MB, EVICTFILENAME, maxSize );
+        _fill( cache, node );
+    }
+    TESTINFO( _getFileSize( EVICTFILENAME ) <= maxSize,
+              _getFileSize( EVICTFILENAME ) << " > " << maxSize );
+
+    co::InstanceCache cache( LB_100MB, EVICTFILENAME, maxSize );
+    TEST( !cache.load( co::UUID( 1, 0 ), node, node ));
+
+    const co::UUID id( NOBJECTS, 0 );
+    TEST( cache.load( id, node, node ));
+    const co::InstanceCache::Data& data = cache[ id ];
+    TEST( data != co::InstanceCache::Data::NONE );
+    TESTINFO( data.versions.size() == NVERSIONS, data.versions.size( ));
+    TEST( cache.release( id, 1 ));
+    ::remove( EVICTFILENAME );
+}
+
+int main( int argc, char **argv )
+{
+    co::init( argc, argv );
+    ::remove( FILENAME );
+
+    co::LocalNodePtr node = new co::LocalNode;
+    {
+        co::InstanceCache cache( LB_100MB, FILENAME, LB_100MB );
+        _fill( cache, node );
+    }
+    const uint64_t fileSize = _getFileSize( FILENAME );
+    TEST( fileSize > 0 );
+
+    // 'restart': a new cache only knows the data from the file
+    co::InstanceCache cache( LB_100MB, FILENAME, LB_100MB );
+    for( size_t i = 0; i < NOBJECTS; ++i )
+    {
+        const co::UUID id( i + 1, 0 );
+        TEST( cache[ id ] == co::InstanceCache::Data::NONE );
+        TEST( cache.load( id, node, node ));
+
+        const co::InstanceCache::Data& data = cache[ id ];
+        TEST( data != co::InstanceCache::Data::NONE );
+        TEST( data.masterInstanceID == 1 );
+        TESTINFO( data.versions.size() == NVERSIONS, data.versions.size( ));
+        for( size_t j = 0; j < data.versions.size(); ++j )
+        {
+            TEST( data.versions[j]->isReady( ));
+            TEST( data.versions[j]->getVersion() == co::uint128_t( j + 1 ));
+        }
+        TEST( cache.release( id, 1 ));
+    }
+
+    // data from another master is not loaded
+    co::LocalNodePtr other = new co::LocalNode;
+    TEST( !cache.load( co::UUID( NOBJECTS + 1, 0 ), node, node ));
+    TEST( cache.erase( co::UUID( 1, 0 )));
+    TEST( !cache.load( co::UUID( 1, 0 ), node, other ));
+
+    _testEviction( node, fileSize );
+
+    ::remove( FILENAME );
+    TEST( co::exit( ));
+    return EXIT_SUCCESS;
+}
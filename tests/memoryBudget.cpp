@@ -0,0 +1,170 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <co/connectionDescription.h>
+#include <co/dataIStream.h>
+#include <co/dataOStream.h>
+#include <co/global.h>
+#include <co/init.h>
+#include <co/memoryBudget.h>
+#include <co/node.h>
+#include <co/object.h>
+#include <lunchbox/rng.h>
+#include <lunchbox/sleep.h>
+#include <lunchbox/thread.h>
+
+#include <iostream>
+
+// Tests that a slave which does not sync while its node exceeds the memory
+// budget stops its master from committing
+
+#define NVERSIONS 64
+#define DATASIZE  ( 4 * LB_1MB ) // retained by the slave, exceeds the budget
+
+namespace
+{
+class Object : public co::Object
+{
+public:
+    Object() : _value( 0 ), _data( DATASIZE ) {}
+
+    void setValue( const uint32_t value ) { _value = value; }
+    uint32_t getValue() const { return _value; }
+
+protected:
+    virtual ChangeType getChangeType() const { return INSTANCE; }
+
+    virtual void getInstanceData( co::DataOStream& os )
+        { os << _value << _data; }
+
+    virtual void applyInstanceData( co::DataIStream& is )
+        { is >> _value >> _data; }
+
+private:
+    uint32_t _value;
+    std::vector< uint8_t > _data;
+};
+
+/** Commits all versions of the master, as far as the slave lets it. */
+class Committer : public lunchbox::Thread
+{
+public:
+    explicit Committer( Object& master ) : nCommits( 0 ), _master( master ) {}
+
+    lunchbox::a_int32_t nCommits;
+
+protected:
+    virtual void run()
+    {
+        for( uint32_t i = 2; i <= NVERSIONS + 1; ++i )
+        {
+            _master.setValue( i );
+            _master.commit();
+            ++nCommits;
+        }
+    }
+
+private:
+    Object& _master;
+};
+}
+
+int main( int argc, char **argv )
+{
+    co::init( argc, argv );
+    co::Global::setIAttribute( co::Global::IATTR_MEMORY_BUDGET, 1 );
+
+    lunchbox::RNG rng;
+    const uint16_t port = (rng.get<uint16_t>() % 60000) + 1024;
+
+    co::LocalNodePtr server = new co::LocalNode;
+    co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->port = port;
+    connDesc->setHostname( "localhost" );
+
+    server->addConnectionDescription( connDesc );
+    TEST( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( connDesc );
+
+    connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( connDesc );
+    TEST( client->listen( ));
+    TEST( client->connect( serverProxy ));
+
+    Object master;
+    master.setValue( 1 );
+    TEST( client->registerObject( &master ));
+
+    Object slave;
+    TEST( server->mapObject( &slave, master.getID( )));
+    TESTINFO( slave.getValue() == 1, slave.getValue( ));
+
+    co::MemoryBudget& budget = server->getMemoryBudget();
+    TESTINFO( budget.getSize( co::MemoryBudget::SLAVE_DATA ) >= DATASIZE,
+              budget );
+    TESTINFO( budget.isUnderPressure(), budget );
+
+    // the receiver thread of the slave stops the master while it does not sync
+    Committer committer( master );
+    TEST( committer.start( ));
+    lunchbox::sleep( 500 );
+    const int32_t nCommits = committer.nCommits;
+    lunchbox::sleep( 500 );
+    TESTINFO( committer.nCommits == nCommits,
+              committer.nCommits << " != " << nCommits );
+    TESTINFO( nCommits < NVERSIONS, nCommits );
+    TESTINFO( slave.getValue() == 1, slave.getValue( ));
+
+    // syncing releases the master version by version
+    for( uint32_t i = 2; i <= NVERSIONS + 1; ++i )
+    {
+        slave.sync( co::uint128_t( i ));
+        TESTINFO( slave.getValue() == i, slave.getValue( ));
+    }
+    committer.join();
+    TESTINFO( committer.nCommits == NVERSIONS, committer.nCommits );
+    TESTINFO( budget.getSize( co::MemoryBudget::SLAVE_QUEUES ) == 0, budget );
+
+    server->unmapObject( &slave );
+    client->deregisterObject( &master );
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+
+    serverProxy->printHolders( std::cerr );
+    TESTINFO( serverProxy->getRefCount() == 1, serverProxy->getRefCount( ));
+    TESTINFO( client->getRefCount() == 1, client->getRefCount( ));
+    TESTINFO( server->getRefCount() == 1, server->getRefCount( ));
+
+    serverProxy = 0;
+    client      = 0;
+    server      = 0;
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <co/co.h>
+#include <lunchbox/rng.h>
+
+#include <iostream>
+
+// Tests that compressed versions bigger than the object buffer size, which are
+// decompressed directly or into the pooled buffers of the slave, are received
+// intact and in order
+
+#define NVERSIONS 10
+#define DATASIZE  ( 1024 * 1024 )
+
+namespace
+{
+class Object : public co::Object
+{
+public:
+    Object() : _data( DATASIZE ), _seed( 0 ) { _fill(); }
+
+    void setSeed( const uint8_t seed ) { _seed = seed; _fill(); setDirty(); }
+    uint8_t getSeed() const { return _seed; }
+
+protected:
+    virtual ChangeType getChangeType() const { return INSTANCE; }
+
+    virtual void getInstanceData( co::DataOStream& os )
+        { os << _seed << _data; }
+
+    virtual void applyInstanceData( co::DataIStream& is )
+    {
+        is >> _seed >> _data;
+        TESTINFO( _data.size() == DATASIZE, _data.size( ));
+
+        // compressible runs, different for each version
+        for( size_t i = 0; i < _data.size(); ++i )
+            TESTINFO( _data[i] == uint8_t( _seed + ( i >> 10 )),
+                      "version " << int( _seed ) << " byte " << i );
+    }
+
+private:
+    std::vector< uint8_t > _data;
+    uint8_t _seed;
+
+    void _fill()
+    {
+        for( size_t i = 0; i < _data.size(); ++i )
+            _data[i] = uint8_t( _seed + ( i >> 10 ));
+    }
+};
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+    lunchbox::RNG rng;
+    co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->port = (rng.get<uint16_t>() % 60000) + 1024;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr server = new co::LocalNode;
+    server->addConnectionDescription( connDesc );
+    TEST( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( connDesc );
+
+    connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( connDesc );
+    TEST( client->listen( ));
+    TEST( client->connect( serverProxy ));
+
+    Object master;
+    TEST( client->registerObject( &master ));
+
+    Object slave;
+    TEST( server->mapObject( &slave, master.getID( )));
+    TEST( slave.getSeed() == 0 );
+
+    // one by one: each version reuses the buffer released by the previous one
+    for( uint8_t i = 1; i <= NVERSIONS; ++i )
+    {
+        master.setSeed( i );
+        master.commit();
+        slave.sync( master.getVersion( ));
+        TESTINFO( slave.getSeed() == i, int( slave.getSeed( )));
+    }
+
+    // queued: several versions hold pooled buffers at the same time
+    for( uint8_t i = 1; i <= NVERSIONS; ++i )
+    {
+        master.setSeed( NVERSIONS + i );
+        master.commit();
+    }
+    while( slave.getVersion() < master.getVersion( ))
+        slave.sync( slave.getVersion() + 1 );
+    TESTINFO( slave.getSeed() == 2 * NVERSIONS, int( slave.getSeed( )));
+
+    server->unmapObject( &slave );
+    client->deregisterObject( &master );
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+
+    serverProxy->printHolders( std::cerr );
+    TESTINFO( serverProxy->getRefCount() == 1, serverProxy->getRefCount( ));
+    TESTINFO( client->getRefCount() == 1, client->getRefCount( ));
+    TESTINFO( server->getRefCount() == 1, server->getRefCount( ));
+
+    serverProxy = 0;
+    client      = 0;
+    server      = 0;
+
+    TEST( co::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <co/co.h>
+#include <lunchbox/rng.h>
+
+#include <iostream>
+
+// Tests that mapping an object whose master moved to another node succeeds
+// although the master directory still names the old master
+
+namespace
+{
+class Object : public co::Object
+{
+public:
+    Object() : value( 0 ) {}
+
+    uint32_t value;
+
+protected:
+    virtual ChangeType getChangeType() const { return STATIC; }
+
+    virtual void getInstanceData( co::DataOStream& os ) { os << value; }
+    virtual void applyInstanceData( co::DataIStream& is ) { is >> value; }
+};
+
+co::NodePtr _listen( co::LocalNodePtr node )
+{
+    lunchbox::RNG rng;
+    co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->port = (rng.get<uint16_t>() % 60000) + 1024;
+    connDesc->setHostname( "localhost" );
+    node->addConnectionDescription( connDesc );
+    TEST( node->listen( ));
+
+    co::NodePtr proxy = new co::Node;
+    proxy->addConnectionDescription( connDesc );
+    return proxy;
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+    co::LocalNodePtr oldServer = new co::LocalNode;
+    co::LocalNodePtr newServer = new co::LocalNode;
+    co::NodePtr oldProxy = _listen( oldServer );
+    co::NodePtr newProxy = _listen( newServer );
+
+    co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( connDesc );
+    TEST( client->listen( ));
+    TEST( client->connect( oldProxy ));
+    TEST( client->connect( newProxy ));
+
+    // records the old master in the client's directory
+    Object oldMaster;
+    oldMaster.value = 1;
+    TEST( oldServer->registerObject( &oldMaster ));
+
+    Object slave;
+    TEST( client->mapObject( &slave, oldMaster.getID( )));
+    TEST( slave.value == 1 );
+    client->unmapObject( &slave );
+
+    // moves the master to the other server
+    const co::UUID id = oldMaster.getID();
+    oldServer->deregisterObject( &oldMaster );
+
+    Object newMaster;
+    newMaster.value = 2;
+    newMaster.setID( id );
+    TEST( newServer->registerObject( &newMaster ));
+
+    // the map request to the stale master fails and is retried
+    TEST( client->mapObject( &slave, id ));
+    TEST( slave.value == 2 );
+    client->unmapObject( &slave );
+
+    // batched maps are retried as well
+    co::Objects objects( 1, &slave );
+    co::ObjectVersions versions( 1, co::ObjectVersion( id,
+                                                       co::VERSION_OLDEST ));
+    newServer->deregisterObject( &newMaster );
+    TEST( oldServer->registerObject( &newMaster ));
+    TEST( client->mapObjectsSync( client->mapObjectsNB( objects, versions )));
+    TEST( slave.value == 2 );
+    client->unmapObject( &slave );
+    oldServer->deregisterObject( &newMaster );
+
+    TEST( client->disconnect( oldProxy ));
+    TEST( client->disconnect( newProxy ));
+    TEST( client->close( ));
+    TEST( oldServer->close( ));
+    TEST( newServer->close( ));
+
+    oldProxy = 0;
+    newProxy = 0;
+    client = 0;
+    oldServer = 0;
+    newServer = 0;
+
+    TEST( co::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <co/connectionDescription.h>
+#include <co/dataIStream.h>
+#include <co/dataOStream.h>
+#include <co/global.h>
+#include <co/init.h>
+#include <co/node.h>
+#include <co/object.h>
+#include <lunchbox/rng.h>
+
+#include <iostream>
+
+// Tests mapping old versions of a master which exceed the history budget, with
+// unique versions and with versions sharing most of their chunks
+
+#define NVERSIONS 16
+#define NVALUES   65536 // 256 KB per version
+
+namespace
+{
+/** @return hardly compressible content, unique for each version. */
+uint32_t _getData( const uint32_t value, const size_t i )
+{
+    return uint32_t( value * 2654435761u + i * 40503u );
+}
+
+class Object : public co::Object
+{
+public:
+    /** Only the first nChanged values change with each version. */
+    explicit Object( const size_t nChanged = NVALUES )
+        : _nChanged( nChanged ), _value( 0 ), _data( NVALUES ) {}
+
+    void setValue( const uint32_t value )
+    {
+        _value = value;
+        for( size_t i = 0; i < NVALUES; ++i )
+            _data[i] = _getExpected( i );
+    }
+
+    uint32_t getValue() const { return _value; }
+
+protected:
+    virtual ChangeType getChangeType() const { return INSTANCE; }
+
+    virtual void getInstanceData( co::DataOStream& os )
+        { os << _value << _data; }
+
+    virtual void applyInstanceData( co::DataIStream& is )
+    {
+        is >> _value >> _data;
+        TESTINFO( _data.size() == NVALUES, _data.size( ));
+        for( size_t i = 0; i < NVALUES; ++i )
+            TESTINFO( _data[i] == _getExpected( i ), i << ": " << _data[i] );
+    }
+
+private:
+    const size_t _nChanged;
+    uint32_t _value;
+    std::vector< uint32_t > _data;
+
+    uint32_t _getExpected( const size_t i ) const
+        { return _getData( i < _nChanged ? _value : 0, i ); }
+};
+}
+
+int main( int argc, char **argv )
+{
+    co::init( argc, argv );
+    co::Global::setIAttribute( co::Global::IATTR_OBJECT_HISTORY_SIZE, 1 );
+
+    lunchbox::RNG rng;
+    const uint16_t port = (rng.get<uint16_t>() % 60000) + 1024;
+
+    co::LocalNodePtr server = new co::LocalNode;
+    co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->port = port;
+    connDesc->setHostname( "localhost" );
+
+    server->addConnectionDescription( connDesc );
+    TEST( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( connDesc );
+
+    connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( connDesc );
+    TEST( client->listen( ));
+    TEST( client->connect( serverProxy ));
+
+    Object master;
+    master.setValue( 1 );
+    TEST( client->registerObject( &master ));
+    master.setAutoObsolete( NVERSIONS );
+
+    // retain about 4 MB of versions, most of them spilled to the file
+    for( uint32_t i = 2; i <= NVERSIONS; ++i )
+    {
+        master.setValue( i );
+        master.commit();
+    }
+    TESTINFO( master.getVersion() == NVERSIONS, master.getVersion( ));
+
+    // map the oldest version, reloaded from the file, and all later ones
+    Object slave;
+    TEST( server->mapObject( &slave, master.getID(), co::VERSION_OLDEST ));
+    TESTINFO( slave.getValue() == 1, slave.getValue( ));
+
+    for( uint32_t i = 2; i <= NVERSIONS; ++i )
+    {
+        slave.sync( i );
+        TESTINFO( slave.getValue() == i, slave.getValue( ));
+    }
+
+    // late mappers of newer versions work alike
+    Object late;
+    TEST( server->mapObject( &late, master.getID(), NVERSIONS / 2 ));
+    TESTINFO( late.getValue() == NVERSIONS / 2, late.getValue( ));
+    late.sync( NVERSIONS );
+    TESTINFO( late.getValue() == NVERSIONS, late.getValue( ));
+
+    server->unmapObject( &late );
+    server->unmapObject( &slave );
+    client->deregisterObject( &master );
+
+    // versions share the unchanged chunks, the old ones are obsoleted
+    Object shared( NVALUES / 4 );
+    shared.setValue( 1 );
+    TEST( client->registerObject( &shared ));
+    shared.setAutoObsolete( NVERSIONS / 2 );
+
+    for( uint32_t i = 2; i <= NVERSIONS * 2; ++i )
+    {
+        shared.setValue( i );
+        shared.commit();
+    }
+    TESTINFO( shared.getVersion() == NVERSIONS * 2, shared.getVersion( ));
+
+    // a late mapper gets the oldest retained version and all later ones
+    Object sharedSlave( NVALUES / 4 );
+    TEST( server->mapObject( &sharedSlave, shared.getID(),
+                             co::VERSION_OLDEST ));
+    const uint32_t oldest = sharedSlave.getValue();
+    TESTINFO( oldest > 1 && oldest < NVERSIONS * 2, oldest );
+
+    for( uint32_t i = oldest + 1; i <= NVERSIONS * 2; ++i )
+    {
+        sharedSlave.sync( i );
+        TESTINFO( sharedSlave.getValue() == i, sharedSlave.getValue( ));
+    }
+
+    server->unmapObject( &sharedSlave );
+    client->deregisterObject( &shared );
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+
+    serverProxy->printHolders( std::cerr );
+    TESTINFO( serverProxy->getRefCount() == 1, serverProxy->getRefCount( ));
+    TESTINFO( client->getRefCount() == 1, client->getRefCount( ));
+    TESTINFO( server->getRefCount() == 1, server->getRefCount( ));
+
+    serverProxy = 0;
+    client      = 0;
+    server      = 0;
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
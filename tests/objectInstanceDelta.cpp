@@ -0,0 +1,151 @@
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <co/co.h>
+#include <co/memoryBudget.h>
+#include <lunchbox/rng.h>
+
+#include <iostream>
+
+// Tests that INSTANCE objects committing a few changed bytes are received
+// intact by their slaves as binary deltas, and that the slave node caches the
+// versions rebuilt from the deltas for later mappings
+
+#define NVERSIONS 8
+#define DATASIZE  ( 1024 * 1024 )
+
+namespace
+{
+class Object : public co::Object
+{
+public:
+    Object() : _data( DATASIZE ), _nChanges( 0 )
+    {
+        for( size_t i = 0; i < _data.size(); ++i )
+            _data[i] = uint8_t( i * 7 );
+    }
+
+    void change()
+    {
+        ++_nChanges;
+        _data[ ( _nChanges * 4099 ) % DATASIZE ] ^= 0xff;
+        setDirty();
+    }
+
+    bool operator == ( const Object& rhs ) const
+        { return _nChanges == rhs._nChanges && _data == rhs._data; }
+
+    uint32_t getNChanges() const { return _nChanges; }
+
+protected:
+    virtual ChangeType getChangeType() const { return INSTANCE; }
+
+    virtual void getInstanceData( co::DataOStream& os )
+        { os << _nChanges << _data; }
+
+    virtual void applyInstanceData( co::DataIStream& is )
+        { is >> _nChanges >> _data; }
+
+private:
+    std::vector< uint8_t > _data;
+    uint32_t _nChanges;
+};
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+    // the instance cache is only sampled with a budget
+    co::Global::setIAttribute( co::Global::IATTR_MEMORY_BUDGET, 1024 );
+
+    lunchbox::RNG rng;
+    co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->port = (rng.get<uint16_t>() % 60000) + 1024;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr server = new co::LocalNode;
+    server->addConnectionDescription( connDesc );
+    TEST( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( connDesc );
+
+    connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( connDesc );
+    TEST( client->listen( ));
+    TEST( client->connect( serverProxy ));
+
+    Object master;
+    TEST( client->registerObject( &master ));
+
+    Object slave;
+    TEST( server->mapObject( &slave, master.getID( )));
+    TEST( slave == master );
+
+    const co::MemoryBudget& budget = server->getMemoryBudget();
+    for( size_t i = 0; i < NVERSIONS; ++i )
+    {
+        master.change();
+        master.commit();
+        slave.sync( master.getVersion( ));
+        TESTINFO( slave == master, slave.getNChanges( ));
+    }
+
+    // the master retains the head version once, as chunks also used as the
+    // delta base
+    const co::MemoryBudget& masterBudget = client->getMemoryBudget();
+    TESTINFO( masterBudget.getSize( co::MemoryBudget::MASTER_HISTORY ) <
+              DATASIZE + DATASIZE / 2, masterBudget );
+
+    // the retained delta base is accounted
+    TESTINFO( budget.getSize( co::MemoryBudget::SLAVE_DATA ) >= DATASIZE,
+              budget );
+
+    // maps the head version from the cache, sampling the cache size
+    Object cached;
+    TEST( server->mapObject( &cached, master.getID(), master.getVersion( )));
+    TESTINFO( cached == master, cached.getNChanges( ));
+    TESTINFO( budget.getSize( co::MemoryBudget::INSTANCE_CACHE ) >
+              NVERSIONS * DATASIZE, budget );
+
+    server->unmapObject( &cached );
+    server->unmapObject( &slave );
+    client->deregisterObject( &master );
+    TESTINFO( budget.getSize( co::MemoryBudget::SLAVE_DATA ) == 0, budget );
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+
+    serverProxy->printHolders( std::cerr );
+    TESTINFO( serverProxy->getRefCount() == 1, serverProxy->getRefCount( ));
+    TESTINFO( client->getRefCount() == 1, client->getRefCount( ));
+    TESTINFO( server->getRefCount() == 1, server->getRefCount( ));
+
+    serverProxy = 0;
+    client      = 0;
+    server      = 0;
+
+    TEST( co::exit( ));
+    return EXIT_SUCCESS;
+}
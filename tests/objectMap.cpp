@@ -85,6 +85,175 @@ public:
     ObjectFactory factory;
     co::ObjectMap objectMap;
 };
+
+/** A server and a client node sharing an object map with a Foo and a Bar. */
+class Fixture
+{
+public:
+    Fixture()
+        : server( new TestNode )
+        , client( new TestNode )
+        , serverProxy( new co::Node )
+    {
+        lunchbox::RNG rng;
+        co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+        connDesc->type = co::CONNECTIONTYPE_TCPIP;
+        connDesc->port = (rng.get<uint16_t>() % 60000) + 1024;
+        connDesc->setHostname( "localhost" );
+
+        server->addConnectionDescription( connDesc );
+        TEST( server->listen( ));
+        serverProxy->addConnectionDescription( connDesc );
+
+        connDesc = new co::ConnectionDescription;
+        connDesc->type = co::CONNECTIONTYPE_TCPIP;
+        connDesc->setHostname( "localhost" );
+        client->addConnectionDescription( connDesc );
+        TEST( client->listen( ));
+        TEST( client->connect( serverProxy ));
+
+        TEST( server->registerObject( &server->objectMap ));
+        TEST( client->mapObject( &client->objectMap, &server->objectMap ));
+
+        masterFoo.message = "hello foo";
+        masterBar.message = "hello bar";
+        TEST( server->objectMap.register_( &masterFoo, TYPE_FOO ));
+        TEST( server->objectMap.register_( &masterBar, TYPE_BAR ));
+
+        client->objectMap.sync( server->objectMap.commit( ));
+        clientFoo = static_cast< Foo* >(
+                                client->objectMap.map( masterFoo.getID( )));
+        TEST( clientFoo->message == "hello foo" );
+        TEST( client->objectMap.map( masterBar.getID(),
+                                     &clientBar ) == &clientBar );
+        TEST( clientBar.message == "hello bar" );
+    }
+
+    ~Fixture()
+    {
+        TEST( server->objectMap.deregister( &masterBar ));
+        TEST( server->objectMap.deregister( &masterFoo ));
+
+        client->objectMap.clear();
+        client->unmapObject( &client->objectMap );
+        server->deregisterObject( &server->objectMap );
+        clientFoo = 0;
+
+        TEST( client->disconnect( serverProxy ));
+        TEST( client->close( ));
+        TEST( server->close( ));
+    }
+
+    lunchbox::RefPtr< TestNode > server;
+    lunchbox::RefPtr< TestNode > client;
+    co::NodePtr serverProxy;
+
+    Foo masterFoo;
+    Bar masterBar;
+    Bar clientBar;
+};
+
+void _testBatchedSync()
+{
+    Fixture fixture;
+    co::ObjectMap& objectMap = fixture.server->objectMap;
+
+    objectMap.setBatchedCommit( true );
+    TEST( objectMap.isBatchedCommit( ));
+    fixture.masterFoo.message = "batched foo";
+    fixture.masterBar.message = "batched bar";
+    fixture.client->objectMap.sync( objectMap.commit( ));
+    TEST( clientFoo->message == "batched foo" );
+    TEST( fixture.clientBar.message == "batched bar" );
+}
+
+void _testParallelCommit()
+{
+    Fixture fixture;
+    co::ObjectMap& objectMap = fixture.server->objectMap;
+
+    objectMap.setParallelCommit( true );
+    TEST( objectMap.isParallelCommit( ));
+    fixture.masterFoo.message = "parallel foo";
+    fixture.masterBar.message = "parallel bar";
+    fixture.client->objectMap.sync( objectMap.commit( ));
+    TEST( clientFoo->message == "parallel foo" );
+    TEST( fixture.clientBar.message == "parallel bar" );
+}
+
+void _testCommitNB()
+{
+    Fixture fixture;
+
+    fixture.masterFoo.message = "async foo";
+    const uint32_t request = fixture.masterFoo.commitNB();
+    clientFoo->sync( fixture.masterFoo.commitSync( request ));
+    TEST( clientFoo->message == "async foo" );
+}
+
+void _testBulkSync()
+{
+    Fixture fixture;
+
+    fixture.masterFoo.message = "bulk foo";
+    fixture.masterBar.message = "bulk bar";
+    co::ObjectVersions versions;
+    versions.push_back( co::ObjectVersion( fixture.masterFoo.getID(),
+                                           fixture.masterFoo.commit( )));
+    versions.push_back( co::ObjectVersion( fixture.masterBar.getID(),
+                                           fixture.masterBar.commit( )));
+
+    co::Objects objects;
+    objects.push_back( clientFoo );
+    objects.push_back( &fixture.clientBar );
+    co::sync( objects, versions );
+    TEST( clientFoo->message == "bulk foo" );
+    TEST( fixture.clientBar.message == "bulk bar" );
+}
+
+void _testConcurrentMap()
+{
+    Fixture fixture;
+    const co::UUID& id = fixture.masterFoo.getID();
+
+    // concurrent requests are coalesced by the master
+    Foo foos[ 3 ];
+    uint32_t requests[ 3 ];
+    for( size_t i = 0; i < 3; ++i )
+        requests[i] = fixture.client->mapObjectNB( &foos[i], id );
+    for( size_t i = 0; i < 3; ++i )
+    {
+        TEST( fixture.client->mapObjectSync( requests[i] ));
+        TEST( foos[i].message == "hello foo" );
+        fixture.client->unmapObject( &foos[i] );
+    }
+}
+
+void _testBatchedMap()
+{
+    Fixture fixture;
+
+    // the unknown object fails without affecting the others
+    Foo foos[ 3 ];
+    co::Objects objects;
+    co::ObjectVersions versions;
+    for( size_t i = 0; i < 3; ++i )
+    {
+        objects.push_back( &foos[i] );
+        versions.push_back( co::ObjectVersion( i == 2 ? co::UUID( true ) :
+                                               fixture.masterFoo.getID(),
+                                               co::VERSION_OLDEST ));
+    }
+    TEST( !fixture.client->mapObjectsSync(
+              fixture.client->mapObjectsNB( objects, versions )));
+    TEST( !foos[2].isAttached( ));
+    for( size_t i = 0; i < 2; ++i )
+    {
+        TEST( foos[i].isAttached( ));
+        TEST( foos[i].message == "hello foo" );
+        fixture.client->unmapObject( &foos[i] );
+    }
+}
 }
 
 int main( int argc, char **argv )
@@ -176,6 +345,13 @@ int main( int argc, char **argv )
     serverProxy = 0;
     server      = 0;
 
+    _testBatchedSync();
+    _testParallelCommit();
+    _testCommitNB();
+    _testBulkSync();
+    _testConcurrentMap();
+    _testBatchedMap();
+
     co::exit();
     return EXIT_SUCCESS;
 }
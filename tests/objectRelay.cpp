@@ -0,0 +1,148 @@
+
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <co/connectionDescription.h>
+#include <co/dataIStream.h>
+#include <co/dataOStream.h>
+#include <co/global.h>
+#include <co/init.h>
+#include <co/localNode.h>
+#include <co/memoryBudget.h>
+#include <co/node.h>
+#include <co/object.h>
+#include <lunchbox/rng.h>
+
+// Tests commits relayed through a tree of slave nodes, the slave acks
+// forwarded up the tree, and a slave unmapped while commits are relayed
+
+#define NSLAVES 5
+#define NCOMMITS 20
+
+namespace
+{
+class Object : public co::Object
+{
+public:
+    Object() : value( 0 ) {}
+
+    void set( const uint32_t newValue ) { value = newValue; setDirty( 1 ); }
+
+    uint32_t value;
+
+protected:
+    virtual ChangeType getChangeType() const { return DELTA; }
+
+    // the master blocks unless the relayed slaves' acks reach it
+    virtual uint64_t getMaxVersions() const { return 1; }
+
+    virtual void getInstanceData( co::DataOStream& os ) { os << value; }
+    virtual void applyInstanceData( co::DataIStream& is ) { is >> value; }
+    virtual void pack( co::DataOStream& os ) { os << value; }
+    virtual void unpack( co::DataIStream& is ) { is >> value; }
+};
+}
+
+int main( int argc, char **argv )
+{
+    co::init( argc, argv );
+    co::Global::setIAttribute( co::Global::IATTR_OBJECT_RELAY_FANOUT, 2 );
+
+    lunchbox::RNG rng;
+    const uint16_t port = (rng.get<uint16_t>() % 60000) + 1024;
+
+    co::LocalNodePtr server = new co::LocalNode;
+    co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->port = port;
+    connDesc->setHostname( "localhost" );
+    server->addConnectionDescription( connDesc );
+    TEST( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( connDesc );
+
+    Object master;
+    TEST( server->registerObject( &master ));
+
+    co::LocalNodePtr clients[ NSLAVES ];
+    Object slaves[ NSLAVES ];
+    for( size_t i = 0; i < NSLAVES; ++i )
+    {
+        connDesc = new co::ConnectionDescription;
+        connDesc->type = co::CONNECTIONTYPE_TCPIP;
+        connDesc->setHostname( "localhost" );
+
+        clients[i] = new co::LocalNode;
+        clients[i]->addConnectionDescription( connDesc );
+        TEST( clients[i]->listen( ));
+        TEST( clients[i]->connect( serverProxy ));
+        TEST( clients[i]->mapObject( &slaves[i], master.getID( )));
+    }
+
+    for( uint32_t i = 1; i <= NCOMMITS; ++i )
+    {
+        master.set( i );
+        const co::uint128_t version = master.commit();
+
+        for( size_t j = 0; j < NSLAVES; ++j )
+        {
+            slaves[j].sync( version );
+            TESTINFO( slaves[j].value == i, slaves[j].value << " != " << i );
+        }
+    }
+
+    // unmap a slave while a commit may still be relayed to its node
+    master.set( NCOMMITS + 1 );
+    const uint32_t request = master.commitNB();
+    clients[0]->unmapObject( &slaves[0] );
+    slaves[1].sync( master.commitSync( request ));
+
+    for( uint32_t i = NCOMMITS + 2; i <= 2 * NCOMMITS; ++i )
+    {
+        master.set( i );
+        const co::uint128_t version = master.commit();
+
+        for( size_t j = 1; j < NSLAVES; ++j )
+        {
+            slaves[j].sync( version );
+            TESTINFO( slaves[j].value == i, slaves[j].value << " != " << i );
+        }
+    }
+
+    const co::MemoryBudget& budget = clients[0]->getMemoryBudget();
+    TESTINFO( budget.getSize( co::MemoryBudget::PENDING_COMMANDS ) == 0,
+              budget );
+
+    for( size_t i = 0; i < NSLAVES; ++i )
+    {
+        if( i > 0 )
+            clients[i]->unmapObject( &slaves[i] );
+        TEST( clients[i]->disconnect( serverProxy ));
+        TEST( clients[i]->close( ));
+        clients[i] = 0;
+    }
+    server->deregisterObject( &master );
+    TEST( server->close( ));
+
+    serverProxy = 0;
+    server = 0;
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
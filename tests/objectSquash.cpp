@@ -0,0 +1,160 @@
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <co/co.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/rng.h>
+#include <lunchbox/sleep.h>
+
+#include <algorithm>
+#include <iostream>
+
+// Tests that a lagging INSTANCE slave applies only the newest of the versions
+// received before it syncs
+
+#define NVERSIONS 10
+#define NVALUES   1024
+
+namespace
+{
+class Object : public co::Object
+{
+public:
+    Object() : _values( NVALUES ), _value( 0 ), _nApplied( 0 ) {}
+
+    void setValue( const uint32_t value )
+    {
+        // changes all bytes, for full versions instead of binary deltas
+        _value = value * 0x01010101u;
+        std::fill( _values.begin(), _values.end(), _value );
+        setDirty();
+    }
+
+    uint32_t getValue() const { return _value; }
+    size_t getNApplied() const { return _nApplied; }
+
+protected:
+    virtual ChangeType getChangeType() const { return INSTANCE; }
+
+    virtual void getInstanceData( co::DataOStream& os )
+        { os << _value << _values; }
+
+    virtual void applyInstanceData( co::DataIStream& is )
+    {
+        is >> _value >> _values;
+        for( size_t i = 0; i < _values.size(); ++i )
+            TESTINFO( _values[i] == _value, _values[i] << " != " << _value );
+        ++_nApplied;
+    }
+
+private:
+    std::vector< uint32_t > _values;
+    uint32_t _value;
+    size_t _nApplied;
+};
+
+void _commit( Object& master, Object& slave, const uint32_t first )
+{
+    for( uint32_t i = first; i < first + NVERSIONS; ++i )
+    {
+        master.setValue( i );
+        master.commit();
+    }
+
+    // wait until the slave has received all versions
+    lunchbox::Clock clock;
+    while( slave.getHeadVersion() < master.getVersion( ))
+    {
+        TESTINFO( clock.getTime64() < 10000, slave.getHeadVersion( ));
+        lunchbox::sleep( 1 );
+    }
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+    lunchbox::RNG rng;
+    co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->port = (rng.get<uint16_t>() % 60000) + 1024;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr server = new co::LocalNode;
+    server->addConnectionDescription( connDesc );
+    TEST( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( connDesc );
+
+    connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( connDesc );
+    TEST( client->listen( ));
+    TEST( client->connect( serverProxy ));
+
+    Object master;
+    TEST( client->registerObject( &master ));
+
+    Object slave;
+    TEST( server->mapObject( &slave, master.getID( )));
+    TESTINFO( slave.getNApplied() == 1, slave.getNApplied( ));
+
+    // sync to head
+    _commit( master, slave, 1 );
+    slave.sync();
+    TESTINFO( slave.getVersion() == master.getVersion(), slave.getVersion( ));
+    TESTINFO( slave.getValue() == master.getValue(), slave.getValue( ));
+    TESTINFO( slave.getNApplied() == 2, slave.getNApplied( ));
+
+    // sync to a version in the middle, leaving the newer versions queued
+    _commit( master, slave, NVERSIONS + 1 );
+    const co::uint128_t middle = slave.getVersion() + NVERSIONS / 2;
+    slave.sync( middle );
+    TESTINFO( slave.getVersion() == middle, slave.getVersion( ));
+    TESTINFO( slave.getValue() == ( NVERSIONS + NVERSIONS / 2 ) * 0x01010101u,
+              slave.getValue( ));
+    TESTINFO( slave.getNApplied() == 3, slave.getNApplied( ));
+
+    slave.sync();
+    TESTINFO( slave.getValue() == master.getValue(), slave.getValue( ));
+    TESTINFO( slave.getNApplied() == 4, slave.getNApplied( ));
+
+    server->unmapObject( &slave );
+    client->deregisterObject( &master );
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+
+    serverProxy->printHolders( std::cerr );
+    TESTINFO( serverProxy->getRefCount() == 1, serverProxy->getRefCount( ));
+    TESTINFO( client->getRefCount() == 1, client->getRefCount( ));
+    TESTINFO( server->getRefCount() == 1, server->getRefCount( ));
+
+    serverProxy = 0;
+    client      = 0;
+    server      = 0;
+
+    TEST( co::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+/* Copyright (c) 2026, Collage contributors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <co/co.h>
+#include <lunchbox/monitor.h>
+#include <lunchbox/rng.h>
+
+#include <boost/bind.hpp>
+#include <iostream>
+
+// Tests that object commands received before their object is attached are kept
+// pending per object and dispatched in order once the object is attached
+
+#define NOBJECTS  8
+#define NCOMMANDS 100
+
+namespace
+{
+const co::uint128_t syncID( lunchbox::make_uint128( "pendingCommandsSync" ));
+lunchbox::Monitor< bool > _synced( false );
+lunchbox::Monitor< uint32_t > _nReceived( 0 );
+
+bool _cmdSync( co::CustomICommand& )
+{
+    _synced = true;
+    return true;
+}
+
+class Object : public co::Object
+{
+public:
+    Object() : _next( 0 ) {}
+
+    virtual void attach( const co::UUID& id, const uint32_t instanceID )
+    {
+        co::Object::attach( id, instanceID );
+        registerCommand( co::CMD_OBJECT_CUSTOM,
+                         co::CommandFunc< Object >( this, &Object::_cmdCustom ),
+                         0 );
+    }
+
+    uint32_t getNext() const { return _next; }
+
+private:
+    uint32_t _next;
+
+    bool _cmdCustom( co::ICommand& cmd )
+    {
+        co::ObjectICommand command( cmd );
+        const uint32_t sequence = command.get< uint32_t >();
+
+        TESTINFO( sequence == _next, sequence << " != " << _next );
+        ++_next;
+        ++_nReceived;
+        return true;
+    }
+};
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+    lunchbox::RNG rng;
+    co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->port = (rng.get<uint16_t>() % 60000) + 1024;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr server = new co::LocalNode;
+    server->addConnectionDescription( connDesc );
+    TEST( server->listen( ));
+    server->registerCommandHandler( syncID, boost::bind( &_cmdSync, _1 ), 0 );
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( connDesc );
+
+    connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( connDesc );
+    TEST( client->listen( ));
+    TEST( client->connect( serverProxy ));
+
+    // interleave the command streams of all not yet registered objects
+    Object masters[ NOBJECTS ];
+    const co::Connections connections( 1, serverProxy->getConnection( ));
+    for( uint32_t i = 0; i < NCOMMANDS; ++i )
+        for( size_t j = 0; j < NOBJECTS; ++j )
+            co::ObjectOCommand( connections, co::CMD_OBJECT_CUSTOM,
+                                co::COMMANDTYPE_OBJECT, masters[j].getID(),
+                                EQ_INSTANCE_ALL ) << i;
+
+    // the receiver thread has pended all object commands once it got this
+    serverProxy->send( syncID );
+    TEST( _synced.timedWaitEQ( true, 10000 ));
+    TEST( _nReceived == 0 );
+
+    // attach in reverse order to decouple from the receive order
+    for( size_t i = NOBJECTS; i > 0; --i )
+        TEST( server->registerObject( &masters[ i - 1 ] ));
+
+    TESTINFO( _nReceived.timedWaitEQ( NOBJECTS * NCOMMANDS, 10000 ),
+              _nReceived.get( ));
+    for( size_t i = 0; i < NOBJECTS; ++i )
+    {
+        TESTINFO( masters[i].getNext() == NCOMMANDS, masters[i].getNext( ));
+        server->deregisterObject( &masters[i] );
+    }
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+
+    serverProxy->printHolders( std::cerr );
+    TESTINFO( serverProxy->getRefCount() == 1, serverProxy->getRefCount( ));
+    TESTINFO( client->getRefCount() == 1, client->getRefCount( ));
+    TESTINFO( server->getRefCount() == 1, server->getRefCount( ));
+
+    serverProxy = 0;
+    client      = 0;
+    server      = 0;
+
+    TEST( co::exit( ));
+    return EXIT_SUCCESS;
+}